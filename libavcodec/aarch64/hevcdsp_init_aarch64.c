@@ -0,0 +1,396 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/aarch64/cpu.h"
+#include "libavcodec/avcodec.h"
+#include "libavcodec/hevc.h"
+#include "libavcodec/hevcdsp.h"
+
+#include "config.h"
+
+void ff_hevc_v_loop_filter_luma_neon(uint8_t *pix, ptrdiff_t stride, int beta,
+                                     int *tc, uint8_t *no_p, uint8_t *no_q);
+void ff_hevc_h_loop_filter_luma_neon(uint8_t *pix, ptrdiff_t stride, int beta,
+                                     int *tc, uint8_t *no_p, uint8_t *no_q);
+void ff_hevc_v_loop_filter_chroma_neon(uint8_t *pix, ptrdiff_t stride, int *tc,
+                                       uint8_t *no_p, uint8_t *no_q);
+void ff_hevc_h_loop_filter_chroma_neon(uint8_t *pix, ptrdiff_t stride, int *tc,
+                                       uint8_t *no_p, uint8_t *no_q);
+void ff_hevc_deblocking_bs_neon(uint8_t *bs, ptrdiff_t stride, const DeblockMotion *p,
+                                const DeblockMotion *q, int n);
+void ff_hevc_transform_4x4_neon_8(int16_t *coeffs, int col_limit);
+void ff_hevc_transform_8x8_neon_8(int16_t *coeffs, int col_limit);
+void ff_hevc_transform_16x16_neon_8(int16_t *coeffs, int col_limit);
+void ff_hevc_transform_32x32_neon_8(int16_t *coeffs, int col_limit);
+void ff_hevc_idct_4x4_dc_neon_8(int16_t *coeffs);
+void ff_hevc_idct_8x8_dc_neon_8(int16_t *coeffs);
+void ff_hevc_idct_16x16_dc_neon_8(int16_t *coeffs);
+void ff_hevc_idct_32x32_dc_neon_8(int16_t *coeffs);
+void ff_hevc_transform_luma_4x4_neon_8(int16_t *coeffs);
+void ff_hevc_transform_skip_neon_8(int16_t *coeffs, int16_t log2_size);
+void ff_hevc_transform_rdpcm_neon_8(int16_t *coeffs, int16_t log2_size, int mode);
+void ff_hevc_transform_add_4x4_neon_8(uint8_t *dst, int16_t *coeffs,
+                                      ptrdiff_t stride);
+void ff_hevc_transform_add_8x8_neon_8(uint8_t *dst, int16_t *coeffs,
+                                      ptrdiff_t stride);
+void ff_hevc_transform_add_16x16_neon_8(uint8_t *dst, int16_t *coeffs,
+                                        ptrdiff_t stride);
+void ff_hevc_transform_add_32x32_neon_8(uint8_t *dst, int16_t *coeffs,
+                                        ptrdiff_t stride);
+void ff_hevc_sao_band_filter_neon_8(uint8_t *dst, uint8_t *src,
+                                    ptrdiff_t stride_dst, ptrdiff_t stride_src,
+                                    const int8_t *offset_table, int width, int height);
+void ff_hevc_sao_band_filter_neon_10(uint8_t *dst, uint8_t *src,
+                                     ptrdiff_t stride_dst, ptrdiff_t stride_src,
+                                     const int8_t *offset_table, int width, int height);
+void ff_hevc_sao_edge_filter_neon_8(uint8_t *dst, uint8_t *src, ptrdiff_t stride_dst,
+                                    const int8_t *offset_table, int a_off, int b_off,
+                                    int width, int height);
+void ff_hevc_sao_edge_filter_neon_10(uint8_t *dst, uint8_t *src, ptrdiff_t stride_dst,
+                                     const int8_t *offset_table, int a_off, int b_off,
+                                     int width, int height);
+
+#define MC_FUNC(type, in, out)                                                                   \
+    void ff_hevc_put_ ## type ## _ ## in ## _ ## out ## _neon_8(uint8_t *dst, ptrdiff_t dststride, \
+                                                        const uint8_t *src, ptrdiff_t srcstride, \
+                                                        int height, int width,                   \
+                                                        const int8_t *filter,                    \
+                                                        const int16_t *src2, const int32_t *wp)
+#define MC_FUNCS(type)              \
+    MC_FUNC(type, h,  put);         \
+    MC_FUNC(type, h,  uni);         \
+    MC_FUNC(type, h,  bi);          \
+    MC_FUNC(type, h,  uni_w);       \
+    MC_FUNC(type, h,  bi_w);        \
+    MC_FUNC(type, v,  put);         \
+    MC_FUNC(type, v,  uni);         \
+    MC_FUNC(type, v,  bi);          \
+    MC_FUNC(type, v,  uni_w);       \
+    MC_FUNC(type, v,  bi_w);        \
+    MC_FUNC(type, hv, put);         \
+    MC_FUNC(type, hv, uni);         \
+    MC_FUNC(type, hv, bi);          \
+    MC_FUNC(type, hv, uni_w);       \
+    MC_FUNC(type, hv, bi_w)
+MC_FUNCS(epel);
+MC_FUNCS(qpel);
+MC_FUNC(pel, pixels, put);
+MC_FUNC(pel, pixels, bi);
+MC_FUNC(pel, pixels, uni_w);
+MC_FUNC(pel, pixels, bi_w);
+#undef MC_FUNCS
+#undef MC_FUNC
+
+/* All the motion compensation kernels share one prototype (see
+ * hevcdsp_mc_neon.S) and only differ in the number of taps, so one set of
+ * wrappers serves epel and qpel. The hv case runs the h kernel into a
+ * temporary first, like the C template; the full-pel cases use the pel
+ * kernels for both. */
+#define MC_EXTRA_BEFORE_epel EPEL_EXTRA_BEFORE
+#define MC_EXTRA_BEFORE_qpel QPEL_EXTRA_BEFORE
+#define MC_EXTRA_epel        EPEL_EXTRA
+#define MC_EXTRA_qpel        QPEL_EXTRA
+#define MC_FILTERS_epel      ff_hevc_epel_filters
+#define MC_FILTERS_qpel      ff_hevc_qpel_filters
+
+#define MC_DECL_pixels(type)
+#define MC_DECL_h(type)
+#define MC_DECL_v(type)
+#define MC_DECL_hv(type)                                                            \
+    int16_t tmp[(MAX_PB_SIZE + MC_EXTRA_ ## type) * MAX_PB_SIZE];
+#define MC_PREP_pixels(type)
+#define MC_PREP_h(type)
+#define MC_PREP_v(type)
+#define MC_PREP_hv(type)                                                            \
+    ff_hevc_put_ ## type ## _h_put_neon_8((uint8_t *)tmp,                           \
+                                          MAX_PB_SIZE * sizeof(int16_t),            \
+                                          src - MC_EXTRA_BEFORE_ ## type * srcstride, \
+                                          srcstride, height + MC_EXTRA_ ## type,    \
+                                          width, MC_FILTERS_ ## type[mx - 1],       \
+                                          NULL, NULL);                              \
+    src       = (uint8_t *)tmp;                                                     \
+    srcstride = MAX_PB_SIZE * sizeof(int16_t);
+#define MC_TAPS_pixels(type) NULL
+#define MC_TAPS_h(type)      MC_FILTERS_ ## type[mx - 1]
+#define MC_TAPS_v(type)      MC_FILTERS_ ## type[my - 1]
+#define MC_TAPS_hv(type)     MC_FILTERS_ ## type[my - 1]
+
+#define MC_WRAPPER_PUT(type, in)                                                    \
+static void hevc_put_ ## type ## _ ## in ## _neon_8(int16_t *dst, uint8_t *src,     \
+                                                    ptrdiff_t srcstride,            \
+                                                    int height, intptr_t mx,        \
+                                                    intptr_t my, int width)         \
+{                                                                                   \
+    MC_DECL_ ## in(type)                                                            \
+    MC_PREP_ ## in(type)                                                            \
+    ff_hevc_put_ ## type ## _ ## in ## _put_neon_8((uint8_t *)dst,                  \
+                                                   MAX_PB_SIZE * sizeof(int16_t),   \
+                                                   src, srcstride, height, width,   \
+                                                   MC_TAPS_ ## in(type),            \
+                                                   NULL, NULL);                     \
+}
+
+#define MC_WRAPPER_UNI(type, in)                                                    \
+static void hevc_put_ ## type ## _uni_ ## in ## _neon_8(uint8_t *dst,               \
+                                                        ptrdiff_t dststride,        \
+                                                        uint8_t *src,               \
+                                                        ptrdiff_t srcstride,        \
+                                                        int height, intptr_t mx,    \
+                                                        intptr_t my, int width)     \
+{                                                                                   \
+    MC_DECL_ ## in(type)                                                            \
+    MC_PREP_ ## in(type)                                                            \
+    ff_hevc_put_ ## type ## _ ## in ## _uni_neon_8(dst, dststride, src, srcstride,  \
+                                                   height, width,                   \
+                                                   MC_TAPS_ ## in(type),            \
+                                                   NULL, NULL);                     \
+}
+
+#define MC_WRAPPER_BI(type, in)                                                     \
+static void hevc_put_ ## type ## _bi_ ## in ## _neon_8(uint8_t *dst,                \
+                                                       ptrdiff_t dststride,         \
+                                                       uint8_t *src,                \
+                                                       ptrdiff_t srcstride,         \
+                                                       int16_t *src2, int height,   \
+                                                       intptr_t mx, intptr_t my,    \
+                                                       int width)                   \
+{                                                                                   \
+    MC_DECL_ ## in(type)                                                            \
+    MC_PREP_ ## in(type)                                                            \
+    ff_hevc_put_ ## type ## _ ## in ## _bi_neon_8(dst, dststride, src, srcstride,   \
+                                                  height, width,                    \
+                                                  MC_TAPS_ ## in(type),             \
+                                                  src2, NULL);                      \
+}
+
+#define MC_WRAPPER_UNI_W(type, in)                                                  \
+static void hevc_put_ ## type ## _uni_w_ ## in ## _neon_8(uint8_t *dst,             \
+                                                          ptrdiff_t dststride,      \
+                                                          uint8_t *src,             \
+                                                          ptrdiff_t srcstride,      \
+                                                          int height, int denom,    \
+                                                          int wx, int ox,           \
+                                                          intptr_t mx, intptr_t my, \
+                                                          int width)                \
+{                                                                                   \
+    int shift = denom + 14 - 8;                                                     \
+    int32_t wp[5] = { wx, 0, 1 << (shift - 1), -shift, ox };                        \
+    MC_DECL_ ## in(type)                                                            \
+    MC_PREP_ ## in(type)                                                            \
+    ff_hevc_put_ ## type ## _ ## in ## _uni_w_neon_8(dst, dststride, src, srcstride,\
+                                                     height, width,                 \
+                                                     MC_TAPS_ ## in(type),          \
+                                                     NULL, wp);                     \
+}
+
+#define MC_WRAPPER_BI_W(type, in)                                                   \
+static void hevc_put_ ## type ## _bi_w_ ## in ## _neon_8(uint8_t *dst,              \
+                                                         ptrdiff_t dststride,       \
+                                                         uint8_t *src,              \
+                                                         ptrdiff_t srcstride,       \
+                                                         int16_t *src2, int height, \
+                                                         int denom, int wx0,        \
+                                                         int wx1, int ox0, int ox1, \
+                                                         intptr_t mx, intptr_t my,  \
+                                                         int width)                 \
+{                                                                                   \
+    int log2Wd = denom + 14 + 1 - 8 - 1;                                            \
+    int32_t wp[5] = { wx1, wx0, (ox0 + ox1 + 1) << log2Wd, -(log2Wd + 1), 0 };      \
+    MC_DECL_ ## in(type)                                                            \
+    MC_PREP_ ## in(type)                                                            \
+    ff_hevc_put_ ## type ## _ ## in ## _bi_w_neon_8(dst, dststride, src, srcstride, \
+                                                    height, width,                  \
+                                                    MC_TAPS_ ## in(type),           \
+                                                    src2, wp);                      \
+}
+
+#define MC_WRAPPERS(type)                                                           \
+    MC_WRAPPER_PUT(type, h)                                                         \
+    MC_WRAPPER_PUT(type, v)                                                         \
+    MC_WRAPPER_PUT(type, hv)                                                        \
+    MC_WRAPPER_UNI(type, h)                                                         \
+    MC_WRAPPER_UNI(type, v)                                                         \
+    MC_WRAPPER_UNI(type, hv)                                                        \
+    MC_WRAPPER_BI(type, h)                                                          \
+    MC_WRAPPER_BI(type, v)                                                          \
+    MC_WRAPPER_BI(type, hv)                                                         \
+    MC_WRAPPER_UNI_W(type, h)                                                       \
+    MC_WRAPPER_UNI_W(type, v)                                                       \
+    MC_WRAPPER_UNI_W(type, hv)                                                      \
+    MC_WRAPPER_BI_W(type, h)                                                        \
+    MC_WRAPPER_BI_W(type, v)                                                        \
+    MC_WRAPPER_BI_W(type, hv)
+
+MC_WRAPPERS(epel)
+MC_WRAPPERS(qpel)
+MC_WRAPPER_PUT(pel, pixels)
+MC_WRAPPER_BI(pel, pixels)
+MC_WRAPPER_UNI_W(pel, pixels)
+MC_WRAPPER_BI_W(pel, pixels)
+
+/* The NEON SAO filters work on byte lookup tables; offsets fit in int8_t
+ * for bit depths up to 10. */
+static void sao_band_table(int8_t *offset_table, const int16_t *sao_offset_val,
+                           int sao_left_class)
+{
+    int k;
+
+    memset(offset_table, 0, 32);
+    for (k = 0; k < 4; k++)
+        offset_table[(k + sao_left_class) & 31] = sao_offset_val[k + 1];
+}
+
+static void sao_edge_table(int8_t *offset_table, int *a_off, int *b_off,
+                           const int16_t *sao_offset_val, int eo, int pixel_shift)
+{
+    static const uint8_t edge_idx[] = { 1, 2, 0, 3, 4 };
+    static const int8_t pos[4][2][2] = {
+        { { -1,  0 }, {  1, 0 } }, // horizontal
+        { {  0, -1 }, {  0, 1 } }, // vertical
+        { { -1, -1 }, {  1, 1 } }, // 45 degree
+        { {  1, -1 }, { -1, 1 } }, // 135 degree
+    };
+    const int stride_src = 2 * MAX_PB_SIZE + FF_INPUT_BUFFER_PADDING_SIZE;
+    int k;
+
+    for (k = 0; k < 5; k++)
+        offset_table[k] = sao_offset_val[edge_idx[k]];
+    *a_off = pos[eo][0][0] * (1 << pixel_shift) + pos[eo][0][1] * stride_src;
+    *b_off = pos[eo][1][0] * (1 << pixel_shift) + pos[eo][1][1] * stride_src;
+}
+
+#define SAO_FUNCS(depth, pixel_shift)                                               \
+static void hevc_sao_band_filter_neon_ ## depth(uint8_t *dst, uint8_t *src,         \
+                                                ptrdiff_t stride_dst,               \
+                                                ptrdiff_t stride_src,               \
+                                                int16_t *sao_offset_val,            \
+                                                int sao_left_class,                 \
+                                                int width, int height)              \
+{                                                                                   \
+    int8_t offset_table[32];                                                        \
+                                                                                    \
+    sao_band_table(offset_table, sao_offset_val, sao_left_class);                   \
+    ff_hevc_sao_band_filter_neon_ ## depth(dst, src, stride_dst, stride_src,        \
+                                           offset_table, width, height);            \
+}                                                                                   \
+                                                                                    \
+static void hevc_sao_edge_filter_neon_ ## depth(uint8_t *dst, uint8_t *src,         \
+                                                ptrdiff_t stride_dst,               \
+                                                int16_t *sao_offset_val,            \
+                                                int eo, int width, int height)      \
+{                                                                                   \
+    int8_t offset_table[8];                                                         \
+    int a_off, b_off;                                                               \
+                                                                                    \
+    sao_edge_table(offset_table, &a_off, &b_off, sao_offset_val, eo, pixel_shift);  \
+    ff_hevc_sao_edge_filter_neon_ ## depth(dst, src, stride_dst, offset_table,      \
+                                           a_off, b_off, width, height);            \
+}
+
+SAO_FUNCS(8,  0)
+SAO_FUNCS(10, 1)
+
+av_cold void ff_hevcdsp_init_aarch64(HEVCDSPContext *c, const int bit_depth)
+{
+    int cpu_flags = av_get_cpu_flags();
+    int x;
+
+    if (!have_neon(cpu_flags))
+        return;
+
+    c->deblocking_bs = ff_hevc_deblocking_bs_neon;
+
+    if (bit_depth == 8) {
+        c->hevc_v_loop_filter_luma     = ff_hevc_v_loop_filter_luma_neon;
+        c->hevc_h_loop_filter_luma     = ff_hevc_h_loop_filter_luma_neon;
+        c->hevc_v_loop_filter_chroma   = ff_hevc_v_loop_filter_chroma_neon;
+        c->hevc_h_loop_filter_chroma   = ff_hevc_h_loop_filter_chroma_neon;
+        c->idct[0]                     = ff_hevc_transform_4x4_neon_8;
+        c->idct[1]                     = ff_hevc_transform_8x8_neon_8;
+        c->idct[2]                     = ff_hevc_transform_16x16_neon_8;
+        c->idct[3]                     = ff_hevc_transform_32x32_neon_8;
+        c->idct_dc[0]                  = ff_hevc_idct_4x4_dc_neon_8;
+        c->idct_dc[1]                  = ff_hevc_idct_8x8_dc_neon_8;
+        c->idct_dc[2]                  = ff_hevc_idct_16x16_dc_neon_8;
+        c->idct_dc[3]                  = ff_hevc_idct_32x32_dc_neon_8;
+        c->transform_add[0]            = ff_hevc_transform_add_4x4_neon_8;
+        c->transform_add[1]            = ff_hevc_transform_add_8x8_neon_8;
+        c->transform_add[2]            = ff_hevc_transform_add_16x16_neon_8;
+        c->transform_add[3]            = ff_hevc_transform_add_32x32_neon_8;
+        c->idct_4x4_luma               = ff_hevc_transform_luma_4x4_neon_8;
+        c->transform_skip              = ff_hevc_transform_skip_neon_8;
+        c->transform_rdpcm             = ff_hevc_transform_rdpcm_neon_8;
+
+        for (x = 0; x < 10; x++) {
+            c->put_hevc_qpel[x][0][0]         = hevc_put_pel_pixels_neon_8;
+            c->put_hevc_qpel[x][0][1]         = hevc_put_qpel_h_neon_8;
+            c->put_hevc_qpel[x][1][0]         = hevc_put_qpel_v_neon_8;
+            c->put_hevc_qpel[x][1][1]         = hevc_put_qpel_hv_neon_8;
+            c->put_hevc_qpel_uni[x][0][1]     = hevc_put_qpel_uni_h_neon_8;
+            c->put_hevc_qpel_uni[x][1][0]     = hevc_put_qpel_uni_v_neon_8;
+            c->put_hevc_qpel_uni[x][1][1]     = hevc_put_qpel_uni_hv_neon_8;
+            c->put_hevc_qpel_bi[x][0][0]      = hevc_put_pel_bi_pixels_neon_8;
+            c->put_hevc_qpel_bi[x][0][1]      = hevc_put_qpel_bi_h_neon_8;
+            c->put_hevc_qpel_bi[x][1][0]      = hevc_put_qpel_bi_v_neon_8;
+            c->put_hevc_qpel_bi[x][1][1]      = hevc_put_qpel_bi_hv_neon_8;
+            c->put_hevc_qpel_uni_w[x][0][0]   = hevc_put_pel_uni_w_pixels_neon_8;
+            c->put_hevc_qpel_uni_w[x][0][1]   = hevc_put_qpel_uni_w_h_neon_8;
+            c->put_hevc_qpel_uni_w[x][1][0]   = hevc_put_qpel_uni_w_v_neon_8;
+            c->put_hevc_qpel_uni_w[x][1][1]   = hevc_put_qpel_uni_w_hv_neon_8;
+            c->put_hevc_qpel_bi_w[x][0][0]    = hevc_put_pel_bi_w_pixels_neon_8;
+            c->put_hevc_qpel_bi_w[x][0][1]    = hevc_put_qpel_bi_w_h_neon_8;
+            c->put_hevc_qpel_bi_w[x][1][0]    = hevc_put_qpel_bi_w_v_neon_8;
+            c->put_hevc_qpel_bi_w[x][1][1]    = hevc_put_qpel_bi_w_hv_neon_8;
+
+            c->put_hevc_epel[x][0][0]         = hevc_put_pel_pixels_neon_8;
+            c->put_hevc_epel[x][0][1]         = hevc_put_epel_h_neon_8;
+            c->put_hevc_epel[x][1][0]         = hevc_put_epel_v_neon_8;
+            c->put_hevc_epel[x][1][1]         = hevc_put_epel_hv_neon_8;
+            c->put_hevc_epel_uni[x][0][1]     = hevc_put_epel_uni_h_neon_8;
+            c->put_hevc_epel_uni[x][1][0]     = hevc_put_epel_uni_v_neon_8;
+            c->put_hevc_epel_uni[x][1][1]     = hevc_put_epel_uni_hv_neon_8;
+            c->put_hevc_epel_bi[x][0][0]      = hevc_put_pel_bi_pixels_neon_8;
+            c->put_hevc_epel_bi[x][0][1]      = hevc_put_epel_bi_h_neon_8;
+            c->put_hevc_epel_bi[x][1][0]      = hevc_put_epel_bi_v_neon_8;
+            c->put_hevc_epel_bi[x][1][1]      = hevc_put_epel_bi_hv_neon_8;
+            c->put_hevc_epel_uni_w[x][0][0]   = hevc_put_pel_uni_w_pixels_neon_8;
+            c->put_hevc_epel_uni_w[x][0][1]   = hevc_put_epel_uni_w_h_neon_8;
+            c->put_hevc_epel_uni_w[x][1][0]   = hevc_put_epel_uni_w_v_neon_8;
+            c->put_hevc_epel_uni_w[x][1][1]   = hevc_put_epel_uni_w_hv_neon_8;
+            c->put_hevc_epel_bi_w[x][0][0]    = hevc_put_pel_bi_w_pixels_neon_8;
+            c->put_hevc_epel_bi_w[x][0][1]    = hevc_put_epel_bi_w_h_neon_8;
+            c->put_hevc_epel_bi_w[x][1][0]    = hevc_put_epel_bi_w_v_neon_8;
+            c->put_hevc_epel_bi_w[x][1][1]    = hevc_put_epel_bi_w_hv_neon_8;
+        }
+
+        for (x = 0; x < 5; x++) {
+            c->sao_band_filter[x]      = hevc_sao_band_filter_neon_8;
+            c->sao_edge_filter[x]      = hevc_sao_edge_filter_neon_8;
+        }
+    } else if (bit_depth == 10) {
+        for (x = 0; x < 5; x++) {
+            c->sao_band_filter[x]      = hevc_sao_band_filter_neon_10;
+            c->sao_edge_filter[x]      = hevc_sao_edge_filter_neon_10;
+        }
+    }
+}
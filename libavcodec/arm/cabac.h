@@ -103,6 +103,54 @@ static av_always_inline int get_cabac_inline_arm(CABACContext *c,
 
     return bit & 1;
 }
+
+#define get_cabac_bypass get_cabac_bypass_arm
+static av_always_inline int get_cabac_bypass_arm(CABACContext *c)
+{
+    int bit;
+    void *reg_a, *reg_b;
+
+    __asm__ volatile(
+        "mov        %[bit]        , #0                          \n\t"
+        "lsl        %[low]        , %[low]      , #1            \n\t"
+        "lsls       %[r_a]        , %[low]      , #16           \n\t"
+        "bne        1f                                          \n\t"
+        "ldr        %[r_a]        , [%[c], %[byte]]             \n\t"
+#if UNCHECKED_BITSTREAM_READER
+        "ldrh       %[r_b]        , [%[r_a]]                    \n\t"
+        "add        %[r_a]        , %[r_a]      , #2            \n\t"
+        "str        %[r_a]        , [%[c], %[byte]]             \n\t"
+#else
+        "ldr        %[r_b]        , [%[c], %[end]]              \n\t"
+        "cmp        %[r_a]        , %[r_b]                      \n\t"
+        "ldrh       %[r_b]        , [%[r_a]]                    \n\t"
+        "itt        lt                                          \n\t"
+        "addlt      %[r_a]        , %[r_a]      , #2            \n\t"
+        "strlt      %[r_a]        , [%[c], %[byte]]             \n\t"
+#endif
+        "rev        %[r_b]        , %[r_b]                      \n\t"
+        "movw       %[r_a]        , #0xFFFF                     \n\t"
+        "add        %[low]        , %[low]      , %[r_b], lsr #15 \n\t"
+        "sub        %[low]        , %[low]      , %[r_a]        \n\t"
+        "1:                                                     \n\t"
+        "lsl        %[r_a]        , %[range]    , #17           \n\t"
+        "cmp        %[low]        , %[r_a]                      \n\t"
+        "itt        ge                                          \n\t"
+        "subge      %[low]        , %[low]      , %[r_a]        \n\t"
+        "movge      %[bit]        , #1                          \n\t"
+        :    [bit]"=&r"(bit),
+             [low]"+&r"(c->low),
+             [r_a]"=&r"(reg_a),
+             [r_b]"=&r"(reg_b)
+        :        [c]"r"(c),
+             [range]"r"(c->range),
+              [byte]"M"(offsetof(CABACContext, bytestream)),
+               [end]"M"(offsetof(CABACContext, bytestream_end))
+        : "memory", "cc"
+        );
+
+    return bit;
+}
 #endif /* HAVE_ARMV6T2_INLINE */
 
 #endif /* AVCODEC_ARM_CABAC_H */
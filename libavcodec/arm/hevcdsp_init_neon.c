@@ -18,8 +18,12 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <string.h>
+
 #include "libavutil/attributes.h"
 #include "libavutil/arm/cpu.h"
+#include "libavcodec/avcodec.h"
+#include "libavcodec/hevc.h"
 #include "libavcodec/hevcdsp.h"
 #include "hevcdsp_arm.h"
 
@@ -27,13 +31,18 @@ void ff_hevc_v_loop_filter_luma_neon(uint8_t *_pix, ptrdiff_t _stride, int _beta
 void ff_hevc_h_loop_filter_luma_neon(uint8_t *_pix, ptrdiff_t _stride, int _beta, int *_tc, uint8_t *_no_p, uint8_t *_no_q);
 void ff_hevc_v_loop_filter_chroma_neon(uint8_t *_pix, ptrdiff_t _stride, int *_tc, uint8_t *_no_p, uint8_t *_no_q);
 void ff_hevc_h_loop_filter_chroma_neon(uint8_t *_pix, ptrdiff_t _stride, int *_tc, uint8_t *_no_p, uint8_t *_no_q);
+void ff_hevc_deblocking_bs_neon(uint8_t *bs, ptrdiff_t stride, const DeblockMotion *p, const DeblockMotion *q, int n);
 void ff_hevc_transform_4x4_neon_8(int16_t *coeffs, int col_limit);
 void ff_hevc_transform_8x8_neon_8(int16_t *coeffs, int col_limit);
+void ff_hevc_transform_16x16_neon_8(int16_t *coeffs, int col_limit);
+void ff_hevc_transform_32x32_neon_8(int16_t *coeffs, int col_limit);
 void ff_hevc_idct_4x4_dc_neon_8(int16_t *coeffs);
 void ff_hevc_idct_8x8_dc_neon_8(int16_t *coeffs);
 void ff_hevc_idct_16x16_dc_neon_8(int16_t *coeffs);
 void ff_hevc_idct_32x32_dc_neon_8(int16_t *coeffs);
 void ff_hevc_transform_luma_4x4_neon_8(int16_t *coeffs);
+void ff_hevc_transform_skip_neon_8(int16_t *coeffs, int16_t log2_size);
+void ff_hevc_transform_rdpcm_neon_8(int16_t *coeffs, int16_t log2_size, int mode);
 void ff_hevc_transform_add_4x4_neon_8(uint8_t *_dst, int16_t *coeffs,
                                       ptrdiff_t stride);
 void ff_hevc_transform_add_8x8_neon_8(uint8_t *_dst, int16_t *coeffs,
@@ -42,6 +51,44 @@ void ff_hevc_transform_add_16x16_neon_8(uint8_t *_dst, int16_t *coeffs,
                                       ptrdiff_t stride);
 void ff_hevc_transform_add_32x32_neon_8(uint8_t *_dst, int16_t *coeffs,
                                       ptrdiff_t stride);
+void ff_hevc_sao_band_filter_neon_8(uint8_t *dst, uint8_t *src,
+                                    ptrdiff_t stride_dst, ptrdiff_t stride_src,
+                                    const int8_t *offset_table, int width, int height);
+void ff_hevc_sao_band_filter_neon_10(uint8_t *dst, uint8_t *src,
+                                     ptrdiff_t stride_dst, ptrdiff_t stride_src,
+                                     const int8_t *offset_table, int width, int height);
+void ff_hevc_sao_edge_filter_neon_8(uint8_t *dst, uint8_t *src, ptrdiff_t stride_dst,
+                                    const int8_t *offset_table, int a_off, int b_off,
+                                    int width, int height);
+void ff_hevc_sao_edge_filter_neon_10(uint8_t *dst, uint8_t *src, ptrdiff_t stride_dst,
+                                     const int8_t *offset_table, int a_off, int b_off,
+                                     int width, int height);
+
+#define EPEL_FUNC(in, out)                                                                       \
+    void ff_hevc_put_epel_ ## in ## _ ## out ## _neon_8(uint8_t *dst, ptrdiff_t dststride,       \
+                                                        const uint8_t *src, ptrdiff_t srcstride, \
+                                                        int height, int width,                   \
+                                                        const int8_t *filter,                    \
+                                                        const int16_t *src2, const int32_t *wp)
+EPEL_FUNC(h, put);
+EPEL_FUNC(h, uni);
+EPEL_FUNC(h, bi);
+EPEL_FUNC(h, uni_w);
+EPEL_FUNC(h, bi_w);
+EPEL_FUNC(v, put);
+EPEL_FUNC(v, uni);
+EPEL_FUNC(v, bi);
+EPEL_FUNC(v, uni_w);
+EPEL_FUNC(v, bi_w);
+EPEL_FUNC(hv, put);
+EPEL_FUNC(hv, uni);
+EPEL_FUNC(hv, bi);
+EPEL_FUNC(hv, uni_w);
+EPEL_FUNC(hv, bi_w);
+EPEL_FUNC(pixels, bi);
+EPEL_FUNC(pixels, uni_w);
+EPEL_FUNC(pixels, bi_w);
+#undef EPEL_FUNC
 
 #define PUT_PIXELS(name) \
     void name(int16_t *dst, uint8_t *src, \
@@ -142,8 +189,191 @@ void ff_hevc_put_qpel_bi_neon_wrapper(uint8_t *dst, ptrdiff_t dststride, uint8_t
     put_hevc_qpel_uw_neon[my][mx](dst, dststride, src, srcstride, width, height, src2, MAX_PB_SIZE);
 }
 
+/* The epel kernels take the filter taps and, for weighted prediction, the
+ * folded weights wp[] = { w1, w0, rounding, -shift, offset } (see
+ * hevcdsp_epel_neon.S). The hv case runs the h kernel into a temporary
+ * first, like the C template. */
+#define EPEL_DECL_pixels
+#define EPEL_DECL_h
+#define EPEL_DECL_v
+#define EPEL_DECL_hv                                                                \
+    int16_t tmp[(MAX_PB_SIZE + EPEL_EXTRA) * MAX_PB_SIZE];
+#define EPEL_PREP_pixels
+#define EPEL_PREP_h
+#define EPEL_PREP_v
+#define EPEL_PREP_hv                                                                \
+    ff_hevc_put_epel_h_put_neon_8((uint8_t *)tmp, MAX_PB_SIZE * sizeof(int16_t),    \
+                                  src - EPEL_EXTRA_BEFORE * srcstride,              \
+                                  srcstride, height + EPEL_EXTRA, width,            \
+                                  ff_hevc_epel_filters[mx - 1], NULL, NULL);        \
+    src       = (uint8_t *)tmp;                                                     \
+    srcstride = MAX_PB_SIZE * sizeof(int16_t);
+#define EPEL_TAPS_pixels NULL
+#define EPEL_TAPS_h      ff_hevc_epel_filters[mx - 1]
+#define EPEL_TAPS_v      ff_hevc_epel_filters[my - 1]
+#define EPEL_TAPS_hv     ff_hevc_epel_filters[my - 1]
+
+#define EPEL_WRAPPER_PUT(in)                                                        \
+static void hevc_put_epel_ ## in ## _neon_8(int16_t *dst, uint8_t *src,             \
+                                            ptrdiff_t srcstride, int height,        \
+                                            intptr_t mx, intptr_t my,               \
+                                            int width)                              \
+{                                                                                   \
+    EPEL_DECL_ ## in                                                                \
+    EPEL_PREP_ ## in                                                                \
+    ff_hevc_put_epel_ ## in ## _put_neon_8((uint8_t *)dst,                          \
+                                           MAX_PB_SIZE * sizeof(int16_t),           \
+                                           src, srcstride, height, width,           \
+                                           EPEL_TAPS_ ## in, NULL, NULL);           \
+}
+
+#define EPEL_WRAPPER_UNI(in)                                                        \
+static void hevc_put_epel_uni_ ## in ## _neon_8(uint8_t *dst, ptrdiff_t dststride,  \
+                                                uint8_t *src, ptrdiff_t srcstride,  \
+                                                int height, intptr_t mx,            \
+                                                intptr_t my, int width)             \
+{                                                                                   \
+    EPEL_DECL_ ## in                                                                \
+    EPEL_PREP_ ## in                                                                \
+    ff_hevc_put_epel_ ## in ## _uni_neon_8(dst, dststride, src, srcstride,          \
+                                           height, width,                           \
+                                           EPEL_TAPS_ ## in, NULL, NULL);           \
+}
+
+#define EPEL_WRAPPER_BI(in)                                                         \
+static void hevc_put_epel_bi_ ## in ## _neon_8(uint8_t *dst, ptrdiff_t dststride,   \
+                                               uint8_t *src, ptrdiff_t srcstride,   \
+                                               int16_t *src2, int height,           \
+                                               intptr_t mx, intptr_t my,            \
+                                               int width)                           \
+{                                                                                   \
+    EPEL_DECL_ ## in                                                                \
+    EPEL_PREP_ ## in                                                                \
+    ff_hevc_put_epel_ ## in ## _bi_neon_8(dst, dststride, src, srcstride,           \
+                                          height, width,                            \
+                                          EPEL_TAPS_ ## in, src2, NULL);            \
+}
+
+#define EPEL_WRAPPER_UNI_W(in)                                                      \
+static void hevc_put_epel_uni_w_ ## in ## _neon_8(uint8_t *dst, ptrdiff_t dststride,\
+                                                  uint8_t *src, ptrdiff_t srcstride,\
+                                                  int height, int denom,            \
+                                                  int wx, int ox,                   \
+                                                  intptr_t mx, intptr_t my,         \
+                                                  int width)                        \
+{                                                                                   \
+    int shift = denom + 14 - 8;                                                     \
+    int32_t wp[5] = { wx, 0, 1 << (shift - 1), -shift, ox };                        \
+    EPEL_DECL_ ## in                                                                \
+    EPEL_PREP_ ## in                                                                \
+    ff_hevc_put_epel_ ## in ## _uni_w_neon_8(dst, dststride, src, srcstride,        \
+                                             height, width,                         \
+                                             EPEL_TAPS_ ## in, NULL, wp);           \
+}
+
+#define EPEL_WRAPPER_BI_W(in)                                                       \
+static void hevc_put_epel_bi_w_ ## in ## _neon_8(uint8_t *dst, ptrdiff_t dststride, \
+                                                 uint8_t *src, ptrdiff_t srcstride, \
+                                                 int16_t *src2, int height,         \
+                                                 int denom, int wx0, int wx1,       \
+                                                 int ox0, int ox1,                  \
+                                                 intptr_t mx, intptr_t my,          \
+                                                 int width)                         \
+{                                                                                   \
+    int log2Wd = denom + 14 + 1 - 8 - 1;                                            \
+    int32_t wp[5] = { wx1, wx0, (ox0 + ox1 + 1) << log2Wd, -(log2Wd + 1), 0 };      \
+    EPEL_DECL_ ## in                                                                \
+    EPEL_PREP_ ## in                                                                \
+    ff_hevc_put_epel_ ## in ## _bi_w_neon_8(dst, dststride, src, srcstride,         \
+                                            height, width,                          \
+                                            EPEL_TAPS_ ## in, src2, wp);            \
+}
+
+EPEL_WRAPPER_PUT(h)
+EPEL_WRAPPER_PUT(v)
+EPEL_WRAPPER_PUT(hv)
+EPEL_WRAPPER_UNI(h)
+EPEL_WRAPPER_UNI(v)
+EPEL_WRAPPER_UNI(hv)
+EPEL_WRAPPER_BI(pixels)
+EPEL_WRAPPER_BI(h)
+EPEL_WRAPPER_BI(v)
+EPEL_WRAPPER_BI(hv)
+EPEL_WRAPPER_UNI_W(pixels)
+EPEL_WRAPPER_UNI_W(h)
+EPEL_WRAPPER_UNI_W(v)
+EPEL_WRAPPER_UNI_W(hv)
+EPEL_WRAPPER_BI_W(pixels)
+EPEL_WRAPPER_BI_W(h)
+EPEL_WRAPPER_BI_W(v)
+EPEL_WRAPPER_BI_W(hv)
+
+/* The NEON SAO filters work on byte lookup tables; offsets fit in int8_t
+ * for bit depths up to 10. */
+static void sao_band_table(int8_t *offset_table, const int16_t *sao_offset_val,
+                           int sao_left_class)
+{
+    int k;
+
+    memset(offset_table, 0, 32);
+    for (k = 0; k < 4; k++)
+        offset_table[(k + sao_left_class) & 31] = sao_offset_val[k + 1];
+}
+
+static void sao_edge_table(int8_t *offset_table, int *a_off, int *b_off,
+                           const int16_t *sao_offset_val, int eo, int pixel_shift)
+{
+    static const uint8_t edge_idx[] = { 1, 2, 0, 3, 4 };
+    static const int8_t pos[4][2][2] = {
+        { { -1,  0 }, {  1, 0 } }, // horizontal
+        { {  0, -1 }, {  0, 1 } }, // vertical
+        { { -1, -1 }, {  1, 1 } }, // 45 degree
+        { {  1, -1 }, { -1, 1 } }, // 135 degree
+    };
+    const int stride_src = 2 * MAX_PB_SIZE + FF_INPUT_BUFFER_PADDING_SIZE;
+    int k;
+
+    for (k = 0; k < 5; k++)
+        offset_table[k] = sao_offset_val[edge_idx[k]];
+    *a_off = pos[eo][0][0] * (1 << pixel_shift) + pos[eo][0][1] * stride_src;
+    *b_off = pos[eo][1][0] * (1 << pixel_shift) + pos[eo][1][1] * stride_src;
+}
+
+#define SAO_FUNCS(depth, pixel_shift)                                               \
+static void hevc_sao_band_filter_neon_ ## depth(uint8_t *dst, uint8_t *src,         \
+                                                ptrdiff_t stride_dst,               \
+                                                ptrdiff_t stride_src,               \
+                                                int16_t *sao_offset_val,            \
+                                                int sao_left_class,                 \
+                                                int width, int height)              \
+{                                                                                   \
+    int8_t offset_table[32];                                                        \
+                                                                                    \
+    sao_band_table(offset_table, sao_offset_val, sao_left_class);                   \
+    ff_hevc_sao_band_filter_neon_ ## depth(dst, src, stride_dst, stride_src,        \
+                                           offset_table, width, height);            \
+}                                                                                   \
+                                                                                    \
+static void hevc_sao_edge_filter_neon_ ## depth(uint8_t *dst, uint8_t *src,         \
+                                                ptrdiff_t stride_dst,               \
+                                                int16_t *sao_offset_val,            \
+                                                int eo, int width, int height)      \
+{                                                                                   \
+    int8_t offset_table[8];                                                         \
+    int a_off, b_off;                                                               \
+                                                                                    \
+    sao_edge_table(offset_table, &a_off, &b_off, sao_offset_val, eo, pixel_shift);  \
+    ff_hevc_sao_edge_filter_neon_ ## depth(dst, src, stride_dst, offset_table,      \
+                                           a_off, b_off, width, height);            \
+}
+
+SAO_FUNCS(8,  0)
+SAO_FUNCS(10, 1)
+
 av_cold void ff_hevcdsp_init_neon(HEVCDSPContext *c, const int bit_depth)
 {
+    c->deblocking_bs = ff_hevc_deblocking_bs_neon;
+
     if (bit_depth == 8) {
         int x;
         c->hevc_v_loop_filter_luma     = ff_hevc_v_loop_filter_luma_neon;
@@ -152,6 +382,8 @@ av_cold void ff_hevcdsp_init_neon(HEVCDSPContext *c, const int bit_depth)
         c->hevc_h_loop_filter_chroma   = ff_hevc_h_loop_filter_chroma_neon;
         c->idct[0]                     = ff_hevc_transform_4x4_neon_8;
         c->idct[1]                     = ff_hevc_transform_8x8_neon_8;
+        c->idct[2]                     = ff_hevc_transform_16x16_neon_8;
+        c->idct[3]                     = ff_hevc_transform_32x32_neon_8;
         c->idct_dc[0]                  = ff_hevc_idct_4x4_dc_neon_8;
         c->idct_dc[1]                  = ff_hevc_idct_8x8_dc_neon_8;
         c->idct_dc[2]                  = ff_hevc_idct_16x16_dc_neon_8;
@@ -161,6 +393,8 @@ av_cold void ff_hevcdsp_init_neon(HEVCDSPContext *c, const int bit_depth)
         c->transform_add[2]            = ff_hevc_transform_add_16x16_neon_8;
         c->transform_add[3]            = ff_hevc_transform_add_32x32_neon_8;
         c->idct_4x4_luma               = ff_hevc_transform_luma_4x4_neon_8;
+        c->transform_skip              = ff_hevc_transform_skip_neon_8;
+        c->transform_rdpcm             = ff_hevc_transform_rdpcm_neon_8;
         put_hevc_qpel_neon[1][0]       = ff_hevc_put_qpel_v1_neon_8;
         put_hevc_qpel_neon[2][0]       = ff_hevc_put_qpel_v2_neon_8;
         put_hevc_qpel_neon[3][0]       = ff_hevc_put_qpel_v3_neon_8;
@@ -220,5 +454,49 @@ av_cold void ff_hevcdsp_init_neon(HEVCDSPContext *c, const int bit_depth)
         c->put_hevc_qpel_uni[7][0][0]  = ff_hevc_put_qpel_uw_pixels_w32_neon_8;
         c->put_hevc_qpel_uni[8][0][0]  = ff_hevc_put_qpel_uw_pixels_w48_neon_8;
         c->put_hevc_qpel_uni[9][0][0]  = ff_hevc_put_qpel_uw_pixels_w64_neon_8;
+
+        for (x = 0; x < 10; x++) {
+            c->put_hevc_epel[x][0][0]         = c->put_hevc_qpel[x][0][0];
+            c->put_hevc_epel[x][0][1]         = hevc_put_epel_h_neon_8;
+            c->put_hevc_epel[x][1][0]         = hevc_put_epel_v_neon_8;
+            c->put_hevc_epel[x][1][1]         = hevc_put_epel_hv_neon_8;
+            c->put_hevc_epel_uni[x][0][1]     = hevc_put_epel_uni_h_neon_8;
+            c->put_hevc_epel_uni[x][1][0]     = hevc_put_epel_uni_v_neon_8;
+            c->put_hevc_epel_uni[x][1][1]     = hevc_put_epel_uni_hv_neon_8;
+            c->put_hevc_epel_bi[x][0][0]      = hevc_put_epel_bi_pixels_neon_8;
+            c->put_hevc_epel_bi[x][0][1]      = hevc_put_epel_bi_h_neon_8;
+            c->put_hevc_epel_bi[x][1][0]      = hevc_put_epel_bi_v_neon_8;
+            c->put_hevc_epel_bi[x][1][1]      = hevc_put_epel_bi_hv_neon_8;
+            c->put_hevc_epel_uni_w[x][0][0]   = hevc_put_epel_uni_w_pixels_neon_8;
+            c->put_hevc_epel_uni_w[x][0][1]   = hevc_put_epel_uni_w_h_neon_8;
+            c->put_hevc_epel_uni_w[x][1][0]   = hevc_put_epel_uni_w_v_neon_8;
+            c->put_hevc_epel_uni_w[x][1][1]   = hevc_put_epel_uni_w_hv_neon_8;
+            c->put_hevc_epel_bi_w[x][0][0]    = hevc_put_epel_bi_w_pixels_neon_8;
+            c->put_hevc_epel_bi_w[x][0][1]    = hevc_put_epel_bi_w_h_neon_8;
+            c->put_hevc_epel_bi_w[x][1][0]    = hevc_put_epel_bi_w_v_neon_8;
+            c->put_hevc_epel_bi_w[x][1][1]    = hevc_put_epel_bi_w_hv_neon_8;
+            /* the full-pel cases are shared between luma and chroma */
+            c->put_hevc_qpel_bi[x][0][0]      = hevc_put_epel_bi_pixels_neon_8;
+            c->put_hevc_qpel_uni_w[x][0][0]   = hevc_put_epel_uni_w_pixels_neon_8;
+            c->put_hevc_qpel_bi_w[x][0][0]    = hevc_put_epel_bi_w_pixels_neon_8;
+        }
+        c->put_hevc_epel_uni[1][0][0]  = ff_hevc_put_qpel_uw_pixels_w4_neon_8;
+        c->put_hevc_epel_uni[3][0][0]  = ff_hevc_put_qpel_uw_pixels_w8_neon_8;
+        c->put_hevc_epel_uni[5][0][0]  = ff_hevc_put_qpel_uw_pixels_w16_neon_8;
+        c->put_hevc_epel_uni[6][0][0]  = ff_hevc_put_qpel_uw_pixels_w24_neon_8;
+        c->put_hevc_epel_uni[7][0][0]  = ff_hevc_put_qpel_uw_pixels_w32_neon_8;
+        c->put_hevc_epel_uni[8][0][0]  = ff_hevc_put_qpel_uw_pixels_w48_neon_8;
+        c->put_hevc_epel_uni[9][0][0]  = ff_hevc_put_qpel_uw_pixels_w64_neon_8;
+
+        for (x = 0; x < 5; x++) {
+            c->sao_band_filter[x]      = hevc_sao_band_filter_neon_8;
+            c->sao_edge_filter[x]      = hevc_sao_edge_filter_neon_8;
+        }
+    } else if (bit_depth == 10) {
+        int x;
+        for (x = 0; x < 5; x++) {
+            c->sao_band_filter[x]      = hevc_sao_band_filter_neon_10;
+            c->sao_edge_filter[x]      = hevc_sao_edge_filter_neon_10;
+        }
     }
 }
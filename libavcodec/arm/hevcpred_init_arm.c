@@ -0,0 +1,136 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/arm/cpu.h"
+#include "libavcodec/hevc.h"
+#include "libavcodec/hevcpred.h"
+
+void ff_hevc_pred_planar_4_neon_8(uint8_t *src, const uint8_t *top,
+                                  const uint8_t *left, ptrdiff_t stride);
+void ff_hevc_pred_planar_8_neon_8(uint8_t *src, const uint8_t *top,
+                                  const uint8_t *left, ptrdiff_t stride);
+void ff_hevc_pred_planar_16_neon_8(uint8_t *src, const uint8_t *top,
+                                   const uint8_t *left, ptrdiff_t stride);
+void ff_hevc_pred_planar_32_neon_8(uint8_t *src, const uint8_t *top,
+                                   const uint8_t *left, ptrdiff_t stride);
+void ff_hevc_pred_dc_neon_8(uint8_t *src, const uint8_t *top,
+                            const uint8_t *left, ptrdiff_t stride,
+                            int log2_size, int c_idx);
+void ff_hevc_pred_angular_v_neon_8(uint8_t *src, ptrdiff_t stride,
+                                   const uint8_t *ref, int angle, int size);
+void ff_hevc_pred_angular_h_neon_8(uint8_t *src, ptrdiff_t stride,
+                                   const uint8_t *ref, int angle, int size);
+void ff_hevc_ref_filter_neon_8(uint8_t *filtered_left, uint8_t *filtered_top,
+                               const uint8_t *left, const uint8_t *top,
+                               int size);
+
+#if HAVE_NEON
+static const int8_t intra_pred_angle[] = {
+     32,  26,  21,  17, 13,  9,  5, 2, 0, -2, -5, -9, -13, -17, -21, -26, -32,
+    -26, -21, -17, -13, -9, -5, -2, 0, 2,  5,  9, 13,  17,  21,  26,  32
+};
+static const int16_t inv_angle[] = {
+    -4096, -1638, -910, -630, -482, -390, -315, -256, -315, -390, -482,
+    -630, -910, -1638, -4096
+};
+
+/* The projection of the side samples for negative angles and the boundary
+ * smoothing of the pure horizontal/vertical modes are done here, the
+ * interpolation itself in NEON. */
+static av_always_inline void pred_angular_neon(uint8_t *src, const uint8_t *top,
+                                               const uint8_t *left,
+                                               ptrdiff_t stride, int c_idx,
+                                               int mode, int size)
+{
+    int angle = intra_pred_angle[mode - 2];
+    int last  = (size * angle) >> 5;
+    uint8_t ref_array[3 * MAX_TB_SIZE + 4];
+    uint8_t *ref_tmp = ref_array + size;
+    const uint8_t *main_ref = mode >= 18 ? top  : left;
+    const uint8_t *side_ref = mode >= 18 ? left : top;
+    const uint8_t *ref = main_ref - 1;
+    int x;
+
+    if (angle < 0 && last < -1) {
+        memcpy(ref_tmp, main_ref - 1, size + 1);
+        for (x = last; x <= -1; x++)
+            ref_tmp[x] = side_ref[-1 + ((x * inv_angle[mode - 11] + 128) >> 8)];
+        ref = ref_tmp;
+    }
+
+    if (mode >= 18) {
+        ff_hevc_pred_angular_v_neon_8(src, stride, ref, angle, size);
+        if (mode == 26 && c_idx == 0 && size < 32)
+            for (x = 0; x < size; x++)
+                src[x * stride] = av_clip_uint8(top[0] + ((left[x] - left[-1]) >> 1));
+    } else {
+        ff_hevc_pred_angular_h_neon_8(src, stride, ref, angle, size);
+        if (mode == 10 && c_idx == 0 && size < 32)
+            for (x = 0; x < size; x++)
+                src[x] = av_clip_uint8(left[0] + ((top[x] - top[-1]) >> 1));
+    }
+}
+
+#define PRED_ANGULAR(idx, size)                                                 \
+static void pred_angular_ ## idx ## _neon_8(uint8_t *src, const uint8_t *top,   \
+                                            const uint8_t *left,                \
+                                            ptrdiff_t stride, int c_idx,        \
+                                            int mode)                           \
+{                                                                               \
+    pred_angular_neon(src, top, left, stride, c_idx, mode, size);               \
+}
+
+PRED_ANGULAR(0, 4)
+PRED_ANGULAR(1, 8)
+PRED_ANGULAR(2, 16)
+PRED_ANGULAR(3, 32)
+
+#undef PRED_ANGULAR
+#endif /* HAVE_NEON */
+
+static av_cold void hevc_pred_init_neon(HEVCPredContext *hpc, int bit_depth)
+{
+#if HAVE_NEON
+    if (bit_depth != 8)
+        return;
+
+    hpc->pred_planar[0]  = ff_hevc_pred_planar_4_neon_8;
+    hpc->pred_planar[1]  = ff_hevc_pred_planar_8_neon_8;
+    hpc->pred_planar[2]  = ff_hevc_pred_planar_16_neon_8;
+    hpc->pred_planar[3]  = ff_hevc_pred_planar_32_neon_8;
+    hpc->pred_dc         = ff_hevc_pred_dc_neon_8;
+    hpc->pred_angular[0] = pred_angular_0_neon_8;
+    hpc->pred_angular[1] = pred_angular_1_neon_8;
+    hpc->pred_angular[2] = pred_angular_2_neon_8;
+    hpc->pred_angular[3] = pred_angular_3_neon_8;
+    hpc->ref_filter      = ff_hevc_ref_filter_neon_8;
+#endif /* HAVE_NEON */
+}
+
+av_cold void ff_hevc_pred_init_arm(HEVCPredContext *hpc, int bit_depth)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (have_neon(cpu_flags))
+        hevc_pred_init_neon(hpc, bit_depth);
+}
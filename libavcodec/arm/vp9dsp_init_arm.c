@@ -0,0 +1,248 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/arm/cpu.h"
+#include "libavcodec/vp9dsp.h"
+
+#include "config.h"
+
+#define fpel_func(type, sz) \
+void ff_vp9_##type##sz##_neon(uint8_t *dst, ptrdiff_t dst_stride, \
+                              const uint8_t *src, ptrdiff_t src_stride, \
+                              int h, int mx, int my)
+#define fpel_funcs(sz) \
+fpel_func(copy, sz); \
+fpel_func(avg,  sz)
+
+fpel_funcs(64);
+fpel_funcs(32);
+fpel_funcs(16);
+fpel_funcs(8);
+fpel_funcs(4);
+
+#undef fpel_funcs
+#undef fpel_func
+
+#define mc_func(op, dir) \
+void ff_vp9_##op##_8tap_1d_##dir##_neon(uint8_t *dst, ptrdiff_t dst_stride, \
+                                        const uint8_t *src, ptrdiff_t src_stride, \
+                                        int h, int w, const int16_t *filter)
+mc_func(put, h);
+mc_func(avg, h);
+mc_func(put, v);
+mc_func(avg, v);
+
+#undef mc_func
+
+#define filter_8tap_1d_fn(op, sz, f, fname, dir, dvar) \
+static void op##_8tap_##fname##_##sz##dir##_neon(uint8_t *dst, ptrdiff_t dst_stride, \
+                                                 const uint8_t *src, ptrdiff_t src_stride, \
+                                                 int h, int mx, int my) \
+{ \
+    ff_vp9_##op##_8tap_1d_##dir##_neon(dst, dst_stride, src, src_stride, \
+                                       h, sz, ff_vp9_subpel_filters[f][dvar]); \
+}
+
+#define filter_8tap_2d_fn(op, sz, f, fname) \
+static void op##_8tap_##fname##_##sz##hv_neon(uint8_t *dst, ptrdiff_t dst_stride, \
+                                              const uint8_t *src, ptrdiff_t src_stride, \
+                                              int h, int mx, int my) \
+{ \
+    DECLARE_ALIGNED(16, uint8_t, temp)[71 * 64]; \
+    ff_vp9_put_8tap_1d_h_neon(temp, 64, src - 3 * src_stride, src_stride, \
+                              h + 7, sz, ff_vp9_subpel_filters[f][mx]); \
+    ff_vp9_##op##_8tap_1d_v_neon(dst, dst_stride, temp + 3 * 64, 64, \
+                                 h, sz, ff_vp9_subpel_filters[f][my]); \
+}
+
+#define filters_8tap_fn(op, sz, f, fname) \
+filter_8tap_1d_fn(op, sz, f, fname, h, mx) \
+filter_8tap_1d_fn(op, sz, f, fname, v, my) \
+filter_8tap_2d_fn(op, sz, f, fname)
+
+#define filters_8tap_fn2(op, sz) \
+filters_8tap_fn(op, sz, FILTER_8TAP_REGULAR, regular) \
+filters_8tap_fn(op, sz, FILTER_8TAP_SHARP,   sharp) \
+filters_8tap_fn(op, sz, FILTER_8TAP_SMOOTH,  smooth)
+
+#define filters_8tap_fn3(op) \
+filters_8tap_fn2(op, 64) \
+filters_8tap_fn2(op, 32) \
+filters_8tap_fn2(op, 16) \
+filters_8tap_fn2(op, 8) \
+filters_8tap_fn2(op, 4)
+
+filters_8tap_fn3(put)
+filters_8tap_fn3(avg)
+
+#undef filters_8tap_fn3
+#undef filters_8tap_fn2
+#undef filters_8tap_fn
+#undef filter_8tap_2d_fn
+#undef filter_8tap_1d_fn
+
+#define ipred_func(size, type) \
+void ff_vp9_##type##_##size##x##size##_neon(uint8_t *dst, ptrdiff_t stride, \
+                                            const uint8_t *left, const uint8_t *top)
+#define ipred_funcs(size) \
+ipred_func(size, vert); \
+ipred_func(size, hor); \
+ipred_func(size, dc); \
+ipred_func(size, dc_left); \
+ipred_func(size, dc_top); \
+ipred_func(size, tm)
+
+ipred_funcs(4);
+ipred_funcs(8);
+ipred_funcs(16);
+ipred_funcs(32);
+
+#undef ipred_funcs
+#undef ipred_func
+
+#define itxfm_func(typea, typeb, size) \
+void ff_vp9_##typea##_##typeb##_##size##x##size##_add_neon(uint8_t *dst, ptrdiff_t stride, \
+                                                           int16_t *block, int eob)
+#define itxfm_funcs(size) \
+itxfm_func(idct,  idct,  size); \
+itxfm_func(iadst, idct,  size); \
+itxfm_func(idct,  iadst, size); \
+itxfm_func(iadst, iadst, size)
+
+itxfm_funcs(4);
+itxfm_funcs(8);
+
+#undef itxfm_funcs
+#undef itxfm_func
+
+#define lpf_func(dir, wd) \
+void ff_vp9_loop_filter_##dir##_##wd##_8_neon(uint8_t *dst, ptrdiff_t stride, \
+                                              int E, int I, int H)
+lpf_func(h, 4);
+lpf_func(v, 4);
+lpf_func(h, 8);
+lpf_func(v, 8);
+
+#undef lpf_func
+
+// the mixed filters run the two 8 pixel halves one after the other
+#define lpf_mix2_fn(dir, wd1, wd2, stridea) \
+static void loop_filter_##dir##_##wd1##wd2##_16_neon(uint8_t *dst, ptrdiff_t stride, \
+                                                     int E, int I, int H) \
+{ \
+    ff_vp9_loop_filter_##dir##_##wd1##_8_neon(dst, stride, \
+                                              E & 0xff, I & 0xff, H & 0xff); \
+    ff_vp9_loop_filter_##dir##_##wd2##_8_neon(dst + 8 * stridea, stride, \
+                                              E >> 8, I >> 8, H >> 8); \
+}
+
+#define lpf_mix2_fns(wd1, wd2) \
+lpf_mix2_fn(h, wd1, wd2, stride) \
+lpf_mix2_fn(v, wd1, wd2, 1)
+
+lpf_mix2_fns(4, 4)
+lpf_mix2_fns(4, 8)
+lpf_mix2_fns(8, 4)
+lpf_mix2_fns(8, 8)
+
+#undef lpf_mix2_fns
+#undef lpf_mix2_fn
+
+av_cold void ff_vp9dsp_init_arm(VP9DSPContext *dsp, int bpp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (bpp != 8 || !have_neon(cpu_flags))
+        return;
+
+#define init_fpel(idx1, idx2, sz, type) \
+    dsp->mc[idx1][FILTER_8TAP_SMOOTH ][idx2][0][0] = \
+    dsp->mc[idx1][FILTER_8TAP_REGULAR][idx2][0][0] = \
+    dsp->mc[idx1][FILTER_8TAP_SHARP  ][idx2][0][0] = \
+    dsp->mc[idx1][FILTER_BILINEAR    ][idx2][0][0] = ff_vp9_##type##sz##_neon
+
+#define init_subpel1(idx1, idx2, idxh, idxv, sz, dir, type) \
+    dsp->mc[idx1][FILTER_8TAP_SMOOTH ][idx2][idxh][idxv] = type##_8tap_smooth_##sz##dir##_neon; \
+    dsp->mc[idx1][FILTER_8TAP_REGULAR][idx2][idxh][idxv] = type##_8tap_regular_##sz##dir##_neon; \
+    dsp->mc[idx1][FILTER_8TAP_SHARP  ][idx2][idxh][idxv] = type##_8tap_sharp_##sz##dir##_neon
+
+#define init_subpel2(idx1, sz) \
+    init_fpel(idx1, 0, sz, copy); \
+    init_fpel(idx1, 1, sz, avg); \
+    init_subpel1(idx1, 0, 1, 1, sz, hv, put); \
+    init_subpel1(idx1, 0, 0, 1, sz, v,  put); \
+    init_subpel1(idx1, 0, 1, 0, sz, h,  put); \
+    init_subpel1(idx1, 1, 1, 1, sz, hv, avg); \
+    init_subpel1(idx1, 1, 0, 1, sz, v,  avg); \
+    init_subpel1(idx1, 1, 1, 0, sz, h,  avg)
+
+    init_subpel2(0, 64);
+    init_subpel2(1, 32);
+    init_subpel2(2, 16);
+    init_subpel2(3, 8);
+    init_subpel2(4, 4);
+
+#undef init_subpel2
+#undef init_subpel1
+#undef init_fpel
+
+#define init_ipred(tx, sz) \
+    dsp->intra_pred[tx][VERT_PRED]    = ff_vp9_vert_##sz##x##sz##_neon; \
+    dsp->intra_pred[tx][HOR_PRED]     = ff_vp9_hor_##sz##x##sz##_neon; \
+    dsp->intra_pred[tx][DC_PRED]      = ff_vp9_dc_##sz##x##sz##_neon; \
+    dsp->intra_pred[tx][LEFT_DC_PRED] = ff_vp9_dc_left_##sz##x##sz##_neon; \
+    dsp->intra_pred[tx][TOP_DC_PRED]  = ff_vp9_dc_top_##sz##x##sz##_neon; \
+    dsp->intra_pred[tx][TM_VP8_PRED]  = ff_vp9_tm_##sz##x##sz##_neon
+
+    init_ipred(TX_4X4,   4);
+    init_ipred(TX_8X8,   8);
+    init_ipred(TX_16X16, 16);
+    init_ipred(TX_32X32, 32);
+
+#undef init_ipred
+
+#define init_itxfm(tx, sz) \
+    dsp->itxfm_add[tx][DCT_DCT]   = ff_vp9_idct_idct_##sz##x##sz##_add_neon; \
+    dsp->itxfm_add[tx][DCT_ADST]  = ff_vp9_iadst_idct_##sz##x##sz##_add_neon; \
+    dsp->itxfm_add[tx][ADST_DCT]  = ff_vp9_idct_iadst_##sz##x##sz##_add_neon; \
+    dsp->itxfm_add[tx][ADST_ADST] = ff_vp9_iadst_iadst_##sz##x##sz##_add_neon
+
+    init_itxfm(TX_4X4, 4);
+    init_itxfm(TX_8X8, 8);
+
+#undef init_itxfm
+
+    dsp->loop_filter_8[0][0] = ff_vp9_loop_filter_h_4_8_neon;
+    dsp->loop_filter_8[0][1] = ff_vp9_loop_filter_v_4_8_neon;
+    dsp->loop_filter_8[1][0] = ff_vp9_loop_filter_h_8_8_neon;
+    dsp->loop_filter_8[1][1] = ff_vp9_loop_filter_v_8_8_neon;
+
+    dsp->loop_filter_mix2[0][0][0] = loop_filter_h_44_16_neon;
+    dsp->loop_filter_mix2[0][0][1] = loop_filter_v_44_16_neon;
+    dsp->loop_filter_mix2[0][1][0] = loop_filter_h_48_16_neon;
+    dsp->loop_filter_mix2[0][1][1] = loop_filter_v_48_16_neon;
+    dsp->loop_filter_mix2[1][0][0] = loop_filter_h_84_16_neon;
+    dsp->loop_filter_mix2[1][0][1] = loop_filter_v_84_16_neon;
+    dsp->loop_filter_mix2[1][1][0] = loop_filter_h_88_16_neon;
+    dsp->loop_filter_mix2[1][1][1] = loop_filter_v_88_16_neon;
+}
@@ -42,6 +42,7 @@
 #include "h264data.h"
 #include "h264chroma.h"
 #include "h264_mvpred.h"
+#include "h264_recon_thread.h"
 #include "golomb.h"
 #include "mathops.h"
 #include "me_cmp.h"
@@ -1862,6 +1863,8 @@ av_cold void ff_h264_free_context(H264Context *h)
 
     h->cur_pic_ptr = NULL;
 
+    ff_h264_recon_thread_uninit(h);
+
     for (i = 0; i < h->nb_slice_ctx; i++)
         av_freep(&h->slice_ctx[i].rbsp_buffer);
     av_freep(&h->slice_ctx);
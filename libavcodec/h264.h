@@ -491,6 +491,10 @@ typedef struct H264SliceContext {
     // rbsp buffer used for this slice
     uint8_t *rbsp_buffer;
     unsigned int rbsp_buffer_size;
+
+    /* when set, macroblocks are reconstructed and loop filtered on this
+     * thread while the slice is being parsed */
+    struct H264ReconThread *recon;
 } H264SliceContext;
 
 /**
@@ -513,6 +517,8 @@ typedef struct H264Context {
     H264SliceContext *slice_ctx;
     int            nb_slice_ctx;
 
+    struct H264ReconThread *recon_thread;  ///< see ff_h264_execute_decode_slices()
+
     int pixel_shift;    ///< 0 for 8-bit H264, 1 for high-bit-depth H264
 
     /* coded dimensions -- 16 * mb w/h */
@@ -1169,6 +1175,20 @@ void ff_h264_unref_picture(H264Context *h, H264Picture *pic);
 int ff_h264_slice_context_init(H264Context *h, H264SliceContext *sl);
 
 void ff_h264_draw_horiz_band(const H264Context *h, H264SliceContext *sl, int y, int height);
+
+/**
+ * Loop filter the macroblocks start_x to end_x - 1 of the current MB row.
+ */
+void ff_h264_loop_filter_row(const H264Context *h, H264SliceContext *sl,
+                             int start_x, int end_x);
+
+/**
+ * Draw edges and report progress for the last MB row.
+ * @param error_occurred the error flag of the picture as of the end of the
+ *                       row; no progress is reported once it is set
+ */
+void ff_h264_decode_finish_row(const H264Context *h, H264SliceContext *sl,
+                               int error_occurred);
 int ff_init_poc(H264Context *h, int pic_field_poc[2], int *pic_poc);
 int ff_pred_weight_table(H264Context *h, H264SliceContext *sl);
 int ff_set_ref_count(H264Context *h, H264SliceContext *sl);
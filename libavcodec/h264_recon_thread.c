@@ -0,0 +1,328 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * H.264 macroblock reconstruction thread: the slice decoding thread parses
+ * the macroblocks and queues what ff_h264_hl_decode_mb() needs, this thread
+ * reconstructs and loop filters them in decode order.
+ */
+
+#include "config.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "compat/w32pthreads.h"
+#elif HAVE_OS2THREADS
+#include "compat/os2threads.h"
+#endif
+
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#include "h264.h"
+#include "h264_recon_thread.h"
+
+#define RECON_QUEUE_SIZE 256    ///< power of two, about two rows of 1080p
+#define RECON_BATCH       16    ///< entries the parser writes before waking the thread
+
+/**
+ * Everything ff_h264_hl_decode_mb() reads from the slice context that
+ * changes from one macroblock to the next, or a loop filter call.
+ */
+typedef struct H264ReconMB {
+    int mb_x, mb_y;
+    int decoded;                ///< 0 for a loop filter entry
+    int filter_start, filter_end;
+    int finish_row;
+    int error_occurred;         ///< er.error_occurred when the row was queued
+
+    int mb_xy;
+    int qscale;
+    int chroma_qp[2];
+    int cbp;
+    int chroma_pred_mode;
+    int intra16x16_pred_mode;
+    int top_type;
+    unsigned int topleft_samples_available;
+    unsigned int topright_samples_available;
+    unsigned int list_count;
+    const uint8_t *intra_pcm_ptr;
+    int has_coeffs;             ///< mb is only copied when it holds coefficients
+
+    DECLARE_ALIGNED(16, int16_t, mb)[16 * 48 * 2];
+    DECLARE_ALIGNED(16, int16_t, mb_luma_dc)[3][16 * 2];
+    DECLARE_ALIGNED(16, int16_t, mv_cache)[2][5 * 8][2];
+    DECLARE_ALIGNED(8,  int8_t, ref_cache)[2][5 * 8];
+    DECLARE_ALIGNED(8, uint8_t, non_zero_count_cache)[15 * 8];
+    DECLARE_ALIGNED(8, uint16_t, sub_mb_type)[4];
+    int8_t intra4x4_pred_mode_cache[5 * 8];
+} H264ReconMB;
+
+struct H264ReconThread {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;        ///< signalled when queued or die changes
+    pthread_cond_t done_cond;   ///< signalled when done changes
+
+    /* copy of the slice context the macroblocks are reconstructed in, its
+     * scratch buffers are not used by the parser */
+    const H264Context *h;
+    H264SliceContext sl;
+
+    H264ReconMB *queue;
+    unsigned written;           ///< entries written by the parser
+    unsigned queued;            ///< entries handed over to the thread
+    unsigned done;              ///< entries the thread has finished
+    unsigned done_seen;         ///< done as last seen by the parser
+    int die;
+};
+
+static void recon_entry(H264ReconThread *rt, const H264ReconMB *m)
+{
+    const H264Context *h = rt->h;
+    H264SliceContext *sl = &rt->sl;
+
+    sl->mb_x = m->mb_x;
+    sl->mb_y = m->mb_y;
+
+    if (m->decoded) {
+        sl->mb_xy                      = m->mb_xy;
+        sl->qscale                     = m->qscale;
+        sl->chroma_qp[0]               = m->chroma_qp[0];
+        sl->chroma_qp[1]               = m->chroma_qp[1];
+        sl->cbp                        = m->cbp;
+        sl->chroma_pred_mode           = m->chroma_pred_mode;
+        sl->intra16x16_pred_mode       = m->intra16x16_pred_mode;
+        sl->top_type                   = m->top_type;
+        sl->topleft_samples_available  = m->topleft_samples_available;
+        sl->topright_samples_available = m->topright_samples_available;
+        sl->list_count                 = m->list_count;
+        sl->intra_pcm_ptr              = m->intra_pcm_ptr;
+
+        /* the idct clears the coefficients it uses, so sl->mb is zero
+         * again after every macroblock */
+        if (m->has_coeffs)
+            memcpy(sl->mb, m->mb, 16 * 48 * sizeof(*sl->mb) << h->pixel_shift);
+        memcpy(sl->mb_luma_dc, m->mb_luma_dc, sizeof(sl->mb_luma_dc));
+        memcpy(sl->mv_cache, m->mv_cache, sizeof(sl->mv_cache));
+        memcpy(sl->ref_cache, m->ref_cache, sizeof(sl->ref_cache));
+        memcpy(sl->non_zero_count_cache, m->non_zero_count_cache,
+               sizeof(sl->non_zero_count_cache));
+        memcpy(sl->sub_mb_type, m->sub_mb_type, sizeof(sl->sub_mb_type));
+        memcpy(sl->intra4x4_pred_mode_cache, m->intra4x4_pred_mode_cache,
+               sizeof(sl->intra4x4_pred_mode_cache));
+
+        ff_h264_hl_decode_mb(h, sl);
+    }
+
+    if (m->filter_end > m->filter_start)
+        ff_h264_loop_filter_row(h, sl, m->filter_start, m->filter_end);
+    if (m->finish_row)
+        ff_h264_decode_finish_row(h, sl, m->error_occurred);
+}
+
+static void *attribute_align_arg recon_thread_worker(void *arg)
+{
+    H264ReconThread *rt = arg;
+
+    pthread_mutex_lock(&rt->lock);
+    for (;;) {
+        unsigned queued, i;
+
+        while (!rt->die && rt->done == rt->queued)
+            pthread_cond_wait(&rt->cond, &rt->lock);
+        if (rt->die)
+            break;
+
+        queued = rt->queued;
+        pthread_mutex_unlock(&rt->lock);
+
+        for (i = rt->done; i != queued; i++)
+            recon_entry(rt, &rt->queue[i & (RECON_QUEUE_SIZE - 1)]);
+
+        pthread_mutex_lock(&rt->lock);
+        rt->done = queued;
+        pthread_cond_broadcast(&rt->done_cond);
+    }
+    pthread_mutex_unlock(&rt->lock);
+
+    return NULL;
+}
+
+H264ReconThread *ff_h264_recon_thread_get(H264Context *h)
+{
+    H264ReconThread *rt = h->recon_thread;
+
+    if (rt)
+        return rt;
+
+    rt = av_mallocz(sizeof(*rt));
+    if (!rt)
+        return NULL;
+    rt->queue = av_malloc_array(RECON_QUEUE_SIZE, sizeof(*rt->queue));
+    if (!rt->queue) {
+        av_freep(&rt);
+        return NULL;
+    }
+
+    pthread_mutex_init(&rt->lock, NULL);
+    pthread_cond_init(&rt->cond, NULL);
+    pthread_cond_init(&rt->done_cond, NULL);
+
+    if (pthread_create(&rt->thread, NULL, recon_thread_worker, rt)) {
+        pthread_mutex_destroy(&rt->lock);
+        pthread_cond_destroy(&rt->cond);
+        pthread_cond_destroy(&rt->done_cond);
+        av_freep(&rt->queue);
+        av_freep(&rt);
+        return NULL;
+    }
+
+    h->recon_thread = rt;
+    return rt;
+}
+
+void ff_h264_recon_thread_uninit(H264Context *h)
+{
+    H264ReconThread *rt = h->recon_thread;
+
+    if (!rt)
+        return;
+
+    pthread_mutex_lock(&rt->lock);
+    rt->die = 1;
+    pthread_cond_signal(&rt->cond);
+    pthread_mutex_unlock(&rt->lock);
+
+    pthread_join(rt->thread, NULL);
+
+    pthread_mutex_destroy(&rt->lock);
+    pthread_cond_destroy(&rt->cond);
+    pthread_cond_destroy(&rt->done_cond);
+    av_freep(&rt->queue);
+    av_freep(&h->recon_thread);
+}
+
+void ff_h264_recon_thread_start(H264ReconThread *rt, const H264Context *h,
+                                const H264SliceContext *sl)
+{
+    rt->h = h;
+    memcpy(&rt->sl, sl, sizeof(*sl));
+}
+
+static void recon_thread_publish(H264ReconThread *rt)
+{
+    pthread_mutex_lock(&rt->lock);
+    rt->queued = rt->written;
+    pthread_cond_signal(&rt->cond);
+    pthread_mutex_unlock(&rt->lock);
+}
+
+static H264ReconMB *recon_thread_next(H264ReconThread *rt)
+{
+    if (rt->written - rt->done_seen >= RECON_QUEUE_SIZE) {
+        pthread_mutex_lock(&rt->lock);
+        rt->queued = rt->written;
+        pthread_cond_signal(&rt->cond);
+        while (rt->written - rt->done >= RECON_QUEUE_SIZE)
+            pthread_cond_wait(&rt->done_cond, &rt->lock);
+        rt->done_seen = rt->done;
+        pthread_mutex_unlock(&rt->lock);
+    }
+    return &rt->queue[rt->written & (RECON_QUEUE_SIZE - 1)];
+}
+
+void ff_h264_recon_queue_mb(H264ReconThread *rt, const H264Context *h,
+                            H264SliceContext *sl)
+{
+    H264ReconMB *m = recon_thread_next(rt);
+
+    m->mb_x         = sl->mb_x;
+    m->mb_y         = sl->mb_y;
+    m->decoded      = 1;
+    m->filter_start = m->filter_end = 0;
+    m->finish_row   = 0;
+
+    m->mb_xy                      = sl->mb_xy;
+    m->qscale                     = sl->qscale;
+    m->chroma_qp[0]               = sl->chroma_qp[0];
+    m->chroma_qp[1]               = sl->chroma_qp[1];
+    m->cbp                        = sl->cbp;
+    m->chroma_pred_mode           = sl->chroma_pred_mode;
+    m->intra16x16_pred_mode       = sl->intra16x16_pred_mode;
+    m->top_type                   = sl->top_type;
+    m->topleft_samples_available  = sl->topleft_samples_available;
+    m->topright_samples_available = sl->topright_samples_available;
+    m->list_count                 = sl->list_count;
+    m->intra_pcm_ptr              = sl->intra_pcm_ptr;
+
+    /* the parser only writes the nonzero coefficients, so its copy has to
+     * be cleared here instead of by the idct */
+    m->has_coeffs = sl->cbp & 0x3F;
+    if (m->has_coeffs) {
+        const int size = 16 * 48 * sizeof(*sl->mb) << h->pixel_shift;
+        memcpy(m->mb, sl->mb, size);
+        memset(sl->mb, 0, size);
+    }
+    memcpy(m->mb_luma_dc, sl->mb_luma_dc, sizeof(m->mb_luma_dc));
+    memcpy(m->mv_cache, sl->mv_cache, sizeof(m->mv_cache));
+    memcpy(m->ref_cache, sl->ref_cache, sizeof(m->ref_cache));
+    memcpy(m->non_zero_count_cache, sl->non_zero_count_cache,
+           sizeof(m->non_zero_count_cache));
+    memcpy(m->sub_mb_type, sl->sub_mb_type, sizeof(m->sub_mb_type));
+    memcpy(m->intra4x4_pred_mode_cache, sl->intra4x4_pred_mode_cache,
+           sizeof(m->intra4x4_pred_mode_cache));
+
+    if (!(++rt->written & (RECON_BATCH - 1)))
+        recon_thread_publish(rt);
+}
+
+void ff_h264_recon_queue_filter(H264ReconThread *rt, const H264SliceContext *sl,
+                                int start_x, int end_x, int finish_row)
+{
+    H264ReconMB *m = recon_thread_next(rt);
+
+    m->mb_x         = sl->mb_x;
+    m->mb_y         = sl->mb_y;
+    m->decoded      = 0;
+    m->filter_start = start_x;
+    m->filter_end   = end_x;
+    m->finish_row   = finish_row;
+    /* the parser may set it while this entry waits in the queue */
+    m->error_occurred = sl->h264->slice_ctx[0].er.error_occurred;
+
+    rt->written++;
+    recon_thread_publish(rt);
+}
+
+int ff_h264_recon_thread_finish(H264ReconThread *rt, int ret)
+{
+    if (!rt)
+        return ret;
+
+    pthread_mutex_lock(&rt->lock);
+    rt->queued = rt->written;
+    pthread_cond_signal(&rt->cond);
+    while (rt->done != rt->written)
+        pthread_cond_wait(&rt->done_cond, &rt->lock);
+    rt->done_seen = rt->done;
+    pthread_mutex_unlock(&rt->lock);
+
+    return ret;
+}
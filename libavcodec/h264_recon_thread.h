@@ -0,0 +1,105 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * H.264 macroblock reconstruction thread, used to reconstruct and loop
+ * filter a lone CABAC slice while it is being parsed.
+ */
+
+#ifndef AVCODEC_H264_RECON_THREAD_H
+#define AVCODEC_H264_RECON_THREAD_H
+
+#include "config.h"
+#include "h264.h"
+
+typedef struct H264ReconThread H264ReconThread;
+
+#if HAVE_THREADS
+/**
+ * Get the reconstruction thread of the decoder, starting it on first use.
+ * @return NULL if it could not be started
+ */
+H264ReconThread *ff_h264_recon_thread_get(H264Context *h);
+
+/**
+ * Stop the reconstruction thread, if any, and free it.
+ */
+void ff_h264_recon_thread_uninit(H264Context *h);
+
+/**
+ * Take a copy of the slice context the macroblocks of the slice about to be
+ * parsed will be reconstructed in.
+ */
+void ff_h264_recon_thread_start(H264ReconThread *rt, const H264Context *h,
+                                const H264SliceContext *sl);
+
+/**
+ * Hand the macroblock just parsed over to the reconstruction thread.
+ */
+void ff_h264_recon_queue_mb(H264ReconThread *rt, const H264Context *h,
+                            H264SliceContext *sl);
+
+/**
+ * Queue loop filtering the macroblocks start_x to end_x - 1 of the current
+ * row, followed by ff_h264_decode_finish_row() if finish_row is set.
+ */
+void ff_h264_recon_queue_filter(H264ReconThread *rt, const H264SliceContext *sl,
+                                int start_x, int end_x, int finish_row);
+
+/**
+ * Wait for the reconstruction thread to catch up with the parser.
+ * @return ret
+ */
+int ff_h264_recon_thread_finish(H264ReconThread *rt, int ret);
+#else
+static inline H264ReconThread *ff_h264_recon_thread_get(H264Context *h)
+{
+    return NULL;
+}
+
+static inline void ff_h264_recon_thread_uninit(H264Context *h)
+{
+}
+
+static inline void ff_h264_recon_thread_start(H264ReconThread *rt,
+                                              const H264Context *h,
+                                              const H264SliceContext *sl)
+{
+}
+
+static inline void ff_h264_recon_queue_mb(H264ReconThread *rt,
+                                          const H264Context *h,
+                                          H264SliceContext *sl)
+{
+}
+
+static inline void ff_h264_recon_queue_filter(H264ReconThread *rt,
+                                              const H264SliceContext *sl,
+                                              int start_x, int end_x,
+                                              int finish_row)
+{
+}
+
+static inline int ff_h264_recon_thread_finish(H264ReconThread *rt, int ret)
+{
+    return ret;
+}
+#endif /* HAVE_THREADS */
+
+#endif /* AVCODEC_H264_RECON_THREAD_H */
@@ -25,6 +25,8 @@
  * @author Michael Niedermayer <michaelni@gmx.at>
  */
 
+#include "config.h"
+
 #include "libavutil/avassert.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/timer.h"
@@ -37,6 +39,7 @@
 #include "h264data.h"
 #include "h264chroma.h"
 #include "h264_mvpred.h"
+#include "h264_recon_thread.h"
 #include "golomb.h"
 #include "mathops.h"
 #include "mpegutils.h"
@@ -2141,7 +2144,8 @@ static int fill_filter_caches(const H264Context *h, H264SliceContext *sl, int mb
     return 0;
 }
 
-static void loop_filter(const H264Context *h, H264SliceContext *sl, int start_x, int end_x)
+void ff_h264_loop_filter_row(const H264Context *h, H264SliceContext *sl,
+                             int start_x, int end_x)
 {
     uint8_t *dest_y, *dest_cb, *dest_cr;
     int linesize, uvlinesize, mb_x, mb_y;
@@ -2220,10 +2224,8 @@ static void predict_field_decoding_flag(const H264Context *h, H264SliceContext *
     sl->mb_mbaff    = sl->mb_field_decoding_flag = IS_INTERLACED(mb_type) ? 1 : 0;
 }
 
-/**
- * Draw edges and report progress for the last MB row.
- */
-static void decode_finish_row(const H264Context *h, H264SliceContext *sl)
+void ff_h264_decode_finish_row(const H264Context *h, H264SliceContext *sl,
+                               int error_occurred)
 {
     int top            = 16 * (sl->mb_y      >> FIELD_PICTURE(h));
     int pic_height     = 16 *  h->mb_height >> FIELD_PICTURE(h);
@@ -2247,7 +2249,7 @@ static void decode_finish_row(const H264Context *h, H264SliceContext *sl)
 
     ff_h264_draw_horiz_band(h, sl, top, height);
 
-    if (h->droppable || sl->h264->slice_ctx[0].er.error_occurred)
+    if (h->droppable || error_occurred)
         return;
 
     ff_thread_report_progress(&h->cur_pic_ptr->tf, top + height - 1,
@@ -2301,6 +2303,8 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
     }
 
     if (h->pps.cabac) {
+        H264ReconThread *rt = sl->is_complex ? NULL : sl->recon;
+
         /* realign */
         align_get_bits(&sl->gb);
 
@@ -2311,6 +2315,9 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
 
         ff_h264_init_cabac_states(h, sl);
 
+        if (rt)
+            ff_h264_recon_thread_start(rt, h, sl);
+
         for (;;) {
             // START_TIMER
             int ret, eos;
@@ -2320,14 +2327,18 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
                        sl->mb_index_end);
                 er_add_slice(sl, sl->resync_mb_x, sl->resync_mb_y, sl->mb_x,
                              sl->mb_y, ER_MB_ERROR);
-                return AVERROR_INVALIDDATA;
+                return ff_h264_recon_thread_finish(rt, AVERROR_INVALIDDATA);
             }
 
             ret = ff_h264_decode_mb_cabac(h, sl);
             // STOP_TIMER("decode_mb_cabac")
 
-            if (ret >= 0)
-                ff_h264_hl_decode_mb(h, sl);
+            if (ret >= 0) {
+                if (rt)
+                    ff_h264_recon_queue_mb(rt, h, sl);
+                else
+                    ff_h264_hl_decode_mb(h, sl);
+            }
 
             // FIXME optimal? or let mb_decode decode 16x32 ?
             if (ret >= 0 && FRAME_MBAFF(h)) {
@@ -2345,9 +2356,13 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
                 sl->cabac.bytestream > sl->cabac.bytestream_end + 2) {
                 er_add_slice(sl, sl->resync_mb_x, sl->resync_mb_y, sl->mb_x - 1,
                              sl->mb_y, ER_MB_END);
-                if (sl->mb_x >= lf_x_start)
-                    loop_filter(h, sl, lf_x_start, sl->mb_x + 1);
-                return 0;
+                if (sl->mb_x >= lf_x_start) {
+                    if (rt)
+                        ff_h264_recon_queue_filter(rt, sl, lf_x_start, sl->mb_x + 1, 0);
+                    else
+                        ff_h264_loop_filter_row(h, sl, lf_x_start, sl->mb_x + 1);
+                }
+                return ff_h264_recon_thread_finish(rt, 0);
             }
             if (sl->cabac.bytestream > sl->cabac.bytestream_end + 2 )
                 av_log(h->avctx, AV_LOG_DEBUG, "bytestream overread %"PTRDIFF_SPECIFIER"\n", sl->cabac.bytestream_end - sl->cabac.bytestream);
@@ -2358,13 +2373,19 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
                        sl->cabac.bytestream_end - sl->cabac.bytestream);
                 er_add_slice(sl, sl->resync_mb_x, sl->resync_mb_y, sl->mb_x,
                              sl->mb_y, ER_MB_ERROR);
-                return AVERROR_INVALIDDATA;
+                return ff_h264_recon_thread_finish(rt, AVERROR_INVALIDDATA);
             }
 
             if (++sl->mb_x >= h->mb_width) {
-                loop_filter(h, sl, lf_x_start, sl->mb_x);
-                sl->mb_x = lf_x_start = 0;
-                decode_finish_row(h, sl);
+                if (rt) {
+                    ff_h264_recon_queue_filter(rt, sl, lf_x_start, sl->mb_x, 1);
+                    sl->mb_x = lf_x_start = 0;
+                } else {
+                    ff_h264_loop_filter_row(h, sl, lf_x_start, sl->mb_x);
+                    sl->mb_x = lf_x_start = 0;
+                    ff_h264_decode_finish_row(h, sl,
+                                              h->slice_ctx[0].er.error_occurred);
+                }
                 ++sl->mb_y;
                 if (FIELD_OR_MBAFF_PICTURE(h)) {
                     ++sl->mb_y;
@@ -2378,9 +2399,13 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
                         get_bits_count(&sl->gb), sl->gb.size_in_bits);
                 er_add_slice(sl, sl->resync_mb_x, sl->resync_mb_y, sl->mb_x - 1,
                              sl->mb_y, ER_MB_END);
-                if (sl->mb_x > lf_x_start)
-                    loop_filter(h, sl, lf_x_start, sl->mb_x);
-                return 0;
+                if (sl->mb_x > lf_x_start) {
+                    if (rt)
+                        ff_h264_recon_queue_filter(rt, sl, lf_x_start, sl->mb_x, 0);
+                    else
+                        ff_h264_loop_filter_row(h, sl, lf_x_start, sl->mb_x);
+                }
+                return ff_h264_recon_thread_finish(rt, 0);
             }
         }
     } else {
@@ -2419,9 +2444,10 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
             }
 
             if (++sl->mb_x >= h->mb_width) {
-                loop_filter(h, sl, lf_x_start, sl->mb_x);
+                ff_h264_loop_filter_row(h, sl, lf_x_start, sl->mb_x);
                 sl->mb_x = lf_x_start = 0;
-                decode_finish_row(h, sl);
+                ff_h264_decode_finish_row(h, sl,
+                                          h->slice_ctx[0].er.error_occurred);
                 ++sl->mb_y;
                 if (FIELD_OR_MBAFF_PICTURE(h)) {
                     ++sl->mb_y;
@@ -2455,7 +2481,7 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
                     er_add_slice(sl, sl->resync_mb_x, sl->resync_mb_y,
                                  sl->mb_x - 1, sl->mb_y, ER_MB_END);
                     if (sl->mb_x > lf_x_start)
-                        loop_filter(h, sl, lf_x_start, sl->mb_x);
+                        ff_h264_loop_filter_row(h, sl, lf_x_start, sl->mb_x);
 
                     return 0;
                 } else {
@@ -2489,8 +2515,20 @@ int ff_h264_execute_decode_slices(H264Context *h, unsigned context_count)
         h->avctx->codec->capabilities & CODEC_CAP_HWACCEL_VDPAU)
         return 0;
     if (context_count == 1) {
-        int ret = decode_slice(avctx, &h->slice_ctx[0]);
-        h->mb_y = h->slice_ctx[0].mb_y;
+        int ret;
+
+        /* a lone slice leaves the slice threads idle, reconstruct its
+         * macroblocks on a separate thread while the next ones are parsed;
+         * draw_horiz_band() is called by the reconstruction, so keep it on
+         * the decoding thread when the user has set it */
+        sl = &h->slice_ctx[0];
+        if (avctx->active_thread_type & FF_THREAD_SLICE && h->pps.cabac &&
+            !avctx->draw_horiz_band)
+            sl->recon = ff_h264_recon_thread_get(h);
+
+        ret = decode_slice(avctx, sl);
+        sl->recon = NULL;
+        h->mb_y = sl->mb_y;
         return ret;
     } else {
         int j, mb_index;
@@ -50,32 +50,42 @@ const uint8_t ff_hevc_pel_weight[65] = { [2] = 0, [4] = 1, [6] = 2, [8] = 3, [12
  * Section 5.7
  */
 
+/* Alignment of the arrays carved out of the picture array arena, one cache
+ * line, so that arrays written by different threads never share a line. */
+#define PIC_ARRAY_ALIGN 64
+
+/* The per-picture arrays of the context, with their size in bytes. They all
+ * live in one arena that is kept across SPS changes and only reallocated
+ * when a larger picture needs more room. */
+#define PIC_ARRAYS(ARRAY)                                                     \
+    ARRAY(sao,                ctb_count * sizeof(*s->sao))                    \
+    ARRAY(deblock,            ctb_count * sizeof(*s->deblock))                \
+    ARRAY(filter_slice_edges, ctb_count)                                      \
+    ARRAY(skip_flag,          sps->min_cb_height * sps->min_cb_width)         \
+    ARRAY(tab_ct_depth,       sps->min_cb_height * sps->min_cb_width)         \
+    ARRAY(cbf_luma,           sps->min_tb_width * sps->min_tb_height)         \
+    ARRAY(tab_ipm,            min_pu_size)                                    \
+    ARRAY(is_pcm,             (sps->min_pu_width + 1) * (sps->min_pu_height + 1)) \
+    ARRAY(tab_slice_address,  pic_size_in_ctb * sizeof(*s->tab_slice_address)) \
+    ARRAY(qp_y_tab,           pic_size_in_ctb * sizeof(*s->qp_y_tab))         \
+    ARRAY(horizontal_bs,      s->bs_width * s->bs_height)                     \
+    ARRAY(vertical_bs,        s->bs_width * s->bs_height)
+
 /* free everything allocated  by pic_arrays_init() */
 static void pic_arrays_free(HEVCContext *s)
 {
-    av_freep(&s->sao);
-    av_freep(&s->deblock);
-
-    av_freep(&s->skip_flag);
-    av_freep(&s->tab_ct_depth);
-
-    av_freep(&s->tab_ipm);
-    av_freep(&s->cbf_luma);
-    av_freep(&s->is_pcm);
-
-    av_freep(&s->qp_y_tab);
-    av_freep(&s->tab_slice_address);
-    av_freep(&s->filter_slice_edges);
-
-    av_freep(&s->horizontal_bs);
-    av_freep(&s->vertical_bs);
+#define ARRAY_RESET(name, size) s->name = NULL;
+    PIC_ARRAYS(ARRAY_RESET)
+#undef ARRAY_RESET
+    av_freep(&s->pic_arrays_buf);
+    s->pic_arrays_size = 0;
 
     av_freep(&s->sh.entry_point_offset);
     av_freep(&s->sh.size);
     av_freep(&s->sh.offset);
 
-    av_buffer_pool_uninit(&s->tab_mvf_pool);
-    av_buffer_pool_uninit(&s->rpl_tab_pool);
+    av_buffer_pool_uninit(&s->frame_meta_pool);
+    s->frame_meta_size = 0;
 }
 
 /* allocate arrays that depend on frame dimensions */
@@ -84,49 +94,52 @@ static int pic_arrays_init(HEVCContext *s, const HEVCSPS *sps)
     int log2_min_cb_size = sps->log2_min_cb_size;
     int width            = sps->width;
     int height           = sps->height;
-    int pic_size_in_ctb  = ((width  >> log2_min_cb_size) + 1) *
-                           ((height >> log2_min_cb_size) + 1);
-    int ctb_count        = sps->ctb_width * sps->ctb_height;
-    int min_pu_size      = sps->min_pu_width * sps->min_pu_height;
+    size_t pic_size_in_ctb = ((width  >> log2_min_cb_size) + 1) *
+                             ((height >> log2_min_cb_size) + 1);
+    size_t ctb_count     = sps->ctb_width * sps->ctb_height;
+    size_t min_pu_size   = sps->min_pu_width * sps->min_pu_height;
+    size_t size = 0, tab_mvf_size, meta_size;
+    uint8_t *buf;
 
     s->bs_width  = (width  >> 2) + 1;
     s->bs_height = (height >> 2) + 1;
 
-    s->sao           = av_mallocz_array(ctb_count, sizeof(*s->sao));
-    s->deblock       = av_mallocz_array(ctb_count, sizeof(*s->deblock));
-    if (!s->sao || !s->deblock)
-        goto fail;
-
-    s->skip_flag    = av_malloc_array(sps->min_cb_height, sps->min_cb_width);
-    s->tab_ct_depth = av_malloc_array(sps->min_cb_height, sps->min_cb_width);
-    if (!s->skip_flag || !s->tab_ct_depth)
-        goto fail;
-
-    s->cbf_luma = av_malloc_array(sps->min_tb_width, sps->min_tb_height);
-    s->tab_ipm  = av_mallocz(min_pu_size);
-    s->is_pcm   = av_malloc_array(sps->min_pu_width + 1, sps->min_pu_height + 1);
-    if (!s->tab_ipm || !s->cbf_luma || !s->is_pcm)
-        goto fail;
-
-    s->filter_slice_edges = av_mallocz(ctb_count);
-    s->tab_slice_address  = av_malloc_array(pic_size_in_ctb,
-                                      sizeof(*s->tab_slice_address));
-    s->qp_y_tab           = av_malloc_array(pic_size_in_ctb,
-                                      sizeof(*s->qp_y_tab));
-    if (!s->qp_y_tab || !s->filter_slice_edges || !s->tab_slice_address)
-        goto fail;
-
-    s->horizontal_bs = av_mallocz_array(s->bs_width, s->bs_height);
-    s->vertical_bs   = av_mallocz_array(s->bs_width, s->bs_height);
-    if (!s->horizontal_bs || !s->vertical_bs)
-        goto fail;
-
-    s->tab_mvf_pool = av_buffer_pool_init(min_pu_size * sizeof(MvField),
-                                          av_buffer_allocz);
-    s->rpl_tab_pool = av_buffer_pool_init(ctb_count * sizeof(RefPicListTab),
-                                          av_buffer_allocz);
-    if (!s->tab_mvf_pool || !s->rpl_tab_pool)
-        goto fail;
+#define ARRAY_SIZE(name, array_size) size += FFALIGN(array_size, PIC_ARRAY_ALIGN);
+    PIC_ARRAYS(ARRAY_SIZE)
+#undef ARRAY_SIZE
+
+    if (size > s->pic_arrays_size) {
+        av_freep(&s->pic_arrays_buf);
+        s->pic_arrays_size = 0;
+        /* av_malloc() only aligns to the SIMD width, so leave room to move
+         * the start of the arena up to the next cache line */
+        s->pic_arrays_buf  = av_malloc(size + PIC_ARRAY_ALIGN - 1);
+        if (!s->pic_arrays_buf)
+            goto fail;
+        s->pic_arrays_size = size;
+    }
+
+    buf = (uint8_t *)FFALIGN((uintptr_t)s->pic_arrays_buf, PIC_ARRAY_ALIGN);
+    memset(buf, 0, size);
+#define ARRAY_SET(name, array_size)                                       \
+    s->name = (void *)buf;                                                \
+    buf    += FFALIGN(array_size, PIC_ARRAY_ALIGN);
+    PIC_ARRAYS(ARRAY_SET)
+#undef ARRAY_SET
+
+    /* the motion field and the slice reference list table of a frame share
+     * one pool buffer, so a frame thread hands both off with a single ref */
+    tab_mvf_size = FFALIGN(min_pu_size * sizeof(MvField), PIC_ARRAY_ALIGN);
+    meta_size    = tab_mvf_size + ctb_count * sizeof(RefPicListTab *);
+    if (meta_size > s->frame_meta_size) {
+        av_buffer_pool_uninit(&s->frame_meta_pool);
+        s->frame_meta_size = 0;
+        s->frame_meta_pool = av_buffer_pool_init(meta_size, av_buffer_allocz);
+        if (!s->frame_meta_pool)
+            goto fail;
+        s->frame_meta_size = meta_size;
+    }
+    s->frame_meta_rpl_offset = tab_mvf_size;
 
     return 0;
 
@@ -289,8 +302,8 @@ static void export_stream_params(AVCodecContext *avctx,
     avctx->pix_fmt             = sps->pix_fmt;
     avctx->coded_width         = sps->width;
     avctx->coded_height        = sps->height;
-    avctx->width               = sps->output_width;
-    avctx->height              = sps->output_height;
+    avctx->width               = FF_CEIL_RSHIFT(sps->output_width,  avctx->lowres);
+    avctx->height              = FF_CEIL_RSHIFT(sps->output_height, avctx->lowres);
     avctx->has_b_frames        = sps->temporal_layer[sps->max_sub_layers - 1].num_reorder_pics;
     avctx->profile             = sps->ptl.general_ptl.profile_idc;
     avctx->level               = sps->ptl.general_ptl.level_idc;
@@ -334,12 +347,14 @@ static int set_sps(HEVCContext *s, const HEVCSPS *sps, enum AVPixelFormat pix_fm
 
     export_stream_params(s->avctx, s, sps);
 
-    pic_arrays_free(s);
+    ff_hevc_deferred_filter_sync(s);
+    s->lowres = s->avctx->lowres;
     ret = pic_arrays_init(s, sps);
     if (ret < 0)
         goto fail;
 
-    if (sps->pix_fmt == AV_PIX_FMT_YUV420P || sps->pix_fmt == AV_PIX_FMT_YUVJ420P) {
+    if ((sps->pix_fmt == AV_PIX_FMT_YUV420P || sps->pix_fmt == AV_PIX_FMT_YUVJ420P) &&
+        !s->lowres) {
 #if CONFIG_HEVC_DXVA2_HWACCEL
         *fmt++ = AV_PIX_FMT_DXVA2_VLD;
 #endif
@@ -362,6 +377,8 @@ static int set_sps(HEVCContext *s, const HEVCSPS *sps, enum AVPixelFormat pix_fm
     }
 
     ff_hevc_pred_init(&s->hpc,     sps->bit_depth);
+    if (s->lowres)
+        ff_hevc_pred_init_lowres(&s->hpc, sps->bit_depth);
     ff_hevc_dsp_init (&s->hevcdsp, sps->bit_depth);
     ff_videodsp_init (&s->vdsp,    sps->bit_depth);
 
@@ -370,7 +387,7 @@ static int set_sps(HEVCContext *s, const HEVCSPS *sps, enum AVPixelFormat pix_fm
         av_freep(&s->sao_pixel_buffer_v[i]);
     }
 
-    if (sps->sao_enabled && !s->avctx->hwaccel) {
+    if (sps->sao_enabled && !s->avctx->hwaccel && !s->lowres) {
         int c_count = (sps->chroma_format_idc != 0) ? 3 : 1;
         int c_idx;
 
@@ -709,6 +726,7 @@ static int hls_slice_header(HEVCContext *s)
     }
 
     sh->num_entry_point_offsets = 0;
+    s->enable_parallel_tiles    = 0;
     if (s->pps->tiles_enabled_flag || s->pps->entropy_coding_sync_enabled_flag) {
         unsigned num_entry_point_offsets = get_ue_golomb_long(gb);
         // It would be possible to bound this tighter but this here is simpler
@@ -743,12 +761,21 @@ static int hls_slice_header(HEVCContext *s)
                 sh->entry_point_offset[i] = val + 1; // +1; // +1 to get the size
             }
             if (s->threads_number > 1 && (s->pps->num_tile_rows > 1 || s->pps->num_tile_columns > 1)) {
-                s->enable_parallel_tiles = 0; // TODO: you can enable tiles in parallel here
-                s->threads_number = 1;
-            } else
-                s->enable_parallel_tiles = 0;
-        } else
-            s->enable_parallel_tiles = 0;
+                if (s->pps->entropy_coding_sync_enabled_flag) {
+                    s->threads_number = 1;
+                } else {
+                    /* tiles are decoded in parallel when the independent
+                     * slice starts on a tile boundary, otherwise fall back
+                     * to decoding them in tile scan order */
+                    int ctb_addr_ts = s->pps->ctb_addr_rs_to_ts[sh->slice_segment_addr];
+                    s->enable_parallel_tiles =
+                        !sh->dependent_slice_segment_flag &&
+                        s->pps->tile_pos_rs[s->pps->tile_id[ctb_addr_ts]] == sh->slice_segment_addr &&
+                        s->pps->tile_id[ctb_addr_ts] + sh->num_entry_point_offsets <
+                            s->pps->num_tile_columns * s->pps->num_tile_rows;
+                }
+            }
+        }
     }
 
     if (s->pps->slice_header_extension_present_flag) {
@@ -881,6 +908,11 @@ static void hls_sao_param(HEVCContext *s, int rx, int ry)
             sao->offset_val[c_idx][i + 1] *= 1 << log2_sao_offset_scale;
         }
     }
+
+    if (s->sh.skip_sao) {
+        for (c_idx = 0; c_idx < 3; c_idx++)
+            sao->type_idx[c_idx] = SAO_NOT_APPLIED;
+    }
 }
 
 #undef SET_SAO
@@ -1007,7 +1039,7 @@ static int hls_transform_unit(HEVCContext *s, int x0, int y0,
                     ff_hevc_hls_residual_coding(s, x0, y0 + (i << log2_trafo_size_c),
                                                 log2_trafo_size_c, scan_idx_c, 1);
                 else
-                    if (lc->tu.cross_pf) {
+                    if (lc->tu.cross_pf && !s->lowres) {
                         ptrdiff_t stride = s->frame->linesize[1];
                         int hshift = s->sps->hshift[1];
                         int vshift = s->sps->vshift[1];
@@ -1036,7 +1068,7 @@ static int hls_transform_unit(HEVCContext *s, int x0, int y0,
                     ff_hevc_hls_residual_coding(s, x0, y0 + (i << log2_trafo_size_c),
                                                 log2_trafo_size_c, scan_idx_c, 2);
                 else
-                    if (lc->tu.cross_pf) {
+                    if (lc->tu.cross_pf && !s->lowres) {
                         ptrdiff_t stride = s->frame->linesize[2];
                         int hshift = s->sps->hshift[2];
                         int vshift = s->sps->vshift[2];
@@ -1246,17 +1278,44 @@ do {
     return 0;
 }
 
+static void put_pcm(HEVCContext *s, uint8_t *dst, ptrdiff_t stride,
+                    int width, int height, GetBitContext *gb, int pcm_bit_depth)
+{
+    if (s->lowres) {
+        // read the whole block and keep the last sample of each cell
+        uint8_t *tmp = s->HEVClc->edge_emu_buffer;
+        ptrdiff_t tmp_stride = width << s->sps->pixel_shift;
+        int phase = (1 << s->lowres) - 1;
+        int x, y;
+
+        s->hevcdsp.put_pcm(tmp, tmp_stride, width, height, gb, pcm_bit_depth);
+        tmp += phase * tmp_stride + (phase << s->sps->pixel_shift);
+        for (y = 0; y < height >> s->lowres; y++) {
+            const uint8_t *src = tmp + (y << s->lowres) * tmp_stride;
+            for (x = 0; x < width >> s->lowres; x++) {
+                if (s->sps->pixel_shift)
+                    AV_WN16(dst + 2 * x, AV_RN16(src + (2 * x << s->lowres)));
+                else
+                    dst[x] = src[x << s->lowres];
+            }
+            dst += stride;
+        }
+    } else {
+        s->hevcdsp.put_pcm(dst, stride, width, height, gb, pcm_bit_depth);
+    }
+}
+
 static int hls_pcm_sample(HEVCContext *s, int x0, int y0, int log2_cb_size)
 {
     HEVCLocalContext *lc = s->HEVClc;
     GetBitContext gb;
     int cb_size   = 1 << log2_cb_size;
     int stride0   = s->frame->linesize[0];
-    uint8_t *dst0 = &s->frame->data[0][y0 * stride0 + (x0 << s->sps->pixel_shift)];
+    uint8_t *dst0 = &s->frame->data[0][(y0 >> s->lowres) * stride0 + ((x0 >> s->lowres) << s->sps->pixel_shift)];
     int   stride1 = s->frame->linesize[1];
-    uint8_t *dst1 = &s->frame->data[1][(y0 >> s->sps->vshift[1]) * stride1 + ((x0 >> s->sps->hshift[1]) << s->sps->pixel_shift)];
+    uint8_t *dst1 = &s->frame->data[1][((y0 >> s->sps->vshift[1]) >> s->lowres) * stride1 + (((x0 >> s->sps->hshift[1]) >> s->lowres) << s->sps->pixel_shift)];
     int   stride2 = s->frame->linesize[2];
-    uint8_t *dst2 = &s->frame->data[2][(y0 >> s->sps->vshift[2]) * stride2 + ((x0 >> s->sps->hshift[2]) << s->sps->pixel_shift)];
+    uint8_t *dst2 = &s->frame->data[2][((y0 >> s->sps->vshift[2]) >> s->lowres) * stride2 + (((x0 >> s->sps->hshift[2]) >> s->lowres) << s->sps->pixel_shift)];
 
     int length         = cb_size * cb_size * s->sps->pcm.bit_depth +
                          (((cb_size >> s->sps->hshift[1]) * (cb_size >> s->sps->vshift[1])) +
@@ -1272,16 +1331,16 @@ static int hls_pcm_sample(HEVCContext *s, int x0, int y0, int log2_cb_size)
     if (ret < 0)
         return ret;
 
-    s->hevcdsp.put_pcm(dst0, stride0, cb_size, cb_size,     &gb, s->sps->pcm.bit_depth);
+    put_pcm(s, dst0, stride0, cb_size, cb_size,     &gb, s->sps->pcm.bit_depth);
     if (s->sps->chroma_format_idc) {
-        s->hevcdsp.put_pcm(dst1, stride1,
-                           cb_size >> s->sps->hshift[1],
-                           cb_size >> s->sps->vshift[1],
-                           &gb, s->sps->pcm.bit_depth_chroma);
-        s->hevcdsp.put_pcm(dst2, stride2,
-                           cb_size >> s->sps->hshift[2],
-                           cb_size >> s->sps->vshift[2],
-                           &gb, s->sps->pcm.bit_depth_chroma);
+        put_pcm(s, dst1, stride1,
+                cb_size >> s->sps->hshift[1],
+                cb_size >> s->sps->vshift[1],
+                &gb, s->sps->pcm.bit_depth_chroma);
+        put_pcm(s, dst2, stride2,
+                cb_size >> s->sps->hshift[2],
+                cb_size >> s->sps->vshift[2],
+                &gb, s->sps->pcm.bit_depth_chroma);
     }
 
     return 0;
@@ -1619,6 +1678,70 @@ static void hevc_await_progress(HEVCContext *s, HEVCFrame *ref,
         ff_thread_await_progress(&ref->tf, y, 0);
 }
 
+/**
+ * Approximate motion compensation for lowres decoding: the prediction is
+ * interpolated bilinearly from the downscaled reference pictures, with the
+ * motion vectors scaled down to their precision, and then weighted.
+ */
+static void hevc_lowres_mc(HEVCContext *s, int x0, int y0, int nPbW, int nPbH,
+                           const MvField *current_mv, HEVCFrame *ref0, HEVCFrame *ref1)
+{
+    HEVCLocalContext *lc = s->HEVClc;
+    int16_t *tmp[2]      = { lc->tmp, (int16_t *)lc->edge_emu_buffer };
+    HEVCFrame *ref[2]    = { ref0, ref1 };
+    int weight_flag      = (s->sh.slice_type == P_SLICE && s->pps->weighted_pred_flag) ||
+                           (s->sh.slice_type == B_SLICE && s->pps->weighted_bipred_flag);
+    int c_idx, i;
+
+    for (c_idx = 0; c_idx < (s->sps->chroma_format_idc ? 3 : 1); c_idx++) {
+        int hshift  = s->sps->hshift[c_idx] + s->lowres;
+        int vshift  = s->sps->vshift[c_idx] + s->lowres;
+        int x       = x0 >> hshift;
+        int y       = y0 >> vshift;
+        int width   = ((x0 + nPbW) >> hshift) - x;
+        int height  = ((y0 + nPbH) >> vshift) - y;
+        ptrdiff_t stride = s->frame->linesize[c_idx];
+        uint8_t *dst = &s->frame->data[c_idx][y * stride + (x << s->sps->pixel_shift)];
+        int denom = 0, wx[2] = { 1, 1 }, ox[2] = { 0, 0 };
+        int nb_refs = 0;
+
+        if (width <= 0 || height <= 0)
+            continue;
+
+        for (i = 0; i < 2; i++) {
+            const Mv *mv = &current_mv->mv[i];
+            int ref_idx  = current_mv->ref_idx[i];
+
+            if (!(current_mv->pred_flag & (PF_L0 << i)))
+                continue;
+
+            s->hevcdsp.put_hevc_lowres(tmp[nb_refs], ref[i]->frame->data[c_idx],
+                                       ref[i]->frame->linesize[c_idx],
+                                       s->sps->width >> hshift, s->sps->height >> vshift,
+                                       (x << (2 + hshift)) + mv->x,
+                                       (y << (2 + vshift)) + mv->y,
+                                       2 + hshift, 2 + vshift, width, height);
+            if (weight_flag) {
+                if (!c_idx) {
+                    denom       = s->sh.luma_log2_weight_denom;
+                    wx[nb_refs] = i ? s->sh.luma_weight_l1[ref_idx] : s->sh.luma_weight_l0[ref_idx];
+                    ox[nb_refs] = i ? s->sh.luma_offset_l1[ref_idx] : s->sh.luma_offset_l0[ref_idx];
+                } else {
+                    denom       = s->sh.chroma_log2_weight_denom;
+                    wx[nb_refs] = i ? s->sh.chroma_weight_l1[ref_idx][c_idx - 1] :
+                                      s->sh.chroma_weight_l0[ref_idx][c_idx - 1];
+                    ox[nb_refs] = i ? s->sh.chroma_offset_l1[ref_idx][c_idx - 1] :
+                                      s->sh.chroma_offset_l0[ref_idx][c_idx - 1];
+                }
+            }
+            nb_refs++;
+        }
+
+        s->hevcdsp.put_hevc_lowres_w(dst, stride, tmp[0], nb_refs > 1 ? tmp[1] : NULL,
+                                     width, height, denom, wx[0], wx[1], ox[0], ox[1]);
+    }
+}
+
 static void hevc_luma_mv_mpv_mode(HEVCContext *s, int x0, int y0, int nPbW,
                                   int nPbH, int log2_cb_size, int part_idx,
                                   int merge_idx, MvField *mv)
@@ -1728,6 +1851,11 @@ static void hls_prediction_unit(HEVCContext *s, int x0, int y0,
         hevc_await_progress(s, ref1, &current_mv.mv[1], y0, nPbH);
     }
 
+    if (s->lowres) {
+        hevc_lowres_mc(s, x0, y0, nPbW, nPbH, &current_mv, ref0, ref1);
+        return;
+    }
+
     if (current_mv.pred_flag == PF_L0) {
         int x0_c = x0 >> s->sps->hshift[1];
         int y0_c = y0 >> s->sps->vshift[1];
@@ -2321,10 +2449,15 @@ static int hls_decode_entry(AVCodecContext *avctxt, void *isFilterThread)
 
         ctb_addr_ts++;
         ff_hevc_save_states(s, ctb_addr_ts);
-        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+        if (s->filter_deferred) {
+            if (x_ctb + ctb_size >= s->sps->width)
+                ff_hevc_deferred_filter_row(s, y_ctb >> s->sps->log2_ctb_size);
+        } else
+            ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
     }
 
-    if (x_ctb + ctb_size >= s->sps->width &&
+    if (!s->filter_deferred &&
+        x_ctb + ctb_size >= s->sps->width &&
         y_ctb + ctb_size >= s->sps->height)
         ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
 
@@ -2417,6 +2550,105 @@ static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *input_ctb_row, int
     return 0;
 }
 
+static int hls_decode_entry_tile(AVCodecContext *avctxt, void *input_tile, int job, int self_id)
+{
+    HEVCContext *s1  = avctxt->priv_data, *s;
+    HEVCLocalContext *lc;
+    int more_data   = 1;
+    int *tile_p     = input_tile;
+    int tile        = tile_p[job];
+    int ctb_addr_rs = s1->pps->tile_pos_rs[tile];
+    int ctb_addr_ts = s1->pps->ctb_addr_rs_to_ts[ctb_addr_rs];
+    int ret;
+
+    s  = s1->sList[self_id];
+    lc = s->HEVClc;
+
+    if (job) {
+        ret = init_get_bits8(&lc->gb, s->data + s->sh.offset[job - 1], s->sh.size[job - 1]);
+        if (ret < 0)
+            return ret;
+    }
+
+    lc->end_of_tiles_x = (ctb_addr_rs % s->sps->ctb_width +
+                          s->pps->column_width[tile % s->pps->num_tile_columns]) << s->sps->log2_ctb_size;
+
+    while (more_data && ctb_addr_ts < s->sps->ctb_size &&
+           s->pps->tile_id[ctb_addr_ts] == tile) {
+        int x_ctb, y_ctb;
+
+        ctb_addr_rs = s->pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+        x_ctb       = (ctb_addr_rs % s->sps->ctb_width) << s->sps->log2_ctb_size;
+        y_ctb       = (ctb_addr_rs / s->sps->ctb_width) << s->sps->log2_ctb_size;
+
+        if (avpriv_atomic_int_get(&s1->wpp_err))
+            return 0;
+
+        hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
+
+        ff_hevc_cabac_init(s, ctb_addr_ts);
+
+        hls_sao_param(s, x_ctb >> s->sps->log2_ctb_size, y_ctb >> s->sps->log2_ctb_size);
+
+        s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
+        s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
+        s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
+
+        more_data = hls_coding_quadtree(s, x_ctb, y_ctb, s->sps->log2_ctb_size, 0);
+        if (more_data < 0) {
+            s->tab_slice_address[ctb_addr_rs] = -1;
+            avpriv_atomic_int_set(&s1->wpp_err, 1);
+            return more_data;
+        }
+
+        ctb_addr_ts++;
+    }
+
+    /* only the last tile of the slice segment may end the slice segment */
+    if (job == s->sh.num_entry_point_offsets)
+        return ctb_addr_ts;
+    if (!more_data) {
+        avpriv_atomic_int_set(&s1->wpp_err, 1);
+        return AVERROR_INVALIDDATA;
+    }
+    return 0;
+}
+
+/**
+ * Run the in-loop filters over the CTBs of a slice segment that was
+ * decoded with parallel tiles. Tile edges are only known once both
+ * neighbouring tiles are done, so their boundary strengths and the whole
+ * deblocking/SAO pass are deferred and replayed here in tile scan order,
+ * matching the sequence hls_decode_entry() would have produced.
+ */
+static void hls_filter_tiles(HEVCContext *s, int ctb_addr_ts_start, int ctb_addr_ts_end)
+{
+    int ctb_size = 1 << s->sps->log2_ctb_size;
+    int x_ctb    = 0;
+    int y_ctb    = 0;
+    int ctb_addr_ts;
+
+    if (!s->sh.disable_deblocking_filter_flag) {
+        for (ctb_addr_ts = ctb_addr_ts_start; ctb_addr_ts < ctb_addr_ts_end; ctb_addr_ts++) {
+            int ctb_addr_rs = s->pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+            ff_hevc_deblocking_boundary_strengths_tile_edges(s,
+                (ctb_addr_rs % s->sps->ctb_width) << s->sps->log2_ctb_size,
+                (ctb_addr_rs / s->sps->ctb_width) << s->sps->log2_ctb_size);
+        }
+    }
+
+    for (ctb_addr_ts = ctb_addr_ts_start; ctb_addr_ts < ctb_addr_ts_end; ctb_addr_ts++) {
+        int ctb_addr_rs = s->pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+        x_ctb = (ctb_addr_rs % s->sps->ctb_width) << s->sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / s->sps->ctb_width) << s->sps->log2_ctb_size;
+        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+    }
+
+    if (x_ctb + ctb_size >= s->sps->width &&
+        y_ctb + ctb_size >= s->sps->height)
+        ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
+}
+
 static int hls_slice_data_wpp(HEVCContext *s, const uint8_t *nal, int length)
 {
     HEVCLocalContext *lc = s->HEVClc;
@@ -2433,10 +2665,14 @@ static int hls_slice_data_wpp(HEVCContext *s, const uint8_t *nal, int length)
     }
 
 
-    if (!s->sList[1]) {
-        ff_alloc_entries(s->avctx, s->sh.num_entry_point_offsets + 1);
-
+    res = ff_alloc_entries(s->avctx, s->sh.num_entry_point_offsets + 1);
+    if (res < 0) {
+        av_free(ret);
+        av_free(arg);
+        return res;
+    }
 
+    if (!s->sList[1]) {
         for (i = 1; i < s->threads_number; i++) {
             s->sList[i] = av_malloc(sizeof(HEVCContext));
             memcpy(s->sList[i], s, sizeof(HEVCContext));
@@ -2485,16 +2721,45 @@ static int hls_slice_data_wpp(HEVCContext *s, const uint8_t *nal, int length)
     avpriv_atomic_int_set(&s->wpp_err, 0);
     ff_reset_entries(s->avctx);
 
-    for (i = 0; i <= s->sh.num_entry_point_offsets; i++) {
-        arg[i] = i;
-        ret[i] = 0;
-    }
+    if (s->enable_parallel_tiles) {
+        int ctb_addr_ts = s->pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+        int first_tile  = s->pps->tile_id[ctb_addr_ts];
+        int ctb_addr_ts_end;
+
+        for (i = 0; i <= s->sh.num_entry_point_offsets; i++) {
+            arg[i] = first_tile + i;
+            ret[i] = 0;
+        }
+
+        /* neighbouring tiles of the same slice are read while decoding,
+         * so mark them all as belonging to it beforehand */
+        for (ctb_addr_ts_end = ctb_addr_ts;
+             ctb_addr_ts_end < s->sps->ctb_size &&
+             s->pps->tile_id[ctb_addr_ts_end] <= first_tile + s->sh.num_entry_point_offsets;
+             ctb_addr_ts_end++)
+            s->tab_slice_address[s->pps->ctb_addr_ts_to_rs[ctb_addr_ts_end]] = s->sh.slice_addr;
+
+        s->avctx->execute2(s->avctx, (void *) hls_decode_entry_tile, arg, ret, s->sh.num_entry_point_offsets + 1);
+
+        res = ret[s->sh.num_entry_point_offsets];
+        for (i = 0; i < s->sh.num_entry_point_offsets; i++)
+            if (ret[i] < 0)
+                res = ret[i];
 
-    if (s->pps->entropy_coding_sync_enabled_flag)
-        s->avctx->execute2(s->avctx, (void *) hls_decode_entry_wpp, arg, ret, s->sh.num_entry_point_offsets + 1);
+        if (res > 0)
+            hls_filter_tiles(s, ctb_addr_ts, res);
+    } else {
+        for (i = 0; i <= s->sh.num_entry_point_offsets; i++) {
+            arg[i] = i;
+            ret[i] = 0;
+        }
+
+        if (s->pps->entropy_coding_sync_enabled_flag)
+            s->avctx->execute2(s->avctx, (void *) hls_decode_entry_wpp, arg, ret, s->sh.num_entry_point_offsets + 1);
 
-    for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
-        res += ret[i];
+        for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
+            res += ret[i];
+    }
     av_free(ret);
     av_free(arg);
     return res;
@@ -2575,6 +2840,39 @@ static int set_side_data(HEVCContext *s)
     return 0;
 }
 
+/**
+ * @return 1 if no other picture may use the current one for reference:
+ * a sub-layer non-reference picture of the highest sub-layer, or a RASL
+ * picture, which only other RASL pictures can reference
+ */
+static int hevc_is_nonref(HEVCContext *s)
+{
+    switch (s->nal_unit_type) {
+    case NAL_RASL_N:
+    case NAL_RASL_R:
+        return 1;
+    case NAL_TRAIL_N:
+    case NAL_TSA_N:
+    case NAL_STSA_N:
+    case NAL_RADL_N:
+        return s->temporal_id == s->sps->max_sub_layers - 1;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @return 1 if the current slice is discarded at the given AVDiscard level
+ */
+static int hevc_discard_slice(HEVCContext *s, enum AVDiscard skip)
+{
+    return skip >= AVDISCARD_ALL ||
+           (skip >= AVDISCARD_NONKEY   && !IS_IRAP(s)) ||
+           (skip >= AVDISCARD_NONINTRA && s->sh.slice_type != I_SLICE) ||
+           (skip >= AVDISCARD_BIDIR    && s->sh.slice_type == B_SLICE) ||
+           (skip >= AVDISCARD_NONREF   && hevc_is_nonref(s));
+}
+
 static int hevc_frame_start(HEVCContext *s)
 {
     HEVCLocalContext *lc = s->HEVClc;
@@ -2612,6 +2910,14 @@ static int hevc_frame_start(HEVCContext *s)
 
     s->frame->pict_type = 3 - s->sh.slice_type;
 
+    /* bands come in decoding order, which is the display order only when
+     * the stream does not reorder pictures; checked before the picture
+     * can be output and lose its output flag below */
+    s->draw_bands = s->avctx->draw_horiz_band && !s->avctx->hwaccel &&
+                    (s->ref->flags & HEVC_FRAME_FLAG_OUTPUT) &&
+                    ((s->avctx->slice_flags & SLICE_FLAG_CODED_ORDER) ||
+                     !s->sps->temporal_layer[s->sps->max_sub_layers - 1].num_reorder_pics);
+
     if (!IS_IRAP(s))
         ff_hevc_bump_frame(s);
 
@@ -2620,6 +2926,10 @@ static int hevc_frame_start(HEVCContext *s)
     if (ret < 0)
         goto fail;
 
+    ret = ff_hevc_deferred_filter_start(s);
+    if (ret < 0)
+        goto fail;
+
     if (!s->avctx->hwaccel)
         ff_thread_finish_setup(s->avctx);
 
@@ -2688,6 +2998,9 @@ static int decode_nal_unit(HEVCContext *s, const HEVCNAL *nal)
     case NAL_RADL_R:
     case NAL_RASL_N:
     case NAL_RASL_R:
+        if (show_bits1(gb)) // first_slice_segment_in_pic_flag
+            ff_hevc_deferred_filter_sync(s);
+
         ret = hls_slice_header(s);
         if (ret < 0)
             return ret;
@@ -2710,6 +3023,22 @@ static int decode_nal_unit(HEVCContext *s, const HEVCNAL *nal)
                 s->max_ra = INT_MIN;
         }
 
+        /* skip_frame is decided on the first slice for the whole picture,
+         * so that the other slices do not land in a missing frame */
+        if (s->sh.first_slice_in_pic_flag)
+            s->skip_pic = hevc_discard_slice(s, s->avctx->skip_frame);
+        if (s->skip_pic) {
+            s->is_decoded = 0;
+            break;
+        }
+
+        if (hevc_discard_slice(s, s->avctx->skip_loop_filter)) {
+            s->sh.disable_deblocking_filter_flag = 1;
+            s->sh.skip_sao                       = 1;
+        } else {
+            s->sh.skip_sao = hevc_discard_slice(s, s->skip_sao);
+        }
+
         if (s->sh.first_slice_in_pic_flag) {
             ret = hevc_frame_start(s);
             if (ret < 0)
@@ -2747,7 +3076,8 @@ static int decode_nal_unit(HEVCContext *s, const HEVCNAL *nal)
             if (ret < 0)
                 goto fail;
         } else {
-            if (s->threads_number > 1 && s->sh.num_entry_point_offsets > 0)
+            if (s->threads_number > 1 && s->sh.num_entry_point_offsets > 0 &&
+                (s->pps->entropy_coding_sync_enabled_flag || s->enable_parallel_tiles))
                 ctb_addr_ts = hls_slice_data_wpp(s, nal->data, nal->size);
             else
                 ctb_addr_ts = hls_slice_data(s);
@@ -3015,6 +3345,7 @@ static int decode_nal_units(HEVCContext *s, const uint8_t *buf, int length)
     }
 
 fail:
+    ff_hevc_deferred_filter_sync(s);
     if (s->ref && s->threads_type == FF_THREAD_FRAME)
         ff_thread_report_progress(&s->ref->tf, INT_MAX, 0);
 
@@ -3119,9 +3450,9 @@ static int hevc_decode_frame(AVCodecContext *avctx, void *data, int *got_output,
             av_log(avctx, AV_LOG_ERROR,
                    "hardware accelerator failed to decode picture\n");
     } else {
-        /* verify the SEI checksum */
+        /* verify the SEI checksum, which lowres pictures cannot match */
         if (avctx->err_recognition & AV_EF_CRCCHECK && s->is_decoded &&
-            s->is_md5) {
+            s->is_md5 && !s->lowres) {
             ret = verify_md5(s, s->ref->frame);
             if (ret < 0 && avctx->err_recognition & AV_EF_EXPLODE) {
                 ff_hevc_unref_frame(s, s->ref, ~0);
@@ -3152,14 +3483,10 @@ static int hevc_ref_frame(HEVCContext *s, HEVCFrame *dst, HEVCFrame *src)
     if (ret < 0)
         return ret;
 
-    dst->tab_mvf_buf = av_buffer_ref(src->tab_mvf_buf);
-    if (!dst->tab_mvf_buf)
+    dst->meta_buf = av_buffer_ref(src->meta_buf);
+    if (!dst->meta_buf)
         goto fail;
     dst->tab_mvf = src->tab_mvf;
-
-    dst->rpl_tab_buf = av_buffer_ref(src->rpl_tab_buf);
-    if (!dst->rpl_tab_buf)
-        goto fail;
     dst->rpl_tab = src->rpl_tab;
 
     dst->rpl_buf = av_buffer_ref(src->rpl_buf);
@@ -3171,6 +3498,7 @@ static int hevc_ref_frame(HEVCContext *s, HEVCFrame *dst, HEVCFrame *src)
     dst->window     = src->window;
     dst->flags      = src->flags;
     dst->sequence   = src->sequence;
+    dst->latency_count = src->latency_count;
 
     if (src->hwaccel_picture_private) {
         dst->hwaccel_priv_buf = av_buffer_ref(src->hwaccel_priv_buf);
@@ -3190,6 +3518,13 @@ static av_cold int hevc_decode_free(AVCodecContext *avctx)
     HEVCContext       *s = avctx->priv_data;
     int i;
 
+    /* the frame thread copies pass their peak on to the next thread, the
+     * user context is the one which reports it */
+    if (s->dpb_peak && !avctx->internal->is_copy)
+        av_log(avctx, s->bounded_dpb ? AV_LOG_INFO : AV_LOG_VERBOSE,
+               "Peak DPB usage: %d pictures, %"SIZE_SPECIFIER" kB of picture buffers\n",
+               s->dpb_peak, s->dpb_peak_size >> 10);
+
     pic_arrays_free(s);
 
     av_freep(&s->md5_ctx);
@@ -3228,7 +3563,10 @@ static av_cold int hevc_decode_free(AVCodecContext *avctx)
     av_freep(&s->sh.offset);
     av_freep(&s->sh.size);
 
-    for (i = 1; i < s->threads_number; i++) {
+    ff_slice_thread_free_nested(avctx);
+    ff_hevc_deferred_filter_uninit(s);
+
+    for (i = 1; i < MAX_NB_THREADS; i++) {
         HEVCLocalContext *lc = s->HEVClcList[i];
         if (lc) {
             av_freep(&s->HEVClcList[i]);
@@ -3350,6 +3688,8 @@ static int hevc_update_thread_context(AVCodecContext *dst,
 
     s->seq_decode = s0->seq_decode;
     s->seq_output = s0->seq_output;
+    s->dpb_peak      = FFMAX(s->dpb_peak,      s0->dpb_peak);
+    s->dpb_peak_size = FFMAX(s->dpb_peak_size, s0->dpb_peak_size);
     s->pocTid0    = s0->pocTid0;
     s->max_ra     = s0->max_ra;
     s->eos        = s0->eos;
@@ -3442,6 +3782,26 @@ static int hevc_decode_extradata(HEVCContext *s)
     return 0;
 }
 
+/**
+ * With frame threading, each frame thread may additionally decode WPP rows
+ * and tiles of its frame on a private pool of slice threads.
+ */
+static av_cold int hevc_init_slice_threads(AVCodecContext *avctx)
+{
+    HEVCContext *s = avctx->priv_data;
+    int ret;
+
+    if (!(avctx->active_thread_type & FF_THREAD_FRAME) || s->slice_threads <= 1)
+        return 0;
+
+    ret = ff_slice_thread_init_nested(avctx, s->slice_threads);
+    if (ret < 0)
+        return ret;
+
+    s->threads_number = s->slice_threads;
+    return 0;
+}
+
 static av_cold int hevc_decode_init(AVCodecContext *avctx)
 {
     HEVCContext *s = avctx->priv_data;
@@ -3476,21 +3836,33 @@ static av_cold int hevc_decode_init(AVCodecContext *avctx)
         else
             s->threads_type = FF_THREAD_SLICE;
 
+    ret = hevc_init_slice_threads(avctx);
+    if (ret < 0) {
+        hevc_decode_free(avctx);
+        return ret;
+    }
+
     return 0;
 }
 
 static av_cold int hevc_init_thread_copy(AVCodecContext *avctx)
 {
     HEVCContext *s = avctx->priv_data;
+    int slice_threads   = s->slice_threads;
+    int deferred_filter = s->deferred_filter;
+    int skip_sao        = s->skip_sao;
     int ret;
 
     memset(s, 0, sizeof(*s));
+    s->slice_threads   = slice_threads;
+    s->deferred_filter = deferred_filter;
+    s->skip_sao        = skip_sao;
 
     ret = hevc_init_context(avctx);
     if (ret < 0)
         return ret;
 
-    return 0;
+    return hevc_init_slice_threads(avctx);
 }
 
 static void hevc_decode_flush(AVCodecContext *avctx)
@@ -3516,6 +3888,21 @@ static const AVOption options[] = {
         AV_OPT_TYPE_INT, {.i64 = 0}, 0, 1, PAR },
     { "strict-displaywin", "stricly apply default display window size", OFFSET(apply_defdispwin),
         AV_OPT_TYPE_INT, {.i64 = 0}, 0, 1, PAR },
+    { "slice_threads", "WPP/tile threads per frame thread when frame threading, taken from the thread budget",
+        OFFSET(slice_threads), AV_OPT_TYPE_INT, {.i64 = 0}, 0, MAX_NB_THREADS, PAR },
+    { "deferred_filter", "run deblocking and SAO on their own thread, this many CTB rows behind parsing (0 filters inline)",
+        OFFSET(deferred_filter), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 2, PAR },
+    { "bounded_dpb", "output pictures as early as the DPB rules allow, so that no more than the signalled DPB size is held",
+        OFFSET(bounded_dpb), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 1, PAR },
+    { "skip_sao", "skip SAO for the selected frames, deblocking is still done (see skip_loop_filter)",
+        OFFSET(skip_sao), AV_OPT_TYPE_INT, {.i64 = AVDISCARD_DEFAULT}, INT_MIN, INT_MAX, PAR, "avdiscard" },
+    { "none",    "discard no frame",                    0, AV_OPT_TYPE_CONST, {.i64 = AVDISCARD_NONE     }, INT_MIN, INT_MAX, PAR, "avdiscard" },
+    { "default", "discard useless frames",              0, AV_OPT_TYPE_CONST, {.i64 = AVDISCARD_DEFAULT  }, INT_MIN, INT_MAX, PAR, "avdiscard" },
+    { "noref",   "discard all non-reference frames",    0, AV_OPT_TYPE_CONST, {.i64 = AVDISCARD_NONREF   }, INT_MIN, INT_MAX, PAR, "avdiscard" },
+    { "bidir",   "discard all bidirectional frames",    0, AV_OPT_TYPE_CONST, {.i64 = AVDISCARD_BIDIR    }, INT_MIN, INT_MAX, PAR, "avdiscard" },
+    { "nointra", "discard all frames except I frames",  0, AV_OPT_TYPE_CONST, {.i64 = AVDISCARD_NONINTRA }, INT_MIN, INT_MAX, PAR, "avdiscard" },
+    { "nokey",   "discard all frames except keyframes", 0, AV_OPT_TYPE_CONST, {.i64 = AVDISCARD_NONKEY   }, INT_MIN, INT_MAX, PAR, "avdiscard" },
+    { "all",     "discard all frames",                  0, AV_OPT_TYPE_CONST, {.i64 = AVDISCARD_ALL      }, INT_MIN, INT_MAX, PAR, "avdiscard" },
     { NULL },
 };
 
@@ -3539,7 +3926,8 @@ AVCodec ff_hevc_decoder = {
     .flush                 = hevc_decode_flush,
     .update_thread_context = hevc_update_thread_context,
     .init_thread_copy      = hevc_init_thread_copy,
-    .capabilities          = CODEC_CAP_DR1 | CODEC_CAP_DELAY |
+    .capabilities          = CODEC_CAP_DR1 | CODEC_CAP_DELAY | CODEC_CAP_DRAW_HORIZ_BAND |
                              CODEC_CAP_SLICE_THREADS | CODEC_CAP_FRAME_THREADS,
+    .max_lowres            = 2,
     .profiles              = NULL_IF_CONFIG_SMALL(profiles),
 };
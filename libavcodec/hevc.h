@@ -631,6 +631,8 @@ typedef struct SliceHeader {
     int16_t chroma_offset_l1[16][2];
 
     int slice_ctb_addr_rs;
+
+    uint8_t skip_sao;       ///< SAO parameters are parsed but not applied
 } SliceHeader;
 
 typedef struct CodingUnit {
@@ -714,8 +716,7 @@ typedef struct HEVCFrame {
 
     HEVCWindow window;
 
-    AVBufferRef *tab_mvf_buf;
-    AVBufferRef *rpl_tab_buf;
+    AVBufferRef *meta_buf;  ///< holds tab_mvf and rpl_tab
     AVBufferRef *rpl_buf;
 
     AVBufferRef *hwaccel_priv_buf;
@@ -731,6 +732,12 @@ typedef struct HEVCFrame {
      * A combination of HEVC_FRAME_FLAG_*
      */
     uint8_t flags;
+
+    /**
+     * Pictures decoded after this one which precede it in output order,
+     * PicLatencyCount of C.5.2.3
+     */
+    int latency_count;
 } HEVCFrame;
 
 typedef struct HEVCNAL {
@@ -799,6 +806,9 @@ typedef struct HEVCContext {
     uint8_t             threads_type;
     uint8_t             threads_number;
 
+    struct HEVCFilterThread *filter_thread;
+    uint8_t             filter_deferred; ///< in-loop filters of the current frame run on filter_thread
+
     int                 width;
     int                 height;
 
@@ -819,8 +829,12 @@ typedef struct HEVCContext {
     AVBufferRef *sps_list[MAX_SPS_COUNT];
     AVBufferRef *pps_list[MAX_PPS_COUNT];
 
-    AVBufferPool *tab_mvf_pool;
-    AVBufferPool *rpl_tab_pool;
+    AVBufferPool *frame_meta_pool;   ///< per-frame tab_mvf and rpl_tab buffers
+    size_t        frame_meta_size;   ///< size of the frame_meta_pool buffers
+    size_t        frame_meta_rpl_offset; ///< offset of rpl_tab in a frame_meta_pool buffer
+
+    uint8_t *pic_arrays_buf;         ///< arena holding the per-picture arrays below
+    size_t   pic_arrays_size;
 
     ///< candidate references for the current frame
     RefPicList rps[5];
@@ -893,6 +907,15 @@ typedef struct HEVCContext {
     int nals_allocated;
     // type of the first VCL NAL of the current frame
     enum NALUnitType first_nal_type;
+    uint8_t skip_pic;       ///< the current picture is dropped by skip_frame
+    uint8_t draw_bands;     ///< pass the filtered rows of the current picture to draw_horiz_band()
+    /**
+     * log2 of the downscaling of the decoded pictures (AVCodecContext.lowres).
+     * Lowres decoding is approximate: MC, intra prediction and the residual
+     * are reconstructed at the reduced size and the in-loop filters are
+     * skipped, so the output drifts from the conformant one.
+     */
+    uint8_t lowres;
 
     // for checking the frame checksums
     struct AVMD5 *md5_ctx;
@@ -903,6 +926,13 @@ typedef struct HEVCContext {
     uint8_t is_nalff;       ///< this flag is != 0 if bitstream is encapsulated
                             ///< as a format defined in 14496-15
     int apply_defdispwin;
+    int slice_threads;      ///< slice threads run inside each frame thread
+    int deferred_filter;    ///< CTB rows the filter thread lags behind parsing, 0 to filter inline
+    int skip_sao;           ///< AVDiscard level of the slices whose SAO is skipped
+    int bounded_dpb;        ///< bump pictures out of the DPB as soon as C.5.2.2 allows
+
+    int dpb_peak;           ///< largest number of pictures held in the DPB
+    size_t dpb_peak_size;   ///< largest size of the picture buffers held in the DPB
 
     int active_seq_parameter_set_id;
 
@@ -1024,12 +1054,32 @@ void ff_hevc_set_qPy(HEVCContext *s, int xBase, int yBase,
                      int log2_cb_size);
 void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                                            int log2_trafo_size);
+void ff_hevc_deblocking_boundary_strengths_tile_edges(HEVCContext *s, int x0, int y0);
 int ff_hevc_cu_qp_delta_sign_flag(HEVCContext *s);
 int ff_hevc_cu_qp_delta_abs(HEVCContext *s);
 int ff_hevc_cu_chroma_qp_offset_flag(HEVCContext *s);
 int ff_hevc_cu_chroma_qp_offset_idx(HEVCContext *s);
 void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size);
 void ff_hevc_hls_filters(HEVCContext *s, int x_ctb, int y_ctb, int ctb_size);
+
+/**
+ * Decide whether the in-loop filters of the current frame run on the
+ * filter thread, starting it if needed. Called once s->ref is set up.
+ */
+int ff_hevc_deferred_filter_start(HEVCContext *s);
+
+/**
+ * Signal that CTB row ctb_row of the current frame has been parsed and
+ * reconstructed.
+ */
+void ff_hevc_deferred_filter_row(HEVCContext *s, int ctb_row);
+
+/**
+ * Wait until all signalled rows have been filtered.
+ */
+void ff_hevc_deferred_filter_sync(HEVCContext *s);
+
+void ff_hevc_deferred_filter_uninit(HEVCContext *s);
 void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
                                  int log2_trafo_size, enum ScanType scan_idx,
                                  int c_idx);
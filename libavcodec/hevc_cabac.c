@@ -23,12 +23,19 @@
 
 #include "libavutil/attributes.h"
 #include "libavutil/common.h"
+#include "libavutil/intmath.h"
 
 #include "cabac_functions.h"
 #include "hevc.h"
 
 #define CABAC_MAX_BIN 31
 
+/**
+ * Maximum number of bypass bins decoded in one go by get_cabac_bypass_bins();
+ * low < range << (CABAC_BITS + 1) < 1 << 26, so low << 6 still fits 32 bits.
+ */
+#define CABAC_BYPASS_CHUNK 6
+
 /**
  * number of bin by SyntaxElement.
  */
@@ -497,6 +504,37 @@ static const uint8_t diag_scan8x8_inv[8][8] = {
     { 28, 36, 43, 49, 54, 58, 61, 63, },
 };
 
+/**
+ * significant_coeff_flag context increments, indexed by scan type, context
+ * map and scan position within the 4x4 sub-block, so that the decoding loop
+ * does not have to map the scan position back to x/y first.
+ * The maps are the 4x4 transform one, one per prev_sig value for the larger
+ * transforms, and the transform skip context one.
+ */
+static const uint8_t sig_ctx_idx_map[3][5][16] = {
+    { // SCAN_DIAG
+        { 0, 2, 1, 6, 3, 4, 7, 6, 4, 5, 7, 8, 5, 8, 8, 8, }, // log2_trafo_size == 2
+        { 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, }, // prev_sig == 0
+        { 2, 1, 2, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 0, 0, 0, }, // prev_sig == 1
+        { 2, 2, 1, 2, 1, 0, 2, 1, 0, 0, 1, 0, 0, 0, 0, 0, }, // prev_sig == 2
+        { 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, }, // transform skip
+    },
+    { // SCAN_HORIZ
+        { 0, 1, 4, 5, 2, 3, 4, 5, 6, 6, 8, 8, 7, 7, 8, 8, }, // log2_trafo_size == 2
+        { 1, 1, 1, 0, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, }, // prev_sig == 0
+        { 2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, }, // prev_sig == 1
+        { 2, 1, 0, 0, 2, 1, 0, 0, 2, 1, 0, 0, 2, 1, 0, 0, }, // prev_sig == 2
+        { 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, }, // transform skip
+    },
+    { // SCAN_VERT
+        { 0, 2, 6, 7, 1, 3, 6, 7, 4, 4, 8, 8, 5, 5, 8, 8, }, // log2_trafo_size == 2
+        { 1, 1, 1, 0, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, }, // prev_sig == 0
+        { 2, 1, 0, 0, 2, 1, 0, 0, 2, 1, 0, 0, 2, 1, 0, 0, }, // prev_sig == 1
+        { 2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, }, // prev_sig == 2
+        { 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, }, // transform skip
+    },
+};
+
 void ff_hevc_save_states(HEVCContext *s, int ctb_addr_ts)
 {
     if (s->pps->entropy_coding_sync_enabled_flag &&
@@ -572,7 +610,7 @@ void ff_hevc_cabac_init(HEVCContext *s, int ctb_addr_ts)
     } else {
         if (s->pps->tiles_enabled_flag &&
             s->pps->tile_id[ctb_addr_ts] != s->pps->tile_id[ctb_addr_ts - 1]) {
-            if (s->threads_number == 1)
+            if (!s->enable_parallel_tiles)
                 cabac_reinit(s->HEVClc);
             else
                 cabac_init_decoder(s);
@@ -941,6 +979,48 @@ int ff_hevc_res_scale_sign_flag(HEVCContext *s, int idx) {
     return GET_CABAC(elem_offset[RES_SCALE_SIGN_FLAG] + idx);
 }
 
+/**
+ * Decode n <= CABAC_BYPASS_CHUNK bypass bins, msb first.
+ * Decoding bypass bins one by one is a binary long division of the
+ * bitstream by the scaled range, so as long as no refill is needed in
+ * between, all bins can be taken from low shifted once. Damaged streams
+ * can leave low >= range, those take the bin by bin path.
+ */
+static av_always_inline unsigned get_cabac_bypass_chunk(CABACContext *c, int n)
+{
+    unsigned low, range = c->range << (CABAC_BITS + 1), value = 0;
+    int i;
+
+    if (ff_ctz(c->low) + n >= CABAC_BITS || (unsigned)c->low >= range) {
+        for (i = 0; i < n; i++)
+            value = (value << 1) | get_cabac_bypass(c);
+        return value;
+    }
+
+    low = (unsigned)c->low << n;
+    for (i = n - 1; i >= 0; i--) {
+        unsigned bit = low >= range << i;
+        low   -= (range << i) & -bit;
+        value  = (value << 1) | bit;
+    }
+    c->low = low;
+    return value;
+}
+
+static av_always_inline unsigned get_cabac_bypass_bins(CABACContext *c, int n)
+{
+    unsigned value = 0;
+
+    while (n > CABAC_BYPASS_CHUNK) {
+        value = (value << CABAC_BYPASS_CHUNK) |
+                get_cabac_bypass_chunk(c, CABAC_BYPASS_CHUNK);
+        n    -= CABAC_BYPASS_CHUNK;
+    }
+    if (n > 0)
+        value = (value << n) | get_cabac_bypass_chunk(c, n);
+    return value;
+}
+
 static av_always_inline void last_significant_coeff_xy_prefix_decode(HEVCContext *s, int c_idx,
                                                    int log2_size, int *last_scx_prefix, int *last_scy_prefix)
 {
@@ -970,13 +1050,9 @@ static av_always_inline void last_significant_coeff_xy_prefix_decode(HEVCContext
 static av_always_inline int last_significant_coeff_suffix_decode(HEVCContext *s,
                                                  int last_significant_coeff_prefix)
 {
-    int i;
     int length = (last_significant_coeff_prefix >> 1) - 1;
-    int value = get_cabac_bypass(&s->HEVClc->cc);
 
-    for (i = 1; i < length; i++)
-        value = (value << 1) | get_cabac_bypass(&s->HEVClc->cc);
-    return value;
+    return get_cabac_bypass_bins(&s->HEVClc->cc, length);
 }
 
 static av_always_inline int significant_coeff_group_flag_decode(HEVCContext *s, int c_idx, int ctx_cg)
@@ -987,10 +1063,10 @@ static av_always_inline int significant_coeff_group_flag_decode(HEVCContext *s,
 
     return GET_CABAC(elem_offset[SIGNIFICANT_COEFF_GROUP_FLAG] + inc);
 }
-static av_always_inline int significant_coeff_flag_decode(HEVCContext *s, int x_c, int y_c,
+static av_always_inline int significant_coeff_flag_decode(HEVCContext *s, int n,
                                            int offset, const uint8_t *ctx_idx_map)
 {
-    int inc = ctx_idx_map[(y_c << 2) + x_c] + offset;
+    int inc = ctx_idx_map[n] + offset;
     return GET_CABAC(elem_offset[SIGNIFICANT_COEFF_FLAG] + inc);
 }
 
@@ -1019,22 +1095,19 @@ static av_always_inline int coeff_abs_level_greater2_flag_decode(HEVCContext *s,
 static av_always_inline int coeff_abs_level_remaining_decode(HEVCContext *s, int rc_rice_param)
 {
     int prefix = 0;
-    int suffix = 0;
+    int suffix;
     int last_coeff_abs_level_remaining;
-    int i;
 
     while (prefix < CABAC_MAX_BIN && get_cabac_bypass(&s->HEVClc->cc))
         prefix++;
     if (prefix == CABAC_MAX_BIN)
         av_log(s->avctx, AV_LOG_ERROR, "CABAC_MAX_BIN : %d\n", prefix);
     if (prefix < 3) {
-        for (i = 0; i < rc_rice_param; i++)
-            suffix = (suffix << 1) | get_cabac_bypass(&s->HEVClc->cc);
+        suffix = get_cabac_bypass_bins(&s->HEVClc->cc, rc_rice_param);
         last_coeff_abs_level_remaining = (prefix << rc_rice_param) + suffix;
     } else {
         int prefix_minus3 = prefix - 3;
-        for (i = 0; i < prefix_minus3 + rc_rice_param; i++)
-            suffix = (suffix << 1) | get_cabac_bypass(&s->HEVClc->cc);
+        suffix = get_cabac_bypass_bins(&s->HEVClc->cc, prefix_minus3 + rc_rice_param);
         last_coeff_abs_level_remaining = (((1 << prefix_minus3) + 3 - 1)
                                               << rc_rice_param) + suffix;
     }
@@ -1043,12 +1116,7 @@ static av_always_inline int coeff_abs_level_remaining_decode(HEVCContext *s, int
 
 static av_always_inline int coeff_sign_flag_decode(HEVCContext *s, uint8_t nb)
 {
-    int i;
-    int ret = 0;
-
-    for (i = 0; i < nb; i++)
-        ret = (ret << 1) | get_cabac_bypass(&s->HEVClc->cc);
-    return ret;
+    return get_cabac_bypass_bins(&s->HEVClc->cc, nb);
 }
 
 void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
@@ -1077,8 +1145,8 @@ void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
     ptrdiff_t stride = s->frame->linesize[c_idx];
     int hshift = s->sps->hshift[c_idx];
     int vshift = s->sps->vshift[c_idx];
-    uint8_t *dst = &s->frame->data[c_idx][(y0 >> vshift) * stride +
-                                          ((x0 >> hshift) << s->sps->pixel_shift)];
+    uint8_t *dst = &s->frame->data[c_idx][((y0 >> vshift) >> s->lowres) * stride +
+                                          (((x0 >> hshift) >> s->lowres) << s->sps->pixel_shift)];
     int16_t *coeffs = (int16_t*)(c_idx ? lc->edge_emu_buffer2 : lc->edge_emu_buffer);
     uint8_t significant_coeff_group_flag[8][8] = {{0}};
     int explicit_rdpcm_flag = 0;
@@ -1294,18 +1362,11 @@ void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
             prev_sig += (!!significant_coeff_group_flag[x_cg][y_cg + 1] << 1);
 
         if (significant_coeff_group_flag[x_cg][y_cg] && n_end >= 0) {
-            static const uint8_t ctx_idx_map[] = {
-                0, 1, 4, 5, 2, 3, 4, 5, 6, 6, 8, 8, 7, 7, 8, 8, // log2_trafo_size == 2
-                1, 1, 1, 0, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, // prev_sig == 0
-                2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, // prev_sig == 1
-                2, 1, 0, 0, 2, 1, 0, 0, 2, 1, 0, 0, 2, 1, 0, 0, // prev_sig == 2
-                2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2  // default
-            };
             const uint8_t *ctx_idx_map_p;
             int scf_offset = 0;
             if (s->sps->transform_skip_context_enabled_flag &&
                 (transform_skip_flag || lc->cu.cu_transquant_bypass_flag)) {
-                ctx_idx_map_p = (uint8_t*) &ctx_idx_map[4 * 16];
+                ctx_idx_map_p = sig_ctx_idx_map[scan_idx][4];
                 if (c_idx == 0) {
                     scf_offset = 40;
                 } else {
@@ -1315,9 +1376,9 @@ void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
                 if (c_idx != 0)
                     scf_offset = 27;
                 if (log2_trafo_size == 2) {
-                    ctx_idx_map_p = (uint8_t*) &ctx_idx_map[0];
+                    ctx_idx_map_p = sig_ctx_idx_map[scan_idx][0];
                 } else {
-                    ctx_idx_map_p = (uint8_t*) &ctx_idx_map[(prev_sig + 1) << 4];
+                    ctx_idx_map_p = sig_ctx_idx_map[scan_idx][prev_sig + 1];
                     if (c_idx == 0) {
                         if ((x_cg > 0 || y_cg > 0))
                             scf_offset += 3;
@@ -1335,9 +1396,7 @@ void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
                 }
             }
             for (n = n_end; n > 0; n--) {
-                x_c = scan_x_off[n];
-                y_c = scan_y_off[n];
-                if (significant_coeff_flag_decode(s, x_c, y_c, scf_offset, ctx_idx_map_p)) {
+                if (significant_coeff_flag_decode(s, n, scf_offset, ctx_idx_map_p)) {
                     significant_coeff_flag_idx[nb_significant_coeff_flag] = n;
                     nb_significant_coeff_flag++;
                     implicit_non_zero_coeff = 0;
@@ -1551,6 +1610,10 @@ void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
             }
         }
     }
+    if (s->lowres) {
+        s->hevcdsp.transform_add_lowres(dst, coeffs, stride, log2_trafo_size, s->lowres);
+        return;
+    }
     if (lc->tu.cross_pf) {
         int16_t *coeffs_y = (int16_t*)lc->edge_emu_buffer;
 
@@ -22,12 +22,24 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "compat/w32pthreads.h"
+#elif HAVE_OS2THREADS
+#include "compat/os2threads.h"
+#endif
+
 #include "libavutil/common.h"
 #include "libavutil/internal.h"
+#include "libavutil/mem.h"
 
 #include "cabac_functions.h"
 #include "golomb.h"
 #include "hevc.h"
+#include "mpegutils.h"
 
 #include "bit_depth_template.c"
 
@@ -648,68 +660,81 @@ static void deblocking_filter_CTB(HEVCContext *s, int x0, int y0)
     }
 }
 
-static int boundary_strength(HEVCContext *s, MvField *curr, MvField *neigh,
-                             RefPicList *neigh_refPicList)
+static av_always_inline void get_motion(DeblockMotion *m, const MvField *mvf,
+                                        const RefPicList *rpl, int poc)
 {
-    if (curr->pred_flag == PF_BI &&  neigh->pred_flag == PF_BI) {
-        // same L0 and L1
-        if (s->ref->refPicList[0].list[curr->ref_idx[0]] == neigh_refPicList[0].list[neigh->ref_idx[0]]  &&
-            s->ref->refPicList[0].list[curr->ref_idx[0]] == s->ref->refPicList[1].list[curr->ref_idx[1]] &&
-            neigh_refPicList[0].list[neigh->ref_idx[0]] == neigh_refPicList[1].list[neigh->ref_idx[1]]) {
-            if ((FFABS(neigh->mv[0].x - curr->mv[0].x) >= 4 || FFABS(neigh->mv[0].y - curr->mv[0].y) >= 4 ||
-                 FFABS(neigh->mv[1].x - curr->mv[1].x) >= 4 || FFABS(neigh->mv[1].y - curr->mv[1].y) >= 4) &&
-                (FFABS(neigh->mv[1].x - curr->mv[0].x) >= 4 || FFABS(neigh->mv[1].y - curr->mv[0].y) >= 4 ||
-                 FFABS(neigh->mv[0].x - curr->mv[1].x) >= 4 || FFABS(neigh->mv[0].y - curr->mv[1].y) >= 4))
-                return 1;
-            else
-                return 0;
-        } else if (neigh_refPicList[0].list[neigh->ref_idx[0]] == s->ref->refPicList[0].list[curr->ref_idx[0]] &&
-                   neigh_refPicList[1].list[neigh->ref_idx[1]] == s->ref->refPicList[1].list[curr->ref_idx[1]]) {
-            if (FFABS(neigh->mv[0].x - curr->mv[0].x) >= 4 || FFABS(neigh->mv[0].y - curr->mv[0].y) >= 4 ||
-                FFABS(neigh->mv[1].x - curr->mv[1].x) >= 4 || FFABS(neigh->mv[1].y - curr->mv[1].y) >= 4)
-                return 1;
-            else
-                return 0;
-        } else if (neigh_refPicList[1].list[neigh->ref_idx[1]] == s->ref->refPicList[0].list[curr->ref_idx[0]] &&
-                   neigh_refPicList[0].list[neigh->ref_idx[0]] == s->ref->refPicList[1].list[curr->ref_idx[1]]) {
-            if (FFABS(neigh->mv[1].x - curr->mv[0].x) >= 4 || FFABS(neigh->mv[1].y - curr->mv[0].y) >= 4 ||
-                FFABS(neigh->mv[0].x - curr->mv[1].x) >= 4 || FFABS(neigh->mv[0].y - curr->mv[1].y) >= 4)
-                return 1;
-            else
-                return 0;
-        } else {
-            return 1;
-        }
-    } else if ((curr->pred_flag != PF_BI) && (neigh->pred_flag != PF_BI)){ // 1 MV
-        Mv A, B;
-        int ref_A, ref_B;
+    if (mvf->pred_flag == PF_BI) {
+        AV_COPY32(m->mv[0], &mvf->mv[0]);
+        AV_COPY32(m->mv[1], &mvf->mv[1]);
+        m->ref[0] = rpl[0].list[mvf->ref_idx[0]] - poc;
+        m->ref[1] = rpl[1].list[mvf->ref_idx[1]] - poc;
+    } else {
+        int l = !(mvf->pred_flag & PF_L0);
 
-        if (curr->pred_flag & 1) {
-            A     = curr->mv[0];
-            ref_A = s->ref->refPicList[0].list[curr->ref_idx[0]];
-        } else {
-            A     = curr->mv[1];
-            ref_A = s->ref->refPicList[1].list[curr->ref_idx[1]];
-        }
+        AV_COPY32(m->mv[0], &mvf->mv[l]);
+        AV_ZERO32(m->mv[1]);
+        m->ref[0] = rpl[l].list[mvf->ref_idx[l]] - poc;
+        m->ref[1] = 0;
+    }
+}
+
+/**
+ * Boundary strengths of the n 4-sample segments of an edge, the first one
+ * between the luma samples (xp, yp) and (xq, yq) and each following one
+ * (dx, dy) further, into bs[i * bs_stride]. Intra prediction and, on
+ * transform edges, coded residual decide a segment directly; the motion of
+ * all the others is gathered and compared in one deblocking_bs() call.
+ */
+static void edge_bs(HEVCContext *s, uint8_t *bs, ptrdiff_t bs_stride,
+                    int xp, int yp, int xq, int yq, int dx, int dy, int n,
+                    const RefPicList *rpl_p, int tu_edge)
+{
+    DECLARE_ALIGNED(16, DeblockMotion, mp)[1 << (MAX_LOG2_CTB_SIZE - 2)];
+    DECLARE_ALIGNED(16, DeblockMotion, mq)[1 << (MAX_LOG2_CTB_SIZE - 2)];
+    uint8_t force[1 << (MAX_LOG2_CTB_SIZE - 2)];
+    const MvField *tab_mvf = s->ref->tab_mvf;
+    int log2_min_pu_size   = s->sps->log2_min_pu_size;
+    int log2_min_tu_size   = s->sps->log2_min_tb_size;
+    int min_pu_width       = s->sps->min_pu_width;
+    int min_tu_width       = s->sps->min_tb_width;
+    int poc                = s->ref->poc;
+    int i, nb_motion = 0;
+
+    for (i = 0; i < n; i++) {
+        const MvField *p = &tab_mvf[(yp >> log2_min_pu_size) * min_pu_width +
+                                    (xp >> log2_min_pu_size)];
+        const MvField *q = &tab_mvf[(yq >> log2_min_pu_size) * min_pu_width +
+                                    (xq >> log2_min_pu_size)];
+
+        if (p->pred_flag == PF_INTRA || q->pred_flag == PF_INTRA)
+            force[i] = 2;
+        else if (tu_edge &&
+                 (s->cbf_luma[(yp >> log2_min_tu_size) * min_tu_width + (xp >> log2_min_tu_size)] ||
+                  s->cbf_luma[(yq >> log2_min_tu_size) * min_tu_width + (xq >> log2_min_tu_size)]))
+            force[i] = 1;
+        else
+            force[i] = 0;
 
-        if (neigh->pred_flag & 1) {
-            B     = neigh->mv[0];
-            ref_B = neigh_refPicList[0].list[neigh->ref_idx[0]];
+        if (force[i]) {
+            AV_ZERO128(&mp[i]);
+            AV_ZERO128(&mq[i]);
         } else {
-            B     = neigh->mv[1];
-            ref_B = neigh_refPicList[1].list[neigh->ref_idx[1]];
+            get_motion(&mp[i], p, rpl_p, poc);
+            get_motion(&mq[i], q, s->ref->refPicList, poc);
+            nb_motion++;
         }
-
-        if (ref_A == ref_B) {
-            if (FFABS(A.x - B.x) >= 4 || FFABS(A.y - B.y) >= 4)
-                return 1;
-            else
-                return 0;
-        } else
-            return 1;
+        xp += dx;
+        yp += dy;
+        xq += dx;
+        yq += dy;
     }
 
-    return 1;
+    if (nb_motion)
+        s->hevcdsp.deblocking_bs(bs, bs_stride, mp, mq, n);
+    if (nb_motion < n)
+        for (i = 0; i < n; i++)
+            if (force[i])
+                bs[i * bs_stride] = force[i];
 }
 
 void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
@@ -718,20 +743,22 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
     HEVCLocalContext *lc = s->HEVClc;
     MvField *tab_mvf     = s->ref->tab_mvf;
     int log2_min_pu_size = s->sps->log2_min_pu_size;
-    int log2_min_tu_size = s->sps->log2_min_tb_size;
     int min_pu_width     = s->sps->min_pu_width;
-    int min_tu_width     = s->sps->min_tb_width;
     int is_intra = tab_mvf[(y0 >> log2_min_pu_size) * min_pu_width +
                            (x0 >> log2_min_pu_size)].pred_flag == PF_INTRA;
     int boundary_upper, boundary_left;
-    int i, j, bs;
+    int i, j;
 
+    /* with parallel tiles the neighbouring tile may still be in flight,
+     * tile edges are filled in by
+     * ff_hevc_deblocking_boundary_strengths_tile_edges() afterwards */
     boundary_upper = y0 > 0 && !(y0 & 7);
     if (boundary_upper &&
         ((!s->sh.slice_loop_filter_across_slices_enabled_flag &&
           lc->boundary_flags & BOUNDARY_UPPER_SLICE &&
           (y0 % (1 << s->sps->log2_ctb_size)) == 0) ||
-         (!s->pps->loop_filter_across_tiles_enabled_flag &&
+         ((!s->pps->loop_filter_across_tiles_enabled_flag ||
+           s->enable_parallel_tiles) &&
           lc->boundary_flags & BOUNDARY_UPPER_TILE &&
           (y0 % (1 << s->sps->log2_ctb_size)) == 0)))
         boundary_upper = 0;
@@ -740,27 +767,9 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         RefPicList *rpl_top = (lc->boundary_flags & BOUNDARY_UPPER_SLICE) ?
                               ff_hevc_get_ref_list(s, s->ref, x0, y0 - 1) :
                               s->ref->refPicList;
-        int yp_pu = (y0 - 1) >> log2_min_pu_size;
-        int yq_pu =  y0      >> log2_min_pu_size;
-        int yp_tu = (y0 - 1) >> log2_min_tu_size;
-        int yq_tu =  y0      >> log2_min_tu_size;
-
-            for (i = 0; i < (1 << log2_trafo_size); i += 4) {
-                int x_pu = (x0 + i) >> log2_min_pu_size;
-                int x_tu = (x0 + i) >> log2_min_tu_size;
-                MvField *top  = &tab_mvf[yp_pu * min_pu_width + x_pu];
-                MvField *curr = &tab_mvf[yq_pu * min_pu_width + x_pu];
-                uint8_t top_cbf_luma  = s->cbf_luma[yp_tu * min_tu_width + x_tu];
-                uint8_t curr_cbf_luma = s->cbf_luma[yq_tu * min_tu_width + x_tu];
-
-                if (curr->pred_flag == PF_INTRA || top->pred_flag == PF_INTRA)
-                    bs = 2;
-                else if (curr_cbf_luma || top_cbf_luma)
-                    bs = 1;
-                else
-                    bs = boundary_strength(s, curr, top, rpl_top);
-                s->horizontal_bs[((x0 + i) + y0 * s->bs_width) >> 2] = bs;
-            }
+
+        edge_bs(s, &s->horizontal_bs[(x0 + y0 * s->bs_width) >> 2], 1,
+                x0, y0 - 1, x0, y0, 4, 0, 1 << (log2_trafo_size - 2), rpl_top, 1);
     }
 
     // bs for vertical TU boundaries
@@ -769,7 +778,8 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         ((!s->sh.slice_loop_filter_across_slices_enabled_flag &&
           lc->boundary_flags & BOUNDARY_LEFT_SLICE &&
           (x0 % (1 << s->sps->log2_ctb_size)) == 0) ||
-         (!s->pps->loop_filter_across_tiles_enabled_flag &&
+         ((!s->pps->loop_filter_across_tiles_enabled_flag ||
+           s->enable_parallel_tiles) &&
           lc->boundary_flags & BOUNDARY_LEFT_TILE &&
           (x0 % (1 << s->sps->log2_ctb_size)) == 0)))
         boundary_left = 0;
@@ -778,60 +788,66 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         RefPicList *rpl_left = (lc->boundary_flags & BOUNDARY_LEFT_SLICE) ?
                                ff_hevc_get_ref_list(s, s->ref, x0 - 1, y0) :
                                s->ref->refPicList;
-        int xp_pu = (x0 - 1) >> log2_min_pu_size;
-        int xq_pu =  x0      >> log2_min_pu_size;
-        int xp_tu = (x0 - 1) >> log2_min_tu_size;
-        int xq_tu =  x0      >> log2_min_tu_size;
-
-            for (i = 0; i < (1 << log2_trafo_size); i += 4) {
-                int y_pu      = (y0 + i) >> log2_min_pu_size;
-                int y_tu      = (y0 + i) >> log2_min_tu_size;
-                MvField *left = &tab_mvf[y_pu * min_pu_width + xp_pu];
-                MvField *curr = &tab_mvf[y_pu * min_pu_width + xq_pu];
-                uint8_t left_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xp_tu];
-                uint8_t curr_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xq_tu];
-
-                if (curr->pred_flag == PF_INTRA || left->pred_flag == PF_INTRA)
-                    bs = 2;
-                else if (curr_cbf_luma || left_cbf_luma)
-                    bs = 1;
-                else
-                    bs = boundary_strength(s, curr, left, rpl_left);
-                s->vertical_bs[(x0 + (y0 + i) * s->bs_width) >> 2] = bs;
-            }
+
+        edge_bs(s, &s->vertical_bs[(x0 + y0 * s->bs_width) >> 2], s->bs_width,
+                x0 - 1, y0, x0, y0, 0, 4, 1 << (log2_trafo_size - 2), rpl_left, 1);
     }
 
     if (log2_trafo_size > log2_min_pu_size && !is_intra) {
         RefPicList *rpl = s->ref->refPicList;
+        int n = 1 << (log2_trafo_size - 2);
 
         // bs for TU internal horizontal PU boundaries
-        for (j = 8; j < (1 << log2_trafo_size); j += 8) {
-            int yp_pu = (y0 + j - 1) >> log2_min_pu_size;
-            int yq_pu = (y0 + j)     >> log2_min_pu_size;
+        for (j = 8; j < (1 << log2_trafo_size); j += 8)
+            edge_bs(s, &s->horizontal_bs[(x0 + (y0 + j) * s->bs_width) >> 2], 1,
+                    x0, y0 + j - 1, x0, y0 + j, 4, 0, n, rpl, 0);
 
-            for (i = 0; i < (1 << log2_trafo_size); i += 4) {
-                int x_pu = (x0 + i) >> log2_min_pu_size;
-                MvField *top  = &tab_mvf[yp_pu * min_pu_width + x_pu];
-                MvField *curr = &tab_mvf[yq_pu * min_pu_width + x_pu];
+        // bs for TU internal vertical PU boundaries
+        for (i = 8; i < (1 << log2_trafo_size); i += 8)
+            edge_bs(s, &s->vertical_bs[((x0 + i) + y0 * s->bs_width) >> 2], s->bs_width,
+                    x0 + i - 1, y0, x0 + i, y0, 0, 4, n, rpl, 0);
+    }
+}
 
-                bs = boundary_strength(s, curr, top, rpl);
-                s->horizontal_bs[((x0 + i) + (y0 + j) * s->bs_width) >> 2] = bs;
-            }
+void ff_hevc_deblocking_boundary_strengths_tile_edges(HEVCContext *s, int x0, int y0)
+{
+    int x_ctb            = x0 >> s->sps->log2_ctb_size;
+    int y_ctb            = y0 >> s->sps->log2_ctb_size;
+    int ctb_addr_rs      = y_ctb * s->sps->ctb_width + x_ctb;
+    int ctb_addr_ts      = s->pps->ctb_addr_rs_to_ts[ctb_addr_rs];
+    int width            = FFMIN(1 << s->sps->log2_ctb_size, s->sps->width  - x0);
+    int height           = FFMIN(1 << s->sps->log2_ctb_size, s->sps->height - y0);
+
+    if (!s->pps->loop_filter_across_tiles_enabled_flag)
+        return;
+
+    if (y_ctb > 0 &&
+        s->pps->tile_id[ctb_addr_ts] != s->pps->tile_id[s->pps->ctb_addr_rs_to_ts[ctb_addr_rs - s->sps->ctb_width]]) {
+        int upper_slice = CTB(s->tab_slice_address, x_ctb, y_ctb) !=
+                          CTB(s->tab_slice_address, x_ctb, y_ctb - 1);
+
+        if (!upper_slice || s->sh.slice_loop_filter_across_slices_enabled_flag) {
+            RefPicList *rpl_top = upper_slice ?
+                                  ff_hevc_get_ref_list(s, s->ref, x0, y0 - 1) :
+                                  s->ref->refPicList;
+
+            edge_bs(s, &s->horizontal_bs[(x0 + y0 * s->bs_width) >> 2], 1,
+                    x0, y0 - 1, x0, y0, 4, 0, (width + 3) >> 2, rpl_top, 1);
         }
+    }
 
-        // bs for TU internal vertical PU boundaries
-        for (j = 0; j < (1 << log2_trafo_size); j += 4) {
-            int y_pu = (y0 + j) >> log2_min_pu_size;
+    if (x_ctb > 0 &&
+        s->pps->tile_id[ctb_addr_ts] != s->pps->tile_id[s->pps->ctb_addr_rs_to_ts[ctb_addr_rs - 1]]) {
+        int left_slice = CTB(s->tab_slice_address, x_ctb, y_ctb) !=
+                         CTB(s->tab_slice_address, x_ctb - 1, y_ctb);
 
-            for (i = 8; i < (1 << log2_trafo_size); i += 8) {
-                int xp_pu = (x0 + i - 1) >> log2_min_pu_size;
-                int xq_pu = (x0 + i)     >> log2_min_pu_size;
-                MvField *left = &tab_mvf[y_pu * min_pu_width + xp_pu];
-                MvField *curr = &tab_mvf[y_pu * min_pu_width + xq_pu];
+        if (!left_slice || s->sh.slice_loop_filter_across_slices_enabled_flag) {
+            RefPicList *rpl_left = left_slice ?
+                                   ff_hevc_get_ref_list(s, s->ref, x0 - 1, y0) :
+                                   s->ref->refPicList;
 
-                bs = boundary_strength(s, curr, left, rpl);
-                s->vertical_bs[((x0 + i) + (y0 + j) * s->bs_width) >> 2] = bs;
-            }
+            edge_bs(s, &s->vertical_bs[(x0 + y0 * s->bs_width) >> 2], s->bs_width,
+                    x0 - 1, y0, x0, y0, 0, 4, (height + 3) >> 2, rpl_left, 1);
         }
     }
 }
@@ -840,12 +856,53 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
 #undef CB
 #undef CR
 
+/**
+ * Pass the luma rows [y0, y1) of the coded picture, once they are final,
+ * to draw_horiz_band(). The band is clipped to the conformance window and
+ * scaled down to the lowres picture.
+ */
+static void draw_horiz_band(HEVCContext *s, int y0, int y1)
+{
+    AVCodecContext *avctx = s->avctx;
+    const AVFrame *frame  = s->ref->frame;
+    const HEVCWindow *win = &s->ref->window;
+    int offset[AV_NUM_DATA_POINTERS] = { 0 };
+    int top = win->top_offset >> s->lowres;
+    int i;
+
+    y0 = FFMAX((FFMAX(y0, 0) >> s->lowres) - top, 0);
+    y1 = FFMIN((y1 >> s->lowres) - top, avctx->height);
+    if (y1 <= y0)
+        return;
+
+    for (i = 0; i < 3; i++) {
+        int hshift = i ? s->sps->hshift[i] : 0;
+        int vshift = i ? s->sps->vshift[i] : 0;
+        offset[i] = ((y0 >> vshift) + (win->top_offset >> (vshift + s->lowres))) * frame->linesize[i] +
+                    ((win->left_offset >> (hshift + s->lowres)) << s->sps->pixel_shift);
+    }
+
+    emms_c();
+
+    avctx->draw_horiz_band(avctx, frame, offset, y0, PICT_FRAME, y1 - y0);
+}
+
 void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size)
 {
     int x_end = x >= s->sps->width  - ctb_size;
+    int y_end = y >= s->sps->height - ctb_size;
+    if (s->lowres) {
+        // the in-loop filters are not applied to lowres pictures
+        if (x_end) {
+            if (s->threads_type & FF_THREAD_FRAME)
+                ff_thread_report_progress(&s->ref->tf, y + ctb_size, 0);
+            if (s->draw_bands)
+                draw_horiz_band(s, y, y + ctb_size);
+        }
+        return;
+    }
     deblocking_filter_CTB(s, x, y);
     if (s->sps->sao_enabled) {
-        int y_end = y >= s->sps->height - ctb_size;
         if (y && x)
             sao_filter_CTB(s, x - ctb_size, y - ctb_size);
         if (x && y_end)
@@ -854,14 +911,24 @@ void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size)
             sao_filter_CTB(s, x, y - ctb_size);
             if (s->threads_type & FF_THREAD_FRAME )
                 ff_thread_report_progress(&s->ref->tf, y, 0);
+            if (s->draw_bands)
+                draw_horiz_band(s, y - ctb_size, y);
         }
         if (x_end && y_end) {
             sao_filter_CTB(s, x , y);
             if (s->threads_type & FF_THREAD_FRAME )
                 ff_thread_report_progress(&s->ref->tf, y + ctb_size, 0);
+            if (s->draw_bands)
+                draw_horiz_band(s, y, y + ctb_size);
         }
-    } else if (s->threads_type & FF_THREAD_FRAME && x_end)
-        ff_thread_report_progress(&s->ref->tf, y + ctb_size - 4, 0);
+    } else if (x_end) {
+        if (s->threads_type & FF_THREAD_FRAME)
+            ff_thread_report_progress(&s->ref->tf, y + ctb_size - 4, 0);
+        /* the last rows of a CTB row wait for the deblocking of the next
+         * one, unless there is none */
+        if (s->draw_bands)
+            draw_horiz_band(s, y - 4, y_end ? y + ctb_size : y + ctb_size - 4);
+    }
 }
 
 void ff_hevc_hls_filters(HEVCContext *s, int x_ctb, int y_ctb, int ctb_size)
@@ -875,3 +942,219 @@ void ff_hevc_hls_filters(HEVCContext *s, int x_ctb, int y_ctb, int ctb_size)
     if (x_ctb && y_end)
         ff_hevc_hls_filter(s, x_ctb - ctb_size, y_ctb, ctb_size);
 }
+
+#if HAVE_THREADS
+typedef struct HEVCFilterThread {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;        ///< signalled when rows_ready or die changes
+    pthread_cond_t done_cond;   ///< signalled when rows_filtered changes
+
+    /* snapshot of the decoder context for the frame being filtered, with
+     * its own local context so the scratch buffers are not shared */
+    HEVCContext *s;
+    HEVCLocalContext *lc;
+    AVBufferRef *sps_ref;       ///< keep the parameter sets of the snapshot
+    AVBufferRef *pps_ref;       ///< alive if new ones replace them mid-frame
+
+    int rows_ready;             ///< CTB rows which may be filtered
+    int rows_filtered;          ///< CTB rows done by the filter thread
+    int die;
+} HEVCFilterThread;
+
+/**
+ * Replay the ff_hevc_hls_filters() calls the parser would have made while
+ * decoding one CTB row, which filters the row above it.
+ */
+static void filter_ctb_row(HEVCContext *s, int ctb_row)
+{
+    int ctb_size = 1 << s->sps->log2_ctb_size;
+    int y_ctb    = ctb_row << s->sps->log2_ctb_size;
+    int x_ctb;
+
+    for (x_ctb = 0; x_ctb < s->sps->width; x_ctb += ctb_size)
+        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+
+    if (y_ctb + ctb_size >= s->sps->height)
+        ff_hevc_hls_filter(s, x_ctb - ctb_size, y_ctb, ctb_size);
+}
+
+static void *attribute_align_arg filter_thread_worker(void *arg)
+{
+    HEVCFilterThread *ft = arg;
+
+    pthread_mutex_lock(&ft->lock);
+    for (;;) {
+        int ctb_row;
+
+        while (!ft->die && ft->rows_filtered >= ft->rows_ready)
+            pthread_cond_wait(&ft->cond, &ft->lock);
+        if (ft->die)
+            break;
+
+        ctb_row = ft->rows_filtered;
+        pthread_mutex_unlock(&ft->lock);
+
+        filter_ctb_row(ft->s, ctb_row);
+
+        pthread_mutex_lock(&ft->lock);
+        ft->rows_filtered++;
+        pthread_cond_broadcast(&ft->done_cond);
+    }
+    pthread_mutex_unlock(&ft->lock);
+
+    return NULL;
+}
+
+static int filter_thread_init(HEVCContext *s)
+{
+    HEVCFilterThread *ft = av_mallocz(sizeof(*ft));
+
+    if (!ft)
+        return AVERROR(ENOMEM);
+
+    ft->s  = av_malloc(sizeof(*ft->s));
+    ft->lc = av_mallocz(sizeof(*ft->lc));
+    if (!ft->s || !ft->lc) {
+        av_freep(&ft->s);
+        av_freep(&ft->lc);
+        av_freep(&ft);
+        return AVERROR(ENOMEM);
+    }
+
+    pthread_mutex_init(&ft->lock, NULL);
+    pthread_cond_init(&ft->cond, NULL);
+    pthread_cond_init(&ft->done_cond, NULL);
+
+    if (pthread_create(&ft->thread, NULL, filter_thread_worker, ft)) {
+        pthread_mutex_destroy(&ft->lock);
+        pthread_cond_destroy(&ft->cond);
+        pthread_cond_destroy(&ft->done_cond);
+        av_freep(&ft->s);
+        av_freep(&ft->lc);
+        av_freep(&ft);
+        return AVERROR(EAGAIN);
+    }
+
+    s->filter_thread = ft;
+    return 0;
+}
+
+int ff_hevc_deferred_filter_start(HEVCContext *s)
+{
+    HEVCFilterThread *ft;
+    int ret;
+
+    ff_hevc_deferred_filter_sync(s);
+    s->filter_deferred = 0;
+
+    /* tiles are not decoded in raster order and threaded WPP filters
+     * inline from the row threads */
+    if (!s->deferred_filter || s->avctx->hwaccel ||
+        s->pps->tiles_enabled_flag ||
+        (s->threads_number > 1 && s->pps->entropy_coding_sync_enabled_flag))
+        return 0;
+
+    if (!s->filter_thread) {
+        ret = filter_thread_init(s);
+        if (ret < 0) {
+            av_log(s->avctx, AV_LOG_WARNING,
+                   "Could not start the filter thread, filtering inline.\n");
+            s->deferred_filter = 0;
+            return 0;
+        }
+    }
+    ft = s->filter_thread;
+
+    av_buffer_unref(&ft->sps_ref);
+    av_buffer_unref(&ft->pps_ref);
+    ft->sps_ref = av_buffer_ref(s->sps_list[s->pps->sps_id]);
+    ft->pps_ref = av_buffer_ref(s->pps_list[s->sh.pps_id]);
+    if (!ft->sps_ref || !ft->pps_ref)
+        return AVERROR(ENOMEM);
+
+    memcpy(ft->s, s, sizeof(*s));
+    ft->s->HEVClc = ft->lc;
+    ft->rows_ready    = 0;
+    ft->rows_filtered = 0;
+
+    s->filter_deferred = 1;
+    return 0;
+}
+
+void ff_hevc_deferred_filter_row(HEVCContext *s, int ctb_row)
+{
+    HEVCFilterThread *ft = s->filter_thread;
+    int rows_ready;
+
+    /* replaying row n filters row n - 1, so a lag of one row only needs
+     * row n itself to be complete */
+    if (ctb_row + 1 >= s->sps->ctb_height)
+        rows_ready = s->sps->ctb_height;
+    else
+        rows_ready = ctb_row + 2 - s->deferred_filter;
+
+    pthread_mutex_lock(&ft->lock);
+    if (rows_ready > ft->rows_ready) {
+        ft->rows_ready = rows_ready;
+        pthread_cond_signal(&ft->cond);
+    }
+    pthread_mutex_unlock(&ft->lock);
+}
+
+void ff_hevc_deferred_filter_sync(HEVCContext *s)
+{
+    HEVCFilterThread *ft = s->filter_thread;
+
+    if (!s->filter_deferred)
+        return;
+
+    pthread_mutex_lock(&ft->lock);
+    while (ft->rows_filtered < ft->rows_ready)
+        pthread_cond_wait(&ft->done_cond, &ft->lock);
+    pthread_mutex_unlock(&ft->lock);
+}
+
+void ff_hevc_deferred_filter_uninit(HEVCContext *s)
+{
+    HEVCFilterThread *ft = s->filter_thread;
+
+    if (!ft)
+        return;
+
+    pthread_mutex_lock(&ft->lock);
+    ft->die = 1;
+    pthread_cond_signal(&ft->cond);
+    pthread_mutex_unlock(&ft->lock);
+
+    pthread_join(ft->thread, NULL);
+
+    pthread_mutex_destroy(&ft->lock);
+    pthread_cond_destroy(&ft->cond);
+    pthread_cond_destroy(&ft->done_cond);
+    av_buffer_unref(&ft->sps_ref);
+    av_buffer_unref(&ft->pps_ref);
+    av_freep(&ft->s);
+    av_freep(&ft->lc);
+    av_freep(&s->filter_thread);
+    s->filter_deferred = 0;
+}
+#else
+int ff_hevc_deferred_filter_start(HEVCContext *s)
+{
+    s->filter_deferred = 0;
+    return 0;
+}
+
+void ff_hevc_deferred_filter_row(HEVCContext *s, int ctb_row)
+{
+}
+
+void ff_hevc_deferred_filter_sync(HEVCContext *s)
+{
+}
+
+void ff_hevc_deferred_filter_uninit(HEVCContext *s)
+{
+}
+#endif /* HAVE_THREADS */
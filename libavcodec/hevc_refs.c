@@ -38,11 +38,10 @@ void ff_hevc_unref_frame(HEVCContext *s, HEVCFrame *frame, int flags)
     if (!frame->flags) {
         ff_thread_release_buffer(s->avctx, &frame->tf);
 
-        av_buffer_unref(&frame->tab_mvf_buf);
+        av_buffer_unref(&frame->meta_buf);
         frame->tab_mvf = NULL;
 
         av_buffer_unref(&frame->rpl_buf);
-        av_buffer_unref(&frame->rpl_tab_buf);
         frame->rpl_tab    = NULL;
         frame->refPicList = NULL;
 
@@ -78,6 +77,25 @@ void ff_hevc_flush_dpb(HEVCContext *s)
         ff_hevc_unref_frame(s, &s->DPB[i], ~0);
 }
 
+static void update_dpb_peak(HEVCContext *s)
+{
+    size_t size = 0;
+    int nb_frames = 0;
+    int i, j;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(s->DPB); i++) {
+        AVFrame *f = s->DPB[i].frame;
+        if (!f->buf[0])
+            continue;
+        nb_frames++;
+        for (j = 0; j < FF_ARRAY_ELEMS(f->buf) && f->buf[j]; j++)
+            size += f->buf[j]->size;
+    }
+
+    s->dpb_peak      = FFMAX(s->dpb_peak,      nb_frames);
+    s->dpb_peak_size = FFMAX(s->dpb_peak_size, size);
+}
+
 static HEVCFrame *alloc_frame(HEVCContext *s)
 {
     int i, j, ret;
@@ -95,15 +113,12 @@ static HEVCFrame *alloc_frame(HEVCContext *s)
         if (!frame->rpl_buf)
             goto fail;
 
-        frame->tab_mvf_buf = av_buffer_pool_get(s->tab_mvf_pool);
-        if (!frame->tab_mvf_buf)
-            goto fail;
-        frame->tab_mvf = (MvField *)frame->tab_mvf_buf->data;
-
-        frame->rpl_tab_buf = av_buffer_pool_get(s->rpl_tab_pool);
-        if (!frame->rpl_tab_buf)
+        frame->meta_buf = av_buffer_pool_get(s->frame_meta_pool);
+        if (!frame->meta_buf)
             goto fail;
-        frame->rpl_tab   = (RefPicListTab **)frame->rpl_tab_buf->data;
+        frame->tab_mvf   = (MvField *)frame->meta_buf->data;
+        frame->rpl_tab   = (RefPicListTab **)(frame->meta_buf->data +
+                                              s->frame_meta_rpl_offset);
         frame->ctb_count = s->sps->ctb_width * s->sps->ctb_height;
         for (j = 0; j < frame->ctb_count; j++)
             frame->rpl_tab[j] = (RefPicListTab *)frame->rpl_buf->data;
@@ -122,6 +137,7 @@ static HEVCFrame *alloc_frame(HEVCContext *s)
             }
         }
 
+        update_dpb_peak(s);
         return frame;
 fail:
         ff_hevc_unref_frame(s, frame, ~0);
@@ -155,18 +171,54 @@ int ff_hevc_set_new_ref(HEVCContext *s, AVFrame **frame, int poc)
     *frame = ref->frame;
     s->ref = ref;
 
-    if (s->sh.pic_output_flag)
+    if (s->sh.pic_output_flag) {
         ref->flags = HEVC_FRAME_FLAG_OUTPUT | HEVC_FRAME_FLAG_SHORT_REF;
-    else
+
+        for (i = 0; i < FF_ARRAY_ELEMS(s->DPB); i++) {
+            HEVCFrame *frame = &s->DPB[i];
+            if ((frame->flags & HEVC_FRAME_FLAG_OUTPUT) && frame != ref &&
+                frame->sequence == s->seq_decode && frame->poc > poc)
+                frame->latency_count++;
+        }
+    } else
         ref->flags = HEVC_FRAME_FLAG_SHORT_REF;
 
     ref->poc      = poc;
     ref->sequence = s->seq_decode;
+    ref->latency_count = 0;
     ref->window   = s->sps->output_window;
 
     return 0;
 }
 
+/**
+ * The additional bumping conditions of C.5.2.2 and C.5.2.3, on top of the
+ * number of pictures waiting for output: a picture has waited for the
+ * maximum latency, or the DPB is full.
+ */
+static int bump_early(HEVCContext *s)
+{
+    const int layer   = s->sps->max_sub_layers - 1;
+    int max_latency   = s->sps->temporal_layer[layer].max_latency_increase;
+    int nb_dpb        = 0;
+    int i;
+
+    if (max_latency >= 0)
+        max_latency += s->sps->temporal_layer[layer].num_reorder_pics;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(s->DPB); i++) {
+        HEVCFrame *frame = &s->DPB[i];
+        if (!frame->flags || frame->sequence != s->seq_output || frame == s->ref)
+            continue;
+        nb_dpb++;
+        if ((frame->flags & HEVC_FRAME_FLAG_OUTPUT) && max_latency >= 0 &&
+            frame->latency_count >= max_latency)
+            return 1;
+    }
+
+    return nb_dpb >= s->sps->temporal_layer[layer].max_dec_pic_buffering;
+}
+
 int ff_hevc_output_frame(HEVCContext *s, AVFrame *out, int flush)
 {
     do {
@@ -198,7 +250,8 @@ int ff_hevc_output_frame(HEVCContext *s, AVFrame *out, int flush)
 
         /* wait for more frames before output */
         if (!flush && s->seq_output == s->seq_decode && s->sps &&
-            nb_output <= s->sps->temporal_layer[s->sps->max_sub_layers - 1].num_reorder_pics)
+            nb_output <= s->sps->temporal_layer[s->sps->max_sub_layers - 1].num_reorder_pics &&
+            !(s->bounded_dpb && nb_output && bump_early(s)))
             return 0;
 
         if (nb_output) {
@@ -219,8 +272,8 @@ int ff_hevc_output_frame(HEVCContext *s, AVFrame *out, int flush)
             for (i = 0; i < 3; i++) {
                 int hshift = (i > 0) ? desc->log2_chroma_w : 0;
                 int vshift = (i > 0) ? desc->log2_chroma_h : 0;
-                int off = ((frame->window.left_offset >> hshift) << pixel_shift) +
-                          (frame->window.top_offset   >> vshift) * dst->linesize[i];
+                int off = ((frame->window.left_offset >> (hshift + s->lowres)) << pixel_shift) +
+                          (frame->window.top_offset   >> (vshift + s->lowres)) * dst->linesize[i];
                 dst->data[i] += off;
             }
             av_log(s->avctx, AV_LOG_DEBUG,
@@ -414,8 +467,8 @@ static HEVCFrame *generate_missing_ref(HEVCContext *s, int poc)
                        frame->frame->buf[i]->size);
         } else {
             for (i = 0; frame->frame->data[i]; i++)
-                for (y = 0; y < (s->sps->height >> s->sps->vshift[i]); y++)
-                    for (x = 0; x < (s->sps->width >> s->sps->hshift[i]); x++) {
+                for (y = 0; y < (s->sps->height >> (s->sps->vshift[i] + s->lowres)); y++)
+                    for (x = 0; x < (s->sps->width >> (s->sps->hshift[i] + s->lowres)); x++) {
                         AV_WN16(frame->frame->data[i] + y * frame->frame->linesize[i] + 2 * x,
                                 1 << (s->sps->bit_depth - 1));
                     }
@@ -0,0 +1,673 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Bit-exactness test of the optimized HEVC DSP and intra prediction
+ * functions against the C
+ * reference implementation. Run it natively or through the target_exec
+ * wrapper (e.g. qemu-user) when cross compiling.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "avcodec.h"
+#include "hevc.h"
+#include "hevcdsp.h"
+#include "hevcpred.h"
+
+#define PIXEL_STRIDE    (4 * MAX_PB_SIZE)
+#define PIXEL_BUF_SIZE  ((MAX_PB_SIZE + 8) * PIXEL_STRIDE)
+#define SAO_STRIDE      (2 * MAX_PB_SIZE + FF_INPUT_BUFFER_PADDING_SIZE)
+#define SAO_BUF_SIZE    ((MAX_PB_SIZE + 7) * SAO_STRIDE * 2)
+
+static const uint8_t sao_tab[8] = { 0, 1, 2, 2, 3, 3, 4, 4 };
+
+static void fill_pixels(AVLFG *lfg, uint8_t *buf, int size, int bit_depth)
+{
+    int i;
+
+    /* mix in runs of similar values so the edge classes are all hit */
+    for (i = 0; i < size >> (bit_depth > 8); i++) {
+        unsigned r = av_lfg_get(lfg);
+        int v = (r & 3) ? (r >> 8) & ((1 << bit_depth) - 1)
+                        : (1 << (bit_depth - 1)) + ((r >> 8) % 3) - 1;
+        if (bit_depth > 8)
+            AV_WN16A(buf + 2 * i, v);
+        else
+            buf[i] = v;
+    }
+}
+
+static int compare_block(const uint8_t *a, const uint8_t *b, ptrdiff_t stride,
+                         int width, int height, int pixel_shift, int bit_depth,
+                         const char *name, int idx)
+{
+    int x, y;
+
+    for (y = 0; y < height; y++) {
+        if (memcmp(a + y * stride, b + y * stride, width << pixel_shift)) {
+            for (x = 0; x < width; x++) {
+                int va = pixel_shift ? (int16_t)AV_RN16A(a + y * stride + 2 * x) : a[y * stride + x];
+                int vb = pixel_shift ? (int16_t)AV_RN16A(b + y * stride + 2 * x) : b[y * stride + x];
+                if (va != vb) {
+                    fprintf(stderr, "%s[%d] %d-bit %dx%d: mismatch at (%d,%d): "
+                            "expected %d, got %d\n", name, idx, bit_depth,
+                            width, height, x, y, va, vb);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static void random_offsets(AVLFG *lfg, int16_t *offset_val, int bit_depth, int edge)
+{
+    int log2_max = FFMIN(bit_depth, 10) - 5;
+    int shift    = bit_depth - FFMIN(bit_depth, 10);
+    int k;
+
+    offset_val[0] = 0;
+    for (k = 1; k < 5; k++) {
+        int v = av_lfg_get(lfg) % (1 << log2_max);
+        if (edge ? k > 2 : av_lfg_get(lfg) & 1)
+            v = -v;
+        offset_val[k] = v * (1 << shift);
+    }
+}
+
+static int check_sao_band(HEVCDSPContext *ref, HEVCDSPContext *opt,
+                          AVLFG *lfg, int bit_depth, uint8_t *bufs[4])
+{
+    uint8_t *src = bufs[0], *dst0 = bufs[1], *dst1 = bufs[2];
+    int16_t offset_val[5];
+    int width, height;
+
+    for (width = 4; width <= MAX_PB_SIZE; width += 4) {
+        int tab = sao_tab[(FFALIGN(width, 8) >> 3) - 1];
+
+        if (ref->sao_band_filter[tab] == opt->sao_band_filter[tab])
+            continue;
+        for (height = 1; height <= MAX_PB_SIZE; height += 7) {
+            int left_class = av_lfg_get(lfg) & 31;
+
+            random_offsets(lfg, offset_val, bit_depth, 0);
+            fill_pixels(lfg, src, PIXEL_BUF_SIZE, bit_depth);
+            memset(dst0, 0, PIXEL_BUF_SIZE);
+            memset(dst1, 0, PIXEL_BUF_SIZE);
+            ref->sao_band_filter[tab](dst0, src, PIXEL_STRIDE, PIXEL_STRIDE,
+                                      offset_val, left_class, width, height);
+            opt->sao_band_filter[tab](dst1, src, PIXEL_STRIDE, PIXEL_STRIDE,
+                                      offset_val, left_class, width, height);
+            if (compare_block(dst0, dst1, PIXEL_STRIDE, width, height,
+                              bit_depth > 8, bit_depth, "sao_band_filter", tab))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+static int check_sao_edge(HEVCDSPContext *ref, HEVCDSPContext *opt,
+                          AVLFG *lfg, int bit_depth, uint8_t *bufs[4])
+{
+    /* same layout as the edge_emu_buffer used by sao_filter_CTB() */
+    uint8_t *src = bufs[3] + SAO_STRIDE + FF_INPUT_BUFFER_PADDING_SIZE;
+    uint8_t *dst0 = bufs[1], *dst1 = bufs[2];
+    int16_t offset_val[5];
+    int width, height, eo;
+
+    for (width = 4; width <= MAX_PB_SIZE; width += 4) {
+        int tab = sao_tab[(FFALIGN(width, 8) >> 3) - 1];
+
+        if (ref->sao_edge_filter[tab] == opt->sao_edge_filter[tab])
+            continue;
+        for (height = 1; height <= MAX_PB_SIZE; height += 7) {
+            for (eo = 0; eo < 4; eo++) {
+                random_offsets(lfg, offset_val, bit_depth, 1);
+                fill_pixels(lfg, bufs[3], SAO_BUF_SIZE, bit_depth);
+                memset(dst0, 0, PIXEL_BUF_SIZE);
+                memset(dst1, 0, PIXEL_BUF_SIZE);
+                ref->sao_edge_filter[tab](dst0, src, PIXEL_STRIDE, offset_val,
+                                          eo, width, height);
+                opt->sao_edge_filter[tab](dst1, src, PIXEL_STRIDE, offset_val,
+                                          eo, width, height);
+                if (compare_block(dst0, dst1, PIXEL_STRIDE, width, height,
+                                  bit_depth > 8, bit_depth, "sao_edge_filter", tab))
+                    return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void fill_coeffs(AVLFG *lfg, int16_t *buf, int count)
+{
+    int i;
+
+    /* roughly the range of a 4/8-tap filtered intermediate */
+    for (i = 0; i < count; i++)
+        buf[i] = (int)(av_lfg_get(lfg) % 30001) - 9000;
+}
+
+static int check_epel(HEVCDSPContext *ref, HEVCDSPContext *opt,
+                      AVLFG *lfg, int bit_depth, uint8_t *bufs[4])
+{
+    static const int widths[10] = { 2, 4, 6, 8, 12, 16, 24, 32, 48, 64 };
+    int pixel_shift = bit_depth > 8;
+    uint8_t *src = bufs[0] + 3 * PIXEL_STRIDE + 16;
+    uint8_t *dst0 = bufs[1], *dst1 = bufs[2];
+    int16_t *src2 = (int16_t *)bufs[3];
+    int idx, v, h;
+
+    for (idx = 0; idx < 10; idx++) {
+        int width = widths[idx];
+        for (v = 0; v < 2; v++) {
+            for (h = 0; h < 2; h++) {
+                int height = FFMAX(width >> (av_lfg_get(lfg) & 1), 2);
+                int mx     = h ? 1 + av_lfg_get(lfg) % 7 : 0;
+                int my     = v ? 1 + av_lfg_get(lfg) % 7 : 0;
+                int denom  = av_lfg_get(lfg) % 8;
+                int wx0    = (int)(av_lfg_get(lfg) % 256) - 128;
+                int wx1    = (int)(av_lfg_get(lfg) % 256) - 128;
+                int ox0    = (int)(av_lfg_get(lfg) % 256) - 128;
+                int ox1    = (int)(av_lfg_get(lfg) % 256) - 128;
+
+                fill_pixels(lfg, bufs[0], PIXEL_BUF_SIZE, bit_depth);
+                fill_coeffs(lfg, src2, MAX_PB_SIZE * MAX_PB_SIZE);
+
+#define CHECK_EPEL(func, type, stride, shift, ...)                              \
+                if (ref->func[idx][v][h] != opt->func[idx][v][h]) {             \
+                    memset(dst0, 0, PIXEL_BUF_SIZE);                            \
+                    memset(dst1, 0, PIXEL_BUF_SIZE);                            \
+                    ref->func[idx][v][h]((type *)dst0, __VA_ARGS__);            \
+                    opt->func[idx][v][h]((type *)dst1, __VA_ARGS__);            \
+                    if (compare_block(dst0, dst1, stride, width, height,        \
+                                      shift, bit_depth, #func, idx)) {          \
+                        fprintf(stderr, "  mx %d my %d\n", mx, my);             \
+                        return 1;                                               \
+                    }                                                           \
+                }
+                CHECK_EPEL(put_hevc_epel, int16_t, MAX_PB_SIZE * sizeof(int16_t), 1,
+                           src, PIXEL_STRIDE, height, mx, my, width)
+                CHECK_EPEL(put_hevc_epel_uni, uint8_t, PIXEL_STRIDE, pixel_shift,
+                           PIXEL_STRIDE, src, PIXEL_STRIDE, height, mx, my, width)
+                CHECK_EPEL(put_hevc_epel_bi, uint8_t, PIXEL_STRIDE, pixel_shift,
+                           PIXEL_STRIDE, src, PIXEL_STRIDE, src2, height, mx, my, width)
+                CHECK_EPEL(put_hevc_epel_uni_w, uint8_t, PIXEL_STRIDE, pixel_shift,
+                           PIXEL_STRIDE, src, PIXEL_STRIDE, height, denom, wx1, ox1,
+                           mx, my, width)
+                CHECK_EPEL(put_hevc_epel_bi_w, uint8_t, PIXEL_STRIDE, pixel_shift,
+                           PIXEL_STRIDE, src, PIXEL_STRIDE, src2, height, denom,
+                           wx0, wx1, ox0, ox1, mx, my, width)
+#undef CHECK_EPEL
+            }
+        }
+    }
+    return 0;
+}
+
+static int check_qpel(HEVCDSPContext *ref, HEVCDSPContext *opt,
+                      AVLFG *lfg, int bit_depth, uint8_t *bufs[4])
+{
+    static const int widths[10] = { 2, 4, 6, 8, 12, 16, 24, 32, 48, 64 };
+    int pixel_shift = bit_depth > 8;
+    uint8_t *src = bufs[0] + 3 * PIXEL_STRIDE + 16;
+    uint8_t *dst0 = bufs[1], *dst1 = bufs[2];
+    int16_t *src2 = (int16_t *)bufs[3];
+    int idx, v, h;
+
+    for (idx = 0; idx < 10; idx++) {
+        int width = widths[idx];
+        for (v = 0; v < 2; v++) {
+            for (h = 0; h < 2; h++) {
+                int height = FFMAX(width >> (av_lfg_get(lfg) & 1), 2);
+                int mx     = h ? 1 + av_lfg_get(lfg) % 3 : 0;
+                int my     = v ? 1 + av_lfg_get(lfg) % 3 : 0;
+                int denom  = av_lfg_get(lfg) % 8;
+                int wx0    = (int)(av_lfg_get(lfg) % 256) - 128;
+                int wx1    = (int)(av_lfg_get(lfg) % 256) - 128;
+                int ox0    = (int)(av_lfg_get(lfg) % 256) - 128;
+                int ox1    = (int)(av_lfg_get(lfg) % 256) - 128;
+
+                fill_pixels(lfg, bufs[0], PIXEL_BUF_SIZE, bit_depth);
+                fill_coeffs(lfg, src2, MAX_PB_SIZE * MAX_PB_SIZE);
+
+#define CHECK_QPEL(func, type, stride, shift, ...)                              \
+                if (ref->func[idx][v][h] != opt->func[idx][v][h]) {             \
+                    memset(dst0, 0, PIXEL_BUF_SIZE);                            \
+                    memset(dst1, 0, PIXEL_BUF_SIZE);                            \
+                    ref->func[idx][v][h]((type *)dst0, __VA_ARGS__);            \
+                    opt->func[idx][v][h]((type *)dst1, __VA_ARGS__);            \
+                    if (compare_block(dst0, dst1, stride, width, height,        \
+                                      shift, bit_depth, #func, idx)) {          \
+                        fprintf(stderr, "  mx %d my %d\n", mx, my);             \
+                        return 1;                                               \
+                    }                                                           \
+                }
+                CHECK_QPEL(put_hevc_qpel, int16_t, MAX_PB_SIZE * sizeof(int16_t), 1,
+                           src, PIXEL_STRIDE, height, mx, my, width)
+                CHECK_QPEL(put_hevc_qpel_uni, uint8_t, PIXEL_STRIDE, pixel_shift,
+                           PIXEL_STRIDE, src, PIXEL_STRIDE, height, mx, my, width)
+                CHECK_QPEL(put_hevc_qpel_bi, uint8_t, PIXEL_STRIDE, pixel_shift,
+                           PIXEL_STRIDE, src, PIXEL_STRIDE, src2, height, mx, my, width)
+                CHECK_QPEL(put_hevc_qpel_uni_w, uint8_t, PIXEL_STRIDE, pixel_shift,
+                           PIXEL_STRIDE, src, PIXEL_STRIDE, height, denom, wx1, ox1,
+                           mx, my, width)
+                CHECK_QPEL(put_hevc_qpel_bi_w, uint8_t, PIXEL_STRIDE, pixel_shift,
+                           PIXEL_STRIDE, src, PIXEL_STRIDE, src2, height, denom,
+                           wx0, wx1, ox0, ox1, mx, my, width)
+#undef CHECK_QPEL
+            }
+        }
+    }
+    return 0;
+}
+
+static int check_transform(HEVCDSPContext *ref, HEVCDSPContext *opt,
+                           AVLFG *lfg, int bit_depth, uint8_t *bufs[4])
+{
+    int16_t *coeffs0 = (int16_t *)bufs[1], *coeffs1 = (int16_t *)bufs[2];
+    int log2_size, i, x, y;
+
+    for (log2_size = 2; log2_size <= 5; log2_size++) {
+        int size = 1 << log2_size;
+
+        for (i = 0; i < 16; i++) {
+            /* nonzero coefficients only up to the last significant position,
+             * with col_limit derived the way the residual decoder does it */
+            int last_x = av_lfg_get(lfg) % size, last_y = av_lfg_get(lfg) % size;
+            int max_xy = FFMAX(last_x, last_y);
+            int col_limit = last_x + last_y + 4;
+            int mode = av_lfg_get(lfg) & 1;
+
+            if (!max_xy)
+                continue;
+            if (max_xy < 4)
+                col_limit = FFMIN(4, col_limit);
+            else if (max_xy < 8)
+                col_limit = FFMIN(8, col_limit);
+            else if (max_xy < 12)
+                col_limit = FFMIN(24, col_limit);
+
+            memset(coeffs0, 0, size * size * sizeof(*coeffs0));
+            for (y = 0; y <= last_y; y++)
+                for (x = 0; x <= last_x; x++)
+                    if (!(av_lfg_get(lfg) % 3))
+                        coeffs0[y * size + x] = (int)(av_lfg_get(lfg) % 6001) - 3000;
+            memcpy(coeffs1, coeffs0, size * size * sizeof(*coeffs0));
+            if (ref->idct[log2_size - 2] != opt->idct[log2_size - 2]) {
+                ref->idct[log2_size - 2](coeffs0, col_limit);
+                opt->idct[log2_size - 2](coeffs1, col_limit);
+                if (compare_block(bufs[1], bufs[2], size * sizeof(*coeffs0), size,
+                                  size, 1, bit_depth, "idct", log2_size - 2))
+                    return 1;
+            }
+
+            fill_coeffs(lfg, coeffs0, size * size);
+            memcpy(coeffs1, coeffs0, size * size * sizeof(*coeffs0));
+            if (ref->transform_skip != opt->transform_skip) {
+                ref->transform_skip(coeffs0, log2_size);
+                opt->transform_skip(coeffs1, log2_size);
+                if (compare_block(bufs[1], bufs[2], size * sizeof(*coeffs0), size,
+                                  size, 1, bit_depth, "transform_skip", log2_size - 2))
+                    return 1;
+            }
+            if (ref->transform_rdpcm != opt->transform_rdpcm) {
+                ref->transform_rdpcm(coeffs0, log2_size, mode);
+                opt->transform_rdpcm(coeffs1, log2_size, mode);
+                if (compare_block(bufs[1], bufs[2], size * sizeof(*coeffs0), size,
+                                  size, 1, bit_depth, "transform_rdpcm", mode))
+                    return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int check_transform_add(HEVCDSPContext *ref, HEVCDSPContext *opt,
+                               AVLFG *lfg, int bit_depth, uint8_t *bufs[4])
+{
+    int pixel_shift = bit_depth > 8;
+    int16_t *coeffs0 = (int16_t *)bufs[3];
+    int16_t *coeffs1 = coeffs0 + MAX_TB_SIZE * MAX_TB_SIZE;
+    int log2_size, i, k;
+
+    for (log2_size = 2; log2_size <= 5; log2_size++) {
+        int size = 1 << log2_size;
+
+        if (ref->transform_add[log2_size - 2] == opt->transform_add[log2_size - 2])
+            continue;
+        for (i = 0; i < 16; i++) {
+            /* the full int16 range, so that the sums saturate both ways */
+            for (k = 0; k < size * size; k++)
+                coeffs0[k] = (int16_t)av_lfg_get(lfg) >> (i & 7);
+            memcpy(coeffs1, coeffs0, size * size * sizeof(*coeffs0));
+            fill_pixels(lfg, bufs[1], PIXEL_BUF_SIZE, bit_depth);
+            memcpy(bufs[2], bufs[1], PIXEL_BUF_SIZE);
+            ref->transform_add[log2_size - 2](bufs[1], coeffs0, PIXEL_STRIDE);
+            opt->transform_add[log2_size - 2](bufs[2], coeffs1, PIXEL_STRIDE);
+            if (compare_block(bufs[1], bufs[2], PIXEL_STRIDE, size, size,
+                              pixel_shift, bit_depth, "transform_add", log2_size - 2))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+static int check_idct_dc(HEVCDSPContext *ref, HEVCDSPContext *opt,
+                         AVLFG *lfg, int bit_depth, uint8_t *bufs[4])
+{
+    int16_t *coeffs0 = (int16_t *)bufs[1], *coeffs1 = (int16_t *)bufs[2];
+    int log2_size, i;
+
+    for (log2_size = 2; log2_size <= 5; log2_size++) {
+        int size = 1 << log2_size;
+
+        if (ref->idct_dc[log2_size - 2] == opt->idct_dc[log2_size - 2])
+            continue;
+        for (i = 0; i < 16; i++) {
+            memset(coeffs0, 0, size * size * sizeof(*coeffs0));
+            coeffs0[0] = i ? (int16_t)av_lfg_get(lfg) : INT16_MAX;
+            memcpy(coeffs1, coeffs0, size * size * sizeof(*coeffs0));
+            ref->idct_dc[log2_size - 2](coeffs0);
+            opt->idct_dc[log2_size - 2](coeffs1);
+            if (compare_block(bufs[1], bufs[2], size * sizeof(*coeffs0), size,
+                              size, 1, bit_depth, "idct_dc", log2_size - 2))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/* 16x16 block around an edge in the middle, smooth enough for the filter
+ * decisions to go every way */
+static void fill_deblock(AVLFG *lfg, uint8_t *buf, int bit_depth, int vertical)
+{
+    int base  = 32 + av_lfg_get(lfg) % 192;
+    int slope = (int)(av_lfg_get(lfg) % 5) - 2;
+    int step  = av_lfg_get(lfg) & 1 ? (int)(av_lfg_get(lfg) % 41) - 20 : 0;
+    int noise = av_lfg_get(lfg) % 4;
+    int x, y;
+
+    for (y = 0; y < 16; y++) {
+        for (x = 0; x < 16; x++) {
+            int a = vertical ? x : y;
+            int v = base + slope * a + (a >= 8 ? step : 0);
+            if (noise)
+                v += (int)(av_lfg_get(lfg) % (2 * noise + 1)) - noise;
+            v = av_clip_uint8(v) << (bit_depth - 8) |
+                (av_lfg_get(lfg) & ((1 << (bit_depth - 8)) - 1));
+            if (bit_depth > 8)
+                AV_WN16A(buf + y * PIXEL_STRIDE + 2 * x, v);
+            else
+                buf[y * PIXEL_STRIDE + x] = v;
+        }
+    }
+}
+
+static int check_loop_filter(HEVCDSPContext *ref, HEVCDSPContext *opt,
+                             AVLFG *lfg, int bit_depth, uint8_t *bufs[4],
+                             int chroma)
+{
+    int pixel_shift = bit_depth > 8;
+    int offset = 8 * PIXEL_STRIDE + (8 << pixel_shift);
+    int vertical, i, k;
+
+    for (vertical = 0; vertical < 2; vertical++) {
+        for (i = 0; i < 256; i++) {
+            int beta = av_lfg_get(lfg) % 65;
+            int32_t tc[2];
+            uint8_t no_p[2], no_q[2];
+
+            for (k = 0; k < 2; k++) {
+                tc[k]   = av_lfg_get(lfg) % 25;
+                no_p[k] = !(av_lfg_get(lfg) % 8);
+                no_q[k] = !(av_lfg_get(lfg) % 8);
+            }
+            fill_deblock(lfg, bufs[1], bit_depth, vertical);
+            memcpy(bufs[2], bufs[1], 16 * PIXEL_STRIDE);
+
+#define CALL_FILTER(ctx, buf)                                                 \
+            if (chroma) {                                                     \
+                if (vertical)                                                 \
+                    ctx->hevc_v_loop_filter_chroma(buf + offset, PIXEL_STRIDE, \
+                                                   tc, no_p, no_q);           \
+                else                                                          \
+                    ctx->hevc_h_loop_filter_chroma(buf + offset, PIXEL_STRIDE, \
+                                                   tc, no_p, no_q);           \
+            } else {                                                          \
+                if (vertical)                                                 \
+                    ctx->hevc_v_loop_filter_luma(buf + offset, PIXEL_STRIDE,  \
+                                                 beta, tc, no_p, no_q);       \
+                else                                                          \
+                    ctx->hevc_h_loop_filter_luma(buf + offset, PIXEL_STRIDE,  \
+                                                 beta, tc, no_p, no_q);       \
+            }
+            CALL_FILTER(ref, bufs[1])
+            CALL_FILTER(opt, bufs[2])
+#undef CALL_FILTER
+            if (compare_block(bufs[1], bufs[2], PIXEL_STRIDE, 16, 16, pixel_shift,
+                              bit_depth, chroma ? "loop_filter_chroma" : "loop_filter_luma",
+                              vertical)) {
+                fprintf(stderr, "  beta %d tc %d %d no_p %d %d no_q %d %d\n", beta,
+                        tc[0], tc[1], no_p[0], no_p[1], no_q[0], no_q[1]);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int check_loop_filter_luma(HEVCDSPContext *ref, HEVCDSPContext *opt,
+                                  AVLFG *lfg, int bit_depth, uint8_t *bufs[4])
+{
+    if (ref->hevc_h_loop_filter_luma == opt->hevc_h_loop_filter_luma &&
+        ref->hevc_v_loop_filter_luma == opt->hevc_v_loop_filter_luma)
+        return 0;
+    return check_loop_filter(ref, opt, lfg, bit_depth, bufs, 0);
+}
+
+static int check_loop_filter_chroma(HEVCDSPContext *ref, HEVCDSPContext *opt,
+                                    AVLFG *lfg, int bit_depth, uint8_t *bufs[4])
+{
+    if (ref->hevc_h_loop_filter_chroma == opt->hevc_h_loop_filter_chroma &&
+        ref->hevc_v_loop_filter_chroma == opt->hevc_v_loop_filter_chroma)
+        return 0;
+    return check_loop_filter(ref, opt, lfg, bit_depth, bufs, 1);
+}
+
+static void random_motion(AVLFG *lfg, DeblockMotion *m)
+{
+    int k;
+
+    /* mostly small vectors and few reference pictures so that both
+     * orderings match often, plus the int16 extremes */
+    for (k = 0; k < 4; k++) {
+        unsigned r = av_lfg_get(lfg);
+        m->mv[k >> 1][k & 1] = !(r & 15) ? ((r >> 4) & 1 ? INT16_MAX : INT16_MIN)
+                                         : (int)((r >> 4) % 13) - 6;
+    }
+    for (k = 0; k < 2; k++)
+        m->ref[k] = (int)(av_lfg_get(lfg) % 3) - 1;
+}
+
+static int check_deblocking_bs(HEVCDSPContext *ref, HEVCDSPContext *opt,
+                               AVLFG *lfg, uint8_t *bufs[4])
+{
+    DeblockMotion *p = (DeblockMotion *)bufs[0];
+    DeblockMotion *q = p + 16;
+    uint8_t *bs0 = bufs[1], *bs1 = bufs[2];
+    int i, k, n;
+
+    if (ref->deblocking_bs == opt->deblocking_bs)
+        return 0;
+
+    for (i = 0; i < 256; i++) {
+        int stride = 1 + av_lfg_get(lfg) % 32;
+
+        n = 1 + av_lfg_get(lfg) % 16;
+        for (k = 0; k < 16; k++) {
+            random_motion(lfg, &p[k]);
+            switch (av_lfg_get(lfg) % 3) {
+            case 0:
+                q[k] = p[k];
+                q[k].mv[0][1] += (int)(av_lfg_get(lfg) % 9) - 4;
+                break;
+            case 1:
+                q[k].mv[0][0] = p[k].mv[1][0];
+                q[k].mv[0][1] = p[k].mv[1][1] + 3;
+                q[k].mv[1][0] = p[k].mv[0][0] - 3;
+                q[k].mv[1][1] = p[k].mv[0][1];
+                q[k].ref[0]   = p[k].ref[1];
+                q[k].ref[1]   = p[k].ref[0];
+                break;
+            default:
+                random_motion(lfg, &q[k]);
+            }
+        }
+        memset(bs0, 0xff, 16 * 32);
+        memset(bs1, 0xff, 16 * 32);
+        ref->deblocking_bs(bs0, stride, p, q, n);
+        opt->deblocking_bs(bs1, stride, p, q, n);
+        if (compare_block(bs0, bs1, 0, 16 * 32, 1, 0, 8, "deblocking_bs", n))
+            return 1;
+    }
+    return 0;
+}
+
+static int check_pred(HEVCPredContext *ref, HEVCPredContext *opt,
+                      AVLFG *lfg, int bit_depth, uint8_t *bufs[4])
+{
+    int pixel_shift = bit_depth > 8;
+    /* top and left each hold 2 * size + 1 samples starting at index -1 */
+    uint8_t *top  = bufs[0] + 16;
+    uint8_t *left = bufs[0] + 16 + (4 * MAX_TB_SIZE << pixel_shift);
+    uint8_t *dst0 = bufs[1], *dst1 = bufs[2];
+    uint8_t *filt0 = bufs[3] + 16, *filt1 = filt0 + (8 * MAX_TB_SIZE << pixel_shift);
+    int log2_size, mode, c_idx;
+
+    for (log2_size = 2; log2_size <= 5; log2_size++) {
+        int size = 1 << log2_size;
+
+        for (mode = 0; mode < 35; mode++) {
+            for (c_idx = 0; c_idx < 2; c_idx++) {
+                fill_pixels(lfg, bufs[0], PIXEL_BUF_SIZE, bit_depth);
+                memcpy(left - (1 << pixel_shift), top - (1 << pixel_shift),
+                       1 << pixel_shift);
+                memset(dst0, 0, PIXEL_BUF_SIZE);
+                memset(dst1, 0, PIXEL_BUF_SIZE);
+                if (mode == 0) {
+                    if (ref->pred_planar[log2_size - 2] == opt->pred_planar[log2_size - 2])
+                        continue;
+                    ref->pred_planar[log2_size - 2](dst0, top, left, PIXEL_STRIDE >> pixel_shift);
+                    opt->pred_planar[log2_size - 2](dst1, top, left, PIXEL_STRIDE >> pixel_shift);
+                } else if (mode == 1) {
+                    if (ref->pred_dc == opt->pred_dc)
+                        continue;
+                    ref->pred_dc(dst0, top, left, PIXEL_STRIDE >> pixel_shift, log2_size, c_idx);
+                    opt->pred_dc(dst1, top, left, PIXEL_STRIDE >> pixel_shift, log2_size, c_idx);
+                } else {
+                    if (ref->pred_angular[log2_size - 2] == opt->pred_angular[log2_size - 2])
+                        continue;
+                    ref->pred_angular[log2_size - 2](dst0, top, left, PIXEL_STRIDE >> pixel_shift,
+                                                     c_idx, mode);
+                    opt->pred_angular[log2_size - 2](dst1, top, left, PIXEL_STRIDE >> pixel_shift,
+                                                     c_idx, mode);
+                }
+                if (compare_block(dst0, dst1, PIXEL_STRIDE, size, size, pixel_shift,
+                                  bit_depth, mode ? mode == 1 ? "pred_dc" : "pred_angular"
+                                                  : "pred_planar", mode))
+                    return 1;
+            }
+        }
+
+        if (size > 4 && ref->ref_filter != opt->ref_filter) {
+            fill_pixels(lfg, bufs[0], PIXEL_BUF_SIZE, bit_depth);
+            memcpy(left - (1 << pixel_shift), top - (1 << pixel_shift),
+                   1 << pixel_shift);
+            ref->ref_filter(filt0, filt0 + (4 * MAX_TB_SIZE << pixel_shift), left, top, size);
+            opt->ref_filter(filt1, filt1 + (4 * MAX_TB_SIZE << pixel_shift), left, top, size);
+            if (compare_block(filt0 - (1 << pixel_shift), filt1 - (1 << pixel_shift),
+                              0, 2 * size + 1, 1, pixel_shift, bit_depth, "ref_filter", 0) ||
+                compare_block(filt0 + ((4 * MAX_TB_SIZE - 1) << pixel_shift),
+                              filt1 + ((4 * MAX_TB_SIZE - 1) << pixel_shift),
+                              0, 2 * size + 1, 1, pixel_shift, bit_depth, "ref_filter", 1))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    static const int bit_depths[] = { 8, 9, 10, 12 };
+    HEVCDSPContext ref, opt;
+    HEVCPredContext pred_ref, pred_opt;
+    AVLFG lfg;
+    uint8_t *bufs[4];
+    int i, ret = 0;
+
+    for (i = 0; i < 3; i++)
+        bufs[i] = av_malloc(PIXEL_BUF_SIZE);
+    bufs[3] = av_malloc(SAO_BUF_SIZE);
+    if (!bufs[0] || !bufs[1] || !bufs[2] || !bufs[3]) {
+        ret = 2;
+        goto end;
+    }
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(bit_depths); i++) {
+        int bit_depth = bit_depths[i];
+
+        av_force_cpu_flags(0);
+        ff_hevc_dsp_init(&ref, bit_depth);
+        av_force_cpu_flags(-1);
+        ff_hevc_dsp_init(&opt, bit_depth);
+        av_force_cpu_flags(0);
+        ff_hevc_pred_init(&pred_ref, bit_depth);
+        av_force_cpu_flags(-1);
+        ff_hevc_pred_init(&pred_opt, bit_depth);
+
+        ret |= check_sao_band(&ref, &opt, &lfg, bit_depth, bufs);
+        ret |= check_sao_edge(&ref, &opt, &lfg, bit_depth, bufs);
+        ret |= check_epel(&ref, &opt, &lfg, bit_depth, bufs);
+        ret |= check_qpel(&ref, &opt, &lfg, bit_depth, bufs);
+        ret |= check_transform(&ref, &opt, &lfg, bit_depth, bufs);
+        ret |= check_transform_add(&ref, &opt, &lfg, bit_depth, bufs);
+        ret |= check_idct_dc(&ref, &opt, &lfg, bit_depth, bufs);
+        ret |= check_loop_filter_luma(&ref, &opt, &lfg, bit_depth, bufs);
+        ret |= check_loop_filter_chroma(&ref, &opt, &lfg, bit_depth, bufs);
+        ret |= check_deblocking_bs(&ref, &opt, &lfg, bufs);
+        ret |= check_pred(&pred_ref, &pred_opt, &lfg, bit_depth, bufs);
+    }
+
+end:
+    for (i = 0; i < 4; i++)
+        av_free(bufs[i]);
+    return ret;
+}
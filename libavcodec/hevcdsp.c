@@ -107,6 +107,25 @@ DECLARE_ALIGNED(16, const int8_t, ff_hevc_qpel_filters[3][16]) = {
     {  0,  1, -5, 17, 58,-10,  4, -1,  0,  1, -5, 17, 58,-10,  4, -1}
 };
 
+static av_always_inline int mv_far(const int16_t *a, const int16_t *b)
+{
+    return FFABS(a[0] - b[0]) >= 4 || FFABS(a[1] - b[1]) >= 4;
+}
+
+static void deblocking_bs_c(uint8_t *bs, ptrdiff_t stride, const DeblockMotion *p,
+                            const DeblockMotion *q, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++, p++, q++) {
+        int same  = p->ref[0] == q->ref[0] && p->ref[1] == q->ref[1] &&
+                    !mv_far(p->mv[0], q->mv[0]) && !mv_far(p->mv[1], q->mv[1]);
+        int cross = p->ref[0] == q->ref[1] && p->ref[1] == q->ref[0] &&
+                    !mv_far(p->mv[0], q->mv[1]) && !mv_far(p->mv[1], q->mv[0]);
+        bs[i * stride] = !(same || cross);
+    }
+}
+
 #define BIT_DEPTH 8
 #include "hevcdsp_template.c"
 #undef BIT_DEPTH
@@ -211,6 +230,7 @@ void ff_hevc_dsp_init(HEVCDSPContext *hevcdsp, int bit_depth)
     hevcdsp->idct_dc[1]             = FUNC(idct_8x8_dc, depth);             \
     hevcdsp->idct_dc[2]             = FUNC(idct_16x16_dc, depth);           \
     hevcdsp->idct_dc[3]             = FUNC(idct_32x32_dc, depth);           \
+    hevcdsp->transform_add_lowres   = FUNC(transform_add_lowres, depth);    \
                                                                             \
     hevcdsp->sao_band_filter[0] =                                              \
     hevcdsp->sao_band_filter[1] =                                              \
@@ -231,6 +251,8 @@ void ff_hevc_dsp_init(HEVCDSPContext *hevcdsp, int bit_depth)
     EPEL_FUNCS(depth);                                                         \
     EPEL_UNI_FUNCS(depth);                                                     \
     EPEL_BI_FUNCS(depth);                                                      \
+    hevcdsp->put_hevc_lowres   = FUNC(put_hevc_lowres, depth);                 \
+    hevcdsp->put_hevc_lowres_w = FUNC(put_hevc_lowres_w, depth);               \
                                                                                \
     hevcdsp->hevc_h_loop_filter_luma     = FUNC(hevc_h_loop_filter_luma, depth);   \
     hevcdsp->hevc_v_loop_filter_luma     = FUNC(hevc_v_loop_filter_luma, depth);   \
@@ -257,8 +279,12 @@ int i = 0;
         break;
     }
 
+    hevcdsp->deblocking_bs = deblocking_bs_c;
+
     if (ARCH_X86)
         ff_hevc_dsp_init_x86(hevcdsp, bit_depth);
+    if (ARCH_AARCH64)
+        ff_hevcdsp_init_aarch64(hevcdsp, bit_depth);
     if (ARCH_ARM)
         ff_hevcdsp_init_arm(hevcdsp, bit_depth);
     if (ARCH_MIPS)
@@ -42,6 +42,17 @@ typedef struct SAOParams {
     uint8_t type_idx[3];    ///< sao_type_idx
 } SAOParams;
 
+/**
+ * Motion of the block on one side of a deblocking edge segment. ref holds
+ * the POC of the reference pictures relative to the current picture, which
+ * is never 0; a uni-predicted block uses slot 0 and has a zero vector and
+ * ref 0 in slot 1.
+ */
+typedef struct DeblockMotion {
+    int16_t mv[2][2];
+    int32_t ref[2];
+} DeblockMotion;
+
 typedef struct HEVCDSPContext {
     void (*put_pcm)(uint8_t *_dst, ptrdiff_t _stride, int width, int height,
                     struct GetBitContext *gb, int pcm_bit_depth);
@@ -58,6 +69,13 @@ typedef struct HEVCDSPContext {
 
     void (*idct_dc[4])(int16_t *coeffs);
 
+    /**
+     * Add the 1 << log2_size square residual to the block at dst, keeping
+     * the last sample of each 1 << lowres square cell (lowres decoding).
+     */
+    void (*transform_add_lowres)(uint8_t *_dst, int16_t *coeffs, ptrdiff_t _stride,
+                                 int log2_size, int lowres);
+
     void (*sao_band_filter[5])(uint8_t *_dst, uint8_t *_src, ptrdiff_t _stride_dst, ptrdiff_t _stride_src,
                                int16_t *sao_offset_val, int sao_left_class, int width, int height);
 
@@ -98,6 +116,34 @@ typedef struct HEVCDSPContext {
                                          int height, int denom, int wx0, int ox0, int wx1,
                                          int ox1, intptr_t mx, intptr_t my, int width);
 
+    /**
+     * Bilinear interpolation for lowres decoding, into the intermediate
+     * 14 bit format of put_hevc_qpel. mx and my are the position of the
+     * block in src in units of 1 / (1 << log2_scale_x/y) samples; samples
+     * outside of src_width x src_height are replicated from the edges.
+     */
+    void (*put_hevc_lowres)(int16_t *dst, const uint8_t *_src, ptrdiff_t _srcstride,
+                            int src_width, int src_height, int mx, int my,
+                            int log2_scale_x, int log2_scale_y, int width, int height);
+    /**
+     * Weighted (bi)prediction of the put_hevc_lowres output; src1 is NULL for
+     * uniprediction. The default weighting is denom 0 and weights of 1.
+     */
+    void (*put_hevc_lowres_w)(uint8_t *_dst, ptrdiff_t _dststride,
+                              const int16_t *src0, const int16_t *src1,
+                              int width, int height, int denom,
+                              int wx0, int wx1, int ox0, int ox1);
+
+    /**
+     * Motion part of the boundary strength of n edge segments: bs[i * stride]
+     * is 0 if p[i] and q[i] use the same reference pictures, in either order,
+     * with the matching vectors less than 4 quarter samples apart, and 1
+     * otherwise. p and q are 16-byte aligned and padded to a multiple of 4
+     * entries.
+     */
+    void (*deblocking_bs)(uint8_t *bs, ptrdiff_t stride, const DeblockMotion *p,
+                          const DeblockMotion *q, int n);
+
     void (*hevc_h_loop_filter_luma)(uint8_t *pix, ptrdiff_t stride,
                                     int beta, int32_t *tc,
                                     uint8_t *no_p, uint8_t *no_q);
@@ -128,6 +174,7 @@ extern const int8_t ff_hevc_epel_filters[7][4];
 extern const int8_t ff_hevc_qpel_filters[3][16];
 
 void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth);
+void ff_hevcdsp_init_aarch64(HEVCDSPContext *c, const int bit_depth);
 void ff_hevcdsp_init_arm(HEVCDSPContext *c, const int bit_depth);
 void ff_hevc_dsp_init_mips(HEVCDSPContext *c, const int bit_depth);
 #endif /* AVCODEC_HEVCDSP_H */
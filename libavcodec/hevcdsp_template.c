@@ -83,6 +83,24 @@ static void FUNC(transform_add32x32)(uint8_t *_dst, int16_t *coeffs,
     FUNC(transquant_bypass)(_dst, coeffs, stride, 32);
 }
 
+static void FUNC(transform_add_lowres)(uint8_t *_dst, int16_t *coeffs,
+                                       ptrdiff_t stride, int log2_size, int lowres)
+{
+    int x, y;
+    pixel *dst = (pixel *)_dst;
+    int size   = 1 << log2_size;
+    int n      = 1 << lowres;
+
+    stride /= sizeof(pixel);
+    coeffs += (n - 1) * size + n - 1;
+
+    for (y = 0; y < size; y += n) {
+        for (x = 0; x < size; x += n)
+            dst[x >> lowres] = av_clip_pixel(dst[x >> lowres] + coeffs[x]);
+        coeffs += n * size;
+        dst    += stride;
+    }
+}
 
 static void FUNC(transform_rdpcm)(int16_t *_coeffs, int16_t log2_size, int mode)
 {
@@ -607,6 +625,69 @@ static void FUNC(put_hevc_pel_bi_w_pixels)(uint8_t *_dst, ptrdiff_t _dststride,
     }
 }
 
+static void FUNC(put_hevc_lowres)(int16_t *dst, const uint8_t *_src, ptrdiff_t _srcstride,
+                                  int src_width, int src_height, int mx, int my,
+                                  int log2_scale_x, int log2_scale_y, int width, int height)
+{
+    int x, y;
+    const pixel *src    = (const pixel *)_src;
+    ptrdiff_t srcstride = _srcstride / sizeof(pixel);
+    int fx              = mx & ((1 << log2_scale_x) - 1);
+    int fy              = my & ((1 << log2_scale_y) - 1);
+    int shift           = log2_scale_x + log2_scale_y;
+    int offset          = 1 << (shift - 1);
+    int x_idx[MAX_PB_SIZE + 1];
+
+    mx >>= log2_scale_x;
+    my >>= log2_scale_y;
+    for (x = 0; x <= width; x++)
+        x_idx[x] = av_clip(mx + x, 0, src_width - 1);
+
+    for (y = 0; y < height; y++) {
+        const pixel *src0 = src + av_clip(my + y,     0, src_height - 1) * srcstride;
+        const pixel *src1 = src + av_clip(my + y + 1, 0, src_height - 1) * srcstride;
+        for (x = 0; x < width; x++) {
+            int a = src0[x_idx[x]] * ((1 << log2_scale_x) - fx) + src0[x_idx[x + 1]] * fx;
+            int b = src1[x_idx[x]] * ((1 << log2_scale_x) - fx) + src1[x_idx[x + 1]] * fx;
+            dst[x] = ((a * ((1 << log2_scale_y) - fy) + b * fy) * (1 << (14 - BIT_DEPTH)) +
+                      offset) >> shift;
+        }
+        dst += MAX_PB_SIZE;
+    }
+}
+
+static void FUNC(put_hevc_lowres_w)(uint8_t *_dst, ptrdiff_t _dststride,
+                                    const int16_t *src0, const int16_t *src1,
+                                    int width, int height, int denom,
+                                    int wx0, int wx1, int ox0, int ox1)
+{
+    int x, y;
+    pixel *dst          = (pixel *)_dst;
+    ptrdiff_t dststride = _dststride / sizeof(pixel);
+    int log2Wd          = denom + 14 - BIT_DEPTH;
+
+    ox0 = ox0 * (1 << (BIT_DEPTH - 8));
+    ox1 = ox1 * (1 << (BIT_DEPTH - 8));
+    if (!src1) {
+        int offset = 1 << (log2Wd - 1);
+        for (y = 0; y < height; y++) {
+            for (x = 0; x < width; x++)
+                dst[x] = av_clip_pixel(((src0[x] * wx0 + offset) >> log2Wd) + ox0);
+            src0 += MAX_PB_SIZE;
+            dst  += dststride;
+        }
+    } else {
+        for (y = 0; y < height; y++) {
+            for (x = 0; x < width; x++)
+                dst[x] = av_clip_pixel((src0[x] * wx0 + src1[x] * wx1 +
+                                        ((ox0 + ox1 + 1) << log2Wd)) >> (log2Wd + 1));
+            src0 += MAX_PB_SIZE;
+            src1 += MAX_PB_SIZE;
+            dst  += dststride;
+        }
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 ////////////////////////////////////////////////////////////////////////////////
@@ -20,6 +20,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
 #include "hevc.h"
 
 #include "hevcpred.h"
@@ -58,7 +59,8 @@ void ff_hevc_pred_init(HEVCPredContext *hpc, int bit_depth)
     hpc->pred_angular[0] = FUNC(pred_angular_0, depth); \
     hpc->pred_angular[1] = FUNC(pred_angular_1, depth); \
     hpc->pred_angular[2] = FUNC(pred_angular_2, depth); \
-    hpc->pred_angular[3] = FUNC(pred_angular_3, depth);
+    hpc->pred_angular[3] = FUNC(pred_angular_3, depth); \
+    hpc->ref_filter      = FUNC(ref_filter, depth);
 
     switch (bit_depth) {
     case 9:
@@ -74,4 +76,33 @@ void ff_hevc_pred_init(HEVCPredContext *hpc, int bit_depth)
         HEVC_PRED(8);
         break;
     }
+
+    if (ARCH_AARCH64)
+        ff_hevc_pred_init_aarch64(hpc, bit_depth);
+    if (ARCH_ARM)
+        ff_hevc_pred_init_arm(hpc, bit_depth);
+}
+
+void ff_hevc_pred_init_lowres(HEVCPredContext *hpc, int bit_depth)
+{
+#define HEVC_PRED_LOWRES(depth)                                     \
+    hpc->intra_pred[0]   = FUNC(intra_pred_lowres_2, depth);        \
+    hpc->intra_pred[1]   = FUNC(intra_pred_lowres_3, depth);        \
+    hpc->intra_pred[2]   = FUNC(intra_pred_lowres_4, depth);        \
+    hpc->intra_pred[3]   = FUNC(intra_pred_lowres_5, depth);
+
+    switch (bit_depth) {
+    case 9:
+        HEVC_PRED_LOWRES(9);
+        break;
+    case 10:
+        HEVC_PRED_LOWRES(10);
+        break;
+    case 12:
+        HEVC_PRED_LOWRES(12);
+        break;
+    default:
+        HEVC_PRED_LOWRES(8);
+        break;
+    }
 }
@@ -38,8 +38,22 @@ typedef struct HEVCPredContext {
     void (*pred_angular[4])(uint8_t *src, const uint8_t *top,
                             const uint8_t *left, ptrdiff_t stride,
                             int c_idx, int mode);
+    /**
+     * [1 2 1] smoothing of the 2 * size + 1 reference samples on each side.
+     * left[-1] == top[-1] is the corner sample; the last sample of each side
+     * is copied unfiltered.
+     */
+    void (*ref_filter)(uint8_t *filtered_left, uint8_t *filtered_top,
+                       const uint8_t *left, const uint8_t *top, int size);
 } HEVCPredContext;
 
 void ff_hevc_pred_init(HEVCPredContext *hpc, int bit_depth);
+/**
+ * Replace the intra_pred functions by the approximate ones used for lowres
+ * decoding, which write the downscaled picture.
+ */
+void ff_hevc_pred_init_lowres(HEVCPredContext *hpc, int bit_depth);
+void ff_hevc_pred_init_aarch64(HEVCPredContext *hpc, int bit_depth);
+void ff_hevc_pred_init_arm(HEVCPredContext *hpc, int bit_depth);
 
 #endif /* AVCODEC_HEVCPRED_H */
@@ -310,16 +310,9 @@ do {                                  \
                                    (i + 1)  * left[63] + 32) >> 6;
                     top = filtered_top;
                 } else {
-                    filtered_left[2 * size - 1] = left[2 * size - 1];
-                    filtered_top[2 * size - 1]  = top[2 * size - 1];
-                    for (i = 2 * size - 2; i >= 0; i--)
-                        filtered_left[i] = (left[i + 1] + 2 * left[i] +
-                                            left[i - 1] + 2) >> 2;
-                    filtered_top[-1]  =
-                    filtered_left[-1] = (left[0] + 2 * left[-1] + top[0] + 2) >> 2;
-                    for (i = 2 * size - 2; i >= 0; i--)
-                        filtered_top[i] = (top[i + 1] + 2 * top[i] +
-                                           top[i - 1] + 2) >> 2;
+                    s->hpc.ref_filter((uint8_t *)filtered_left,
+                                      (uint8_t *)filtered_top,
+                                      (uint8_t *)left, (uint8_t *)top, size);
                     left = filtered_left;
                     top  = filtered_top;
                 }
@@ -357,6 +350,28 @@ INTRA_PRED(5)
 
 #undef INTRA_PRED
 
+static void FUNC(ref_filter)(uint8_t *_filtered_left, uint8_t *_filtered_top,
+                             const uint8_t *_left, const uint8_t *_top,
+                             int size)
+{
+    int i;
+    pixel *filtered_left = (pixel *)_filtered_left;
+    pixel *filtered_top  = (pixel *)_filtered_top;
+    const pixel *left    = (const pixel *)_left;
+    const pixel *top     = (const pixel *)_top;
+
+    filtered_left[2 * size - 1] = left[2 * size - 1];
+    filtered_top[2 * size - 1]  = top[2 * size - 1];
+    for (i = 2 * size - 2; i >= 0; i--)
+        filtered_left[i] = (left[i + 1] + 2 * left[i] +
+                            left[i - 1] + 2) >> 2;
+    filtered_top[-1]  =
+    filtered_left[-1] = (left[0] + 2 * left[-1] + top[0] + 2) >> 2;
+    for (i = 2 * size - 2; i >= 0; i--)
+        filtered_top[i] = (top[i + 1] + 2 * top[i] +
+                           top[i - 1] + 2) >> 2;
+}
+
 static av_always_inline void FUNC(pred_planar)(uint8_t *_src, const uint8_t *_top,
                                   const uint8_t *_left, ptrdiff_t stride,
                                   int trafo_size)
@@ -538,6 +553,201 @@ static void FUNC(pred_angular_3)(uint8_t *src, const uint8_t *top,
     FUNC(pred_angular)(src, top, left, stride, c_idx, mode, 1 << 5);
 }
 
+/**
+ * Approximate intra prediction for lowres decoding. The neighbour
+ * availability is derived exactly as in intra_pred(), but the reference
+ * samples are read from the downscaled picture and the block is predicted
+ * at its reduced size. Each downscaled sample stands for the last sample
+ * of its cell, so the first row and column the DC and pure horizontal or
+ * vertical boundary filters touch are never shown and those filters are
+ * skipped. Constrained intra prediction and strong intra smoothing are not
+ * applied. Blocks which shrink below 4x4 are predicted at 4x4 from
+ * stretched references and subsampled.
+ */
+static void FUNC(intra_pred_lowres)(HEVCContext *s, int x0, int y0,
+                                    int log2_size, int c_idx)
+{
+#define EXTEND_LOWRES(ptr, val, len)  \
+do {                                  \
+    pixel v = (val);                  \
+    for (i = 0; i < (len); i++)       \
+        (ptr)[i] = v;                 \
+} while (0)
+
+    HEVCLocalContext *lc = s->HEVClc;
+    int i, j;
+    int lowres = s->lowres;
+    int hshift = s->sps->hshift[c_idx];
+    int vshift = s->sps->vshift[c_idx];
+    int size_in_luma_h = (1 << log2_size) << hshift;
+    int size_in_tbs_h  = size_in_luma_h >> s->sps->log2_min_tb_size;
+    int size_in_luma_v = (1 << log2_size) << vshift;
+    int size_in_tbs_v  = size_in_luma_v >> s->sps->log2_min_tb_size;
+    int x_tb = (x0 >> s->sps->log2_min_tb_size) & s->sps->tb_mask;
+    int y_tb = (y0 >> s->sps->log2_min_tb_size) & s->sps->tb_mask;
+
+    int cur_tb_addr = MIN_TB_ADDR_ZS(x_tb, y_tb);
+
+    int log2_lsize = log2_size - lowres;
+    int size       = 1 << log2_lsize;
+    ptrdiff_t stride = s->frame->linesize[c_idx] / sizeof(pixel);
+    pixel *src = (pixel*)s->frame->data[c_idx] + ((x0 >> hshift) >> lowres) +
+                 ((y0 >> vshift) >> lowres) * stride;
+
+    enum IntraPredMode mode = c_idx ? lc->tu.intra_pred_mode_c :
+                              lc->tu.intra_pred_mode;
+    pixel  left_array[2 * MAX_TB_SIZE + 1];
+    pixel  filtered_left_array[2 * MAX_TB_SIZE + 1];
+    pixel  top_array[2 * MAX_TB_SIZE + 1];
+    pixel  filtered_top_array[2 * MAX_TB_SIZE + 1];
+    DECLARE_ALIGNED(16, pixel, block)[4 * 4];
+
+    pixel  *left          = left_array + 1;
+    pixel  *top           = top_array  + 1;
+    pixel  *filtered_left = filtered_left_array + 1;
+    pixel  *filtered_top  = filtered_top_array  + 1;
+    int cand_bottom_left = lc->na.cand_bottom_left && cur_tb_addr > MIN_TB_ADDR_ZS( x_tb - 1, (y_tb + size_in_tbs_v) & s->sps->tb_mask);
+    int cand_left        = lc->na.cand_left;
+    int cand_up_left     = lc->na.cand_up_left;
+    int cand_up          = lc->na.cand_up;
+    int cand_up_right    = lc->na.cand_up_right    && cur_tb_addr > MIN_TB_ADDR_ZS((x_tb + size_in_tbs_h) & s->sps->tb_mask, y_tb - 1);
+
+    int bottom_left_size = ((FFMIN(y0 + 2 * size_in_luma_v, s->sps->height) -
+                            (y0 + size_in_luma_v)) >> vshift) >> lowres;
+    int top_right_size   = ((FFMIN(x0 + 2 * size_in_luma_h, s->sps->width) -
+                            (x0 + size_in_luma_h)) >> hshift) >> lowres;
+
+    if (cand_up_left) {
+        left[-1] = POS(-1, -1);
+        top[-1]  = left[-1];
+    }
+    if (cand_up)
+        memcpy(top, src - stride, size * sizeof(pixel));
+    if (cand_up_right) {
+        memcpy(top + size, src - stride + size, top_right_size * sizeof(pixel));
+        EXTEND_LOWRES(top + size + top_right_size, POS(size + top_right_size - 1, -1),
+                      size - top_right_size);
+    }
+    if (cand_left)
+        for (i = 0; i < size; i++)
+            left[i] = POS(-1, i);
+    if (cand_bottom_left) {
+        for (i = size; i < size + bottom_left_size; i++)
+            left[i] = POS(-1, i);
+        EXTEND_LOWRES(left + size + bottom_left_size, POS(-1, size + bottom_left_size - 1),
+                      size - bottom_left_size);
+    }
+
+    // Infer the unavailable samples
+    if (!cand_bottom_left) {
+        if (cand_left) {
+            EXTEND_LOWRES(left + size, left[size - 1], size);
+        } else if (cand_up_left) {
+            EXTEND_LOWRES(left, left[-1], 2 * size);
+            cand_left = 1;
+        } else if (cand_up) {
+            left[-1] = top[0];
+            EXTEND_LOWRES(left, left[-1], 2 * size);
+            cand_up_left = 1;
+            cand_left    = 1;
+        } else if (cand_up_right) {
+            EXTEND_LOWRES(top, top[size], size);
+            left[-1] = top[size];
+            EXTEND_LOWRES(left, left[-1], 2 * size);
+            cand_up      = 1;
+            cand_up_left = 1;
+            cand_left    = 1;
+        } else { // No samples available
+            left[-1] = (1 << (BIT_DEPTH - 1));
+            EXTEND_LOWRES(top,  left[-1], 2 * size);
+            EXTEND_LOWRES(left, left[-1], 2 * size);
+        }
+    }
+
+    if (!cand_left)
+        EXTEND_LOWRES(left, left[size], size);
+    if (!cand_up_left)
+        left[-1] = left[0];
+    if (!cand_up)
+        EXTEND_LOWRES(top, left[-1], size);
+    if (!cand_up_right)
+        EXTEND_LOWRES(top + size, top[size - 1], size);
+
+    top[-1] = left[-1];
+
+    // Filtering process, decided on the coded block size
+    if (!s->sps->intra_smoothing_disabled_flag && (c_idx == 0  || s->sps->chroma_format_idc == 3) &&
+        mode != INTRA_DC && log2_size != 2 && size >= 4) {
+        static const int intra_hor_ver_dist_thresh[] = { 7, 1, 0 };
+        int min_dist_vert_hor = FFMIN(FFABS((int)(mode - 26U)),
+                                      FFABS((int)(mode - 10U)));
+        if (min_dist_vert_hor > intra_hor_ver_dist_thresh[log2_size - 3]) {
+            FUNC(ref_filter)((uint8_t *)filtered_left, (uint8_t *)filtered_top,
+                             (uint8_t *)left, (uint8_t *)top, size);
+            left = filtered_left;
+            top  = filtered_top;
+        }
+    }
+
+    if (size < 4) {
+        // stretch the references in place, from the far end
+        int shift = 2 - log2_lsize;
+        for (i = 2 * 4 - 1; i >= 0; i--) {
+            top[i]  = top[i >> shift];
+            left[i] = left[i >> shift];
+        }
+        switch (mode) {
+        case INTRA_PLANAR:
+            s->hpc.pred_planar[0]((uint8_t *)block, (uint8_t *)top,
+                                  (uint8_t *)left, 4);
+            break;
+        case INTRA_DC:
+            s->hpc.pred_dc((uint8_t *)block, (uint8_t *)top,
+                           (uint8_t *)left, 4, 2, 1);
+            break;
+        default:
+            s->hpc.pred_angular[0]((uint8_t *)block, (uint8_t *)top,
+                                   (uint8_t *)left, 4, 1, mode);
+            break;
+        }
+        for (j = 0; j < size; j++)
+            for (i = 0; i < size; i++)
+                POS(i, j) = block[(((j + 1) << shift) - 1) * 4 +
+                                  ((i + 1) << shift) - 1];
+        return;
+    }
+
+    switch (mode) {
+    case INTRA_PLANAR:
+        s->hpc.pred_planar[log2_lsize - 2]((uint8_t *)src, (uint8_t *)top,
+                                           (uint8_t *)left, stride);
+        break;
+    case INTRA_DC:
+        s->hpc.pred_dc((uint8_t *)src, (uint8_t *)top,
+                       (uint8_t *)left, stride, log2_lsize, 1);
+        break;
+    default:
+        s->hpc.pred_angular[log2_lsize - 2]((uint8_t *)src, (uint8_t *)top,
+                                            (uint8_t *)left, stride, 1, mode);
+        break;
+    }
+#undef EXTEND_LOWRES
+}
+
+#define INTRA_PRED_LOWRES(size)                                                     \
+static void FUNC(intra_pred_lowres_ ## size)(HEVCContext *s, int x0, int y0,        \
+                                             int c_idx)                             \
+{                                                                                   \
+    FUNC(intra_pred_lowres)(s, x0, y0, size, c_idx);                                \
+}
+
+INTRA_PRED_LOWRES(2)
+INTRA_PRED_LOWRES(3)
+INTRA_PRED_LOWRES(4)
+INTRA_PRED_LOWRES(5)
+
+#undef INTRA_PRED_LOWRES
+
 #undef EXTEND_LEFT_CIP
 #undef EXTEND_RIGHT_CIP
 #undef EXTEND_UP_CIP
@@ -136,6 +136,12 @@ typedef struct AVCodecInternal {
 
     void *thread_ctx;
 
+    /**
+     * Slice threads started by a decoder inside one of its frame threads,
+     * see ff_slice_thread_init_nested().
+     */
+    void *slice_thread_ctx;
+
     /**
      * Current packet as passed into the decoder, to avoid having to pass the
      * packet into every function.
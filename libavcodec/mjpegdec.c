@@ -43,6 +43,7 @@
 #include "mjpegdec.h"
 #include "jpeglsdec.h"
 #include "put_bits.h"
+#include "thread.h"
 #include "tiff.h"
 #include "exif.h"
 #include "bytestream.h"
@@ -260,6 +261,7 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     unsigned pix_fmt_id;
     int h_count[MAX_COMPONENTS] = { 0 };
     int v_count[MAX_COMPONENTS] = { 0 };
+    ThreadFrame tf = { NULL };
 
     s->cur_scan = 0;
     memset(s->upscale_h, 0, sizeof(s->upscale_h));
@@ -599,8 +601,9 @@ unk_pixfmt:
         return AVERROR_BUG;
     }
 
-    av_frame_unref(s->picture_ptr);
-    if (ff_get_buffer(s->avctx, s->picture_ptr, AV_GET_BUFFER_FLAG_REF) < 0)
+    tf.f = s->picture_ptr;
+    ff_thread_release_buffer(s->avctx, &tf);
+    if (ff_thread_get_buffer(s->avctx, &tf, AV_GET_BUFFER_FLAG_REF) < 0)
         return -1;
     s->picture_ptr->pict_type = AV_PICTURE_TYPE_I;
     s->picture_ptr->key_frame = 1;
@@ -1212,17 +1215,198 @@ static void shift_output(MJpegDecodeContext *s, uint8_t *ptr, int linesize)
     }
 }
 
+static int mjpeg_decode_mcu(MJpegDecodeContext *s, int nb_components, int Ah,
+                            int Al, int mb_x, int mb_y, int copy_mb,
+                            uint8_t **data, const uint8_t **reference_data,
+                            const int *linesize)
+{
+    int i;
+    int bytes_per_pixel = 1 + (s->bits > 8);
+
+    for (i = 0; i < nb_components; i++) {
+        uint8_t *ptr;
+        int n, h, v, x, y, c, j;
+        int block_offset;
+        n = s->nb_blocks[i];
+        c = s->comp_index[i];
+        h = s->h_scount[i];
+        v = s->v_scount[i];
+        x = 0;
+        y = 0;
+        for (j = 0; j < n; j++) {
+            block_offset = (((linesize[c] * (v * mb_y + y) * 8) +
+                             (h * mb_x + x) * 8 * bytes_per_pixel) >> s->avctx->lowres);
+
+            if (s->interlaced && s->bottom_field)
+                block_offset += linesize[c] >> 1;
+            if (   8*(h * mb_x + x) < s->width
+                && 8*(v * mb_y + y) < s->height) {
+                ptr = data[c] + block_offset;
+            } else
+                ptr = NULL;
+            if (!s->progressive) {
+                if (copy_mb) {
+                    if (ptr)
+                        mjpeg_copy_block(s, ptr, reference_data[c] + block_offset,
+                                        linesize[c], s->avctx->lowres);
+
+                } else {
+                    s->bdsp.clear_block(s->block);
+                    if (decode_block(s, s->block, i,
+                                     s->dc_index[i], s->ac_index[i],
+                                     s->quant_matrixes[s->quant_sindex[i]]) < 0) {
+                        av_log(s->avctx, AV_LOG_ERROR,
+                               "error y=%d x=%d\n", mb_y, mb_x);
+                        return AVERROR_INVALIDDATA;
+                    }
+                    if (ptr) {
+                        s->idsp.idct_put(ptr, linesize[c], s->block);
+                        if (s->bits & 7)
+                            shift_output(s, ptr, linesize[c]);
+                    }
+                }
+            } else {
+                int block_idx  = s->block_stride[c] * (v * mb_y + y) +
+                                 (h * mb_x + x);
+                int16_t *block = s->blocks[c][block_idx];
+                if (Ah)
+                    block[0] += get_bits1(&s->gb) *
+                                s->quant_matrixes[s->quant_sindex[i]][0] << Al;
+                else if (decode_dc_progressive(s, block, i, s->dc_index[i],
+                                               s->quant_matrixes[s->quant_sindex[i]],
+                                               Al) < 0) {
+                    av_log(s->avctx, AV_LOG_ERROR,
+                           "error y=%d x=%d\n", mb_y, mb_x);
+                    return AVERROR_INVALIDDATA;
+                }
+            }
+            ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
+            ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
+                    mb_x, mb_y, x, y, c, s->bottom_field,
+                    (v * mb_y + y) * 8, (h * mb_x + x) * 8);
+            if (++x == h) {
+                x = 0;
+                y++;
+            }
+        }
+    }
+    return 0;
+}
+
+typedef struct MJpegScanSliceArgs {
+    MJpegDecodeContext *s;
+    int nb_components;
+    int first_restart;  ///< index in restart_pos of the first marker of the scan
+    int nb_intervals;
+    int nb_jobs;
+} MJpegScanSliceArgs;
+
+static int mjpeg_decode_scan_slice(AVCodecContext *avctx, void *arg,
+                                   int jobnr, int threadnr)
+{
+    MJpegScanSliceArgs *args = arg;
+    MJpegDecodeContext *s1   = args->s;
+    MJpegDecodeContext *s    = s1->slice_ctx[jobnr];
+    int start    = args->nb_intervals *  jobnr      / args->nb_jobs;
+    int end      = args->nb_intervals * (jobnr + 1) / args->nb_jobs;
+    int mb_count = s1->mb_width * s1->mb_height;
+    uint8_t *data[MAX_COMPONENTS];
+    int linesize[MAX_COMPONENTS];
+    int i, k, mb, mb_end, ret;
+
+    memcpy(s, s1, sizeof(*s));
+    for (i = 0; i < args->nb_components; i++) {
+        int c = s->comp_index[i];
+        data[c]     = s->picture_ptr->data[c];
+        linesize[c] = s->linesize[c];
+    }
+
+    for (k = start; k < end; k++) {
+        if (k)
+            skip_bits_long(&s->gb, s->restart_pos[args->first_restart + k - 1] * 8 -
+                                   get_bits_count(&s->gb));
+        for (i = 0; i < args->nb_components; i++)
+            s->last_dc[i] = (4 << s->bits);
+
+        mb_end = FFMIN((k + 1) * s->restart_interval, mb_count);
+        for (mb = k * s->restart_interval; mb < mb_end; mb++) {
+            if (get_bits_left(&s->gb) < 0) {
+                av_log(s->avctx, AV_LOG_ERROR, "overread %d\n",
+                       -get_bits_left(&s->gb));
+                return AVERROR_INVALIDDATA;
+            }
+            if ((ret = mjpeg_decode_mcu(s, args->nb_components, 0, 0,
+                                        mb % s->mb_width, mb / s->mb_width, 0,
+                                        data, NULL, linesize)) < 0)
+                return ret;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Decode the restart intervals of a sequential scan in parallel, each slice
+ * thread takes a contiguous run of them and starts after their RSTn markers.
+ * @return 1 if the scan cannot be split and has to be decoded serially
+ */
+static int mjpeg_decode_scan_mt(MJpegDecodeContext *s, int nb_components)
+{
+    AVCodecContext *avctx = s->avctx;
+    MJpegScanSliceArgs args = { s, nb_components };
+    int pos = get_bits_count(&s->gb) >> 3;
+    int *ret;
+    int i, res = 0;
+
+    args.nb_intervals = (s->mb_width * s->mb_height + s->restart_interval - 1) /
+                        s->restart_interval;
+    for (i = 0; i < s->nb_restart_pos && s->restart_pos[i] <= pos; i++)
+        ;
+    args.first_restart = i;
+    // a missing or corrupt marker would shift all following intervals
+    if (args.nb_intervals < 2 ||
+        s->nb_restart_pos - args.first_restart < args.nb_intervals - 1)
+        return 1;
+    args.nb_jobs = FFMIN(args.nb_intervals, avctx->thread_count);
+
+    if (!s->slice_ctx) {
+        s->slice_ctx = av_mallocz_array(avctx->thread_count, sizeof(*s->slice_ctx));
+        if (!s->slice_ctx)
+            return AVERROR(ENOMEM);
+    }
+    for (i = 0; i < args.nb_jobs; i++) {
+        if (!s->slice_ctx[i]) {
+            s->slice_ctx[i] = av_malloc(sizeof(MJpegDecodeContext));
+            if (!s->slice_ctx[i])
+                return AVERROR(ENOMEM);
+        }
+    }
+    ret = av_malloc_array(args.nb_jobs, sizeof(*ret));
+    if (!ret)
+        return AVERROR(ENOMEM);
+
+    avctx->execute2(avctx, mjpeg_decode_scan_slice, &args, ret, args.nb_jobs);
+
+    for (i = 0; i < args.nb_jobs; i++)
+        if (ret[i] < 0)
+            res = ret[i];
+    av_free(ret);
+
+    // continue after the last interval like the serial decoder would
+    s->gb = s->slice_ctx[args.nb_jobs - 1]->gb;
+
+    return res;
+}
+
 static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                              int Al, const uint8_t *mb_bitmask,
                              int mb_bitmask_size,
                              const AVFrame *reference)
 {
-    int i, mb_x, mb_y;
+    int i, mb_x, mb_y, ret;
     uint8_t *data[MAX_COMPONENTS];
     const uint8_t *reference_data[MAX_COMPONENTS];
     int linesize[MAX_COMPONENTS];
     GetBitContext mb_bitmask_gb = {0}; // initialize to silence gcc warning
-    int bytes_per_pixel = 1 + (s->bits > 8);
 
     if (mb_bitmask) {
         if (mb_bitmask_size != (s->mb_width * s->mb_height + 7)>>3) {
@@ -1242,6 +1426,13 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
         s->coefs_finished[c] |= 1;
     }
 
+    if (!mb_bitmask && !s->progressive && s->restart_interval &&
+        (s->avctx->active_thread_type & FF_THREAD_SLICE)) {
+        ret = mjpeg_decode_scan_mt(s, nb_components);
+        if (ret <= 0)
+            return ret;
+    }
+
     for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
         for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
             const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
@@ -1254,73 +1445,10 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                        -get_bits_left(&s->gb));
                 return AVERROR_INVALIDDATA;
             }
-            for (i = 0; i < nb_components; i++) {
-                uint8_t *ptr;
-                int n, h, v, x, y, c, j;
-                int block_offset;
-                n = s->nb_blocks[i];
-                c = s->comp_index[i];
-                h = s->h_scount[i];
-                v = s->v_scount[i];
-                x = 0;
-                y = 0;
-                for (j = 0; j < n; j++) {
-                    block_offset = (((linesize[c] * (v * mb_y + y) * 8) +
-                                     (h * mb_x + x) * 8 * bytes_per_pixel) >> s->avctx->lowres);
-
-                    if (s->interlaced && s->bottom_field)
-                        block_offset += linesize[c] >> 1;
-                    if (   8*(h * mb_x + x) < s->width
-                        && 8*(v * mb_y + y) < s->height) {
-                        ptr = data[c] + block_offset;
-                    } else
-                        ptr = NULL;
-                    if (!s->progressive) {
-                        if (copy_mb) {
-                            if (ptr)
-                                mjpeg_copy_block(s, ptr, reference_data[c] + block_offset,
-                                                linesize[c], s->avctx->lowres);
-
-                        } else {
-                            s->bdsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
-                                             s->dc_index[i], s->ac_index[i],
-                                             s->quant_matrixes[s->quant_sindex[i]]) < 0) {
-                                av_log(s->avctx, AV_LOG_ERROR,
-                                       "error y=%d x=%d\n", mb_y, mb_x);
-                                return AVERROR_INVALIDDATA;
-                            }
-                            if (ptr) {
-                                s->idsp.idct_put(ptr, linesize[c], s->block);
-                                if (s->bits & 7)
-                                    shift_output(s, ptr, linesize[c]);
-                            }
-                        }
-                    } else {
-                        int block_idx  = s->block_stride[c] * (v * mb_y + y) +
-                                         (h * mb_x + x);
-                        int16_t *block = s->blocks[c][block_idx];
-                        if (Ah)
-                            block[0] += get_bits1(&s->gb) *
-                                        s->quant_matrixes[s->quant_sindex[i]][0] << Al;
-                        else if (decode_dc_progressive(s, block, i, s->dc_index[i],
-                                                       s->quant_matrixes[s->quant_sindex[i]],
-                                                       Al) < 0) {
-                            av_log(s->avctx, AV_LOG_ERROR,
-                                   "error y=%d x=%d\n", mb_y, mb_x);
-                            return AVERROR_INVALIDDATA;
-                        }
-                    }
-                    ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
-                    ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
-                            mb_x, mb_y, x, y, c, s->bottom_field,
-                            (v * mb_y + y) * 8, (h * mb_x + x) * 8);
-                    if (++x == h) {
-                        x = 0;
-                        y++;
-                    }
-                }
-            }
+            if ((ret = mjpeg_decode_mcu(s, nb_components, Ah, Al, mb_x, mb_y,
+                                        copy_mb, data, reference_data,
+                                        linesize)) < 0)
+                return ret;
 
             handle_rstn(s, nb_components);
         }
@@ -1492,6 +1620,15 @@ int ff_mjpeg_decode_sos(MJpegDecodeContext *s, const uint8_t *mb_bitmask,
     for (i = s->mjpb_skiptosod; i > 0; i--)
         skip_bits(&s->gb, 8);
 
+    /* A sequential scan of all components is the only one of the picture,
+     * so the next frame thread can start with the tables as they are now.
+     * Other pictures let the frame be set up once it is fully decoded. */
+    if (!s->progressive && !s->interlaced && nb_components == s->nb_components &&
+        (s->avctx->active_thread_type & FF_THREAD_FRAME)) {
+        s->setup_finished = 1;
+        ff_thread_finish_setup(s->avctx);
+    }
+
 next_field:
     for (i = 0; i < nb_components; i++)
         s->last_dc[i] = (4 << s->bits);
@@ -1565,6 +1702,9 @@ static int mjpeg_decode_dri(MJpegDecodeContext *s)
     return 0;
 }
 
+/* Once setup is finished, the next frame thread has copied the decoder
+ * state, so markers following the last scan only contribute the per-frame
+ * metadata: EXIF, stereo 3D and the Adobe transform. */
 static int mjpeg_decode_app(MJpegDecodeContext *s)
 {
     int len, id, i;
@@ -1595,6 +1735,7 @@ static int mjpeg_decode_app(MJpegDecodeContext *s)
             4bytes      field_size
             4bytes      field_size_less_padding
         */
+        if (!s->setup_finished)
             s->buggy_avid = 1;
         i = get_bits(&s->gb, 8); len--;
         av_log(s->avctx, AV_LOG_DEBUG, "polarity %d\n", i);
@@ -1611,21 +1752,21 @@ static int mjpeg_decode_app(MJpegDecodeContext *s)
 
     if (id == AV_RB32("JFIF")) {
         int t_w, t_h, v1, v2;
+        AVRational sar;
         skip_bits(&s->gb, 8); /* the trailing zero-byte */
         v1 = get_bits(&s->gb, 8);
         v2 = get_bits(&s->gb, 8);
         skip_bits(&s->gb, 8);
 
-        s->avctx->sample_aspect_ratio.num = get_bits(&s->gb, 16);
-        s->avctx->sample_aspect_ratio.den = get_bits(&s->gb, 16);
-        ff_set_sar(s->avctx, s->avctx->sample_aspect_ratio);
+        sar.num = get_bits(&s->gb, 16);
+        sar.den = get_bits(&s->gb, 16);
+        if (!s->setup_finished)
+            ff_set_sar(s->avctx, sar);
 
         if (s->avctx->debug & FF_DEBUG_PICT_INFO)
             av_log(s->avctx, AV_LOG_INFO,
                    "mjpeg: JFIF header found (version: %x.%x) SAR=%d/%d\n",
-                   v1, v2,
-                   s->avctx->sample_aspect_ratio.num,
-                   s->avctx->sample_aspect_ratio.den);
+                   v1, v2, sar.num, sar.den);
 
         t_w = get_bits(&s->gb, 8);
         t_h = get_bits(&s->gb, 8);
@@ -1673,6 +1814,8 @@ static int mjpeg_decode_app(MJpegDecodeContext *s)
         }
 
         len -= 9;
+        if (s->setup_finished)
+            goto out;
         if (s->got_picture)
             if (rgb != s->rgb || pegasus_rct != s->pegasus_rct) {
                 av_log(s->avctx, AV_LOG_WARNING, "Mismatching LJIF tag\n");
@@ -1685,16 +1828,20 @@ static int mjpeg_decode_app(MJpegDecodeContext *s)
         goto out;
     }
     if (id == AV_RL32("colr") && len > 0) {
-        s->colr = get_bits(&s->gb, 8);
+        i = get_bits(&s->gb, 8);
+        if (!s->setup_finished)
+            s->colr = i;
         if (s->avctx->debug & FF_DEBUG_PICT_INFO)
-            av_log(s->avctx, AV_LOG_INFO, "COLR %d\n", s->colr);
+            av_log(s->avctx, AV_LOG_INFO, "COLR %d\n", i);
         len --;
         goto out;
     }
     if (id == AV_RL32("xfrm") && len > 0) {
-        s->xfrm = get_bits(&s->gb, 8);
+        i = get_bits(&s->gb, 8);
+        if (!s->setup_finished)
+            s->xfrm = i;
         if (s->avctx->debug & FF_DEBUG_PICT_INFO)
-            av_log(s->avctx, AV_LOG_INFO, "XFRM %d\n", s->xfrm);
+            av_log(s->avctx, AV_LOG_INFO, "XFRM %d\n", i);
         len --;
         goto out;
     }
@@ -1823,7 +1970,10 @@ static int mjpeg_decode_com(MJpegDecodeContext *s)
                 av_log(s->avctx, AV_LOG_INFO, "comment: '%s'\n", cbuf);
 
             /* buggy avid, it puts EOI only at every 10th frame */
-            if (!strncmp(cbuf, "AVID", 4)) {
+            if (s->setup_finished) {
+                /* the next frame thread has copied the state, see
+                 * mjpeg_decode_app() */
+            } else if (!strncmp(cbuf, "AVID", 4)) {
                 parse_avid(s, cbuf, len);
             } else if (!strcmp(cbuf, "CS=ITU601"))
                 s->cs_itu601 = 1;
@@ -1881,7 +2031,9 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
     if (start_code == SOS && !s->ls) {
         const uint8_t *src = *buf_ptr;
         uint8_t *dst = s->buffer;
+        int record_rst = s->avctx->active_thread_type & FF_THREAD_SLICE;
 
+        s->nb_restart_pos = 0;
         while (src < buf_end) {
             uint8_t x = *(src++);
 
@@ -1891,9 +2043,17 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                     while (src < buf_end && x == 0xff)
                         x = *(src++);
 
-                    if (x >= 0xd0 && x <= 0xd7)
+                    if (x >= 0xd0 && x <= 0xd7) {
                         *(dst++) = x;
-                    else if (x)
+                        if (record_rst) {
+                            int *tmp = av_fast_realloc(s->restart_pos, &s->restart_pos_size,
+                                                       (s->nb_restart_pos + 1) * sizeof(*s->restart_pos));
+                            if (!tmp)
+                                return AVERROR(ENOMEM);
+                            s->restart_pos = tmp;
+                            s->restart_pos[s->nb_restart_pos++] = dst - s->buffer;
+                        }
+                    } else if (x)
                         break;
                 }
             }
@@ -1974,6 +2134,7 @@ int ff_mjpeg_decode_frame(AVCodecContext *avctx, void *data, int *got_frame,
     av_dict_free(&s->exif_metadata);
     av_freep(&s->stereo3d);
     s->adobe_transform = -1;
+    s->setup_finished  = 0;
 
     buf_ptr = buf;
     buf_end = buf + buf_size;
@@ -2005,6 +2166,16 @@ int ff_mjpeg_decode_frame(AVCodecContext *avctx, void *data, int *got_frame,
         if (s->avctx->debug & FF_DEBUG_STARTCODE)
             av_log(avctx, AV_LOG_DEBUG, "startcode: %X\n", start_code);
 
+        /* the next frame thread is already copying the tables, only the
+         * metadata of APPn and COM is still taken */
+        if (s->setup_finished && start_code != SOS && start_code != EOI &&
+            !(start_code >= 0xd0 && start_code <= 0xd7) &&
+            !(start_code >= APP0 && start_code <= APP15) && start_code != COM) {
+            av_log(avctx, AV_LOG_WARNING,
+                   "Ignoring marker %x after the last scan\n", start_code);
+            continue;
+        }
+
         /* process markers */
         if (start_code >= 0xd0 && start_code <= 0xd7)
             av_log(avctx, AV_LOG_DEBUG,
@@ -2361,6 +2532,13 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
         av_freep(&s->last_nnz[i]);
     }
     av_dict_free(&s->exif_metadata);
+    av_freep(&s->restart_pos);
+    s->restart_pos_size = 0;
+    if (s->slice_ctx) {
+        for (i = 0; i < avctx->thread_count; i++)
+            av_freep(&s->slice_ctx[i]);
+        av_freep(&s->slice_ctx);
+    }
     return 0;
 }
 
@@ -2371,6 +2549,114 @@ static void decode_flush(AVCodecContext *avctx)
 }
 
 #if CONFIG_MJPEG_DECODER
+static av_cold int mjpeg_decode_init_thread_copy(AVCodecContext *avctx)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    int i;
+
+    /* everything allocated belongs to the context this one was copied from */
+    s->picture     = NULL;
+    s->picture_ptr = NULL;
+    s->buffer      = NULL;
+    s->buffer_size = 0;
+    s->ljpeg_buffer      = NULL;
+    s->ljpeg_buffer_size = 0;
+    memset(s->vlcs, 0, sizeof(s->vlcs));
+    for (i = 0; i < MAX_COMPONENTS; i++) {
+        s->blocks[i]   = NULL;
+        s->last_nnz[i] = NULL;
+    }
+    s->exif_metadata    = NULL;
+    s->stereo3d         = NULL;
+    s->restart_pos      = NULL;
+    s->restart_pos_size = 0;
+    s->slice_ctx        = NULL;
+
+    return ff_mjpeg_decode_init(avctx);
+}
+
+static int copy_vlc(VLC *dst, const VLC *src)
+{
+    ff_free_vlc(dst);
+    if (!src->table)
+        return 0;
+
+    dst->table = av_malloc_array(src->table_allocated, sizeof(*dst->table));
+    if (!dst->table)
+        return AVERROR(ENOMEM);
+    memcpy(dst->table, src->table, src->table_size * sizeof(*dst->table));
+    dst->bits            = src->bits;
+    dst->table_size      = src->table_size;
+    dst->table_allocated = src->table_allocated;
+    return 0;
+}
+
+static int mjpeg_decode_update_thread_context(AVCodecContext *dst,
+                                              const AVCodecContext *src)
+{
+    MJpegDecodeContext *s = dst->priv_data, *s1 = src->priv_data;
+    ThreadFrame tf = { s->picture_ptr };
+    int i, j, ret;
+
+    if (s == s1)
+        return 0;
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 4; j++)
+            if ((ret = copy_vlc(&s->vlcs[i][j], &s1->vlcs[i][j])) < 0)
+                return ret;
+    memcpy(s->quant_matrixes, s1->quant_matrixes, sizeof(s->quant_matrixes));
+    memcpy(s->qscale,         s1->qscale,         sizeof(s->qscale));
+
+    s->first_picture      = s1->first_picture;
+    s->interlaced         = s1->interlaced;
+    s->bottom_field       = s1->bottom_field;
+    s->interlace_polarity = s1->interlace_polarity;
+    s->lossless           = s1->lossless;
+    s->ls                 = s1->ls;
+    s->progressive        = s1->progressive;
+    s->rgb                = s1->rgb;
+    s->rct                = s1->rct;
+    s->pegasus_rct        = s1->pegasus_rct;
+    s->bits               = s1->bits;
+    s->colr               = s1->colr;
+    s->xfrm               = s1->xfrm;
+    s->buggy_avid         = s1->buggy_avid;
+    s->cs_itu601          = s1->cs_itu601;
+    s->flipped            = s1->flipped;
+    s->width              = s1->width;
+    s->height             = s1->height;
+    s->nb_components      = s1->nb_components;
+    s->pix_desc           = s1->pix_desc;
+    memcpy(s->component_id, s1->component_id, sizeof(s->component_id));
+    memcpy(s->h_count,      s1->h_count,      sizeof(s->h_count));
+    memcpy(s->v_count,      s1->v_count,      sizeof(s->v_count));
+    memcpy(s->quant_index,  s1->quant_index,  sizeof(s->quant_index));
+    memcpy(s->upscale_h,    s1->upscale_h,    sizeof(s->upscale_h));
+    memcpy(s->upscale_v,    s1->upscale_v,    sizeof(s->upscale_v));
+    memcpy(s->linesize,     s1->linesize,     sizeof(s->linesize));
+
+    s->maxval        = s1->maxval;
+    s->near          = s1->near;
+    s->t1            = s1->t1;
+    s->t2            = s1->t2;
+    s->t3            = s1->t3;
+    s->reset         = s1->reset;
+    s->palette_index = s1->palette_index;
+
+    /* Interlaced pictures only finish setup once a packet is decoded, a
+     * pending first field is completed by the next packet. */
+    ff_thread_release_buffer(dst, &tf);
+    s->got_picture = 0;
+    if (s1->interlaced && s1->got_picture) {
+        if ((ret = av_frame_ref(s->picture_ptr, s1->picture_ptr)) < 0)
+            return ret;
+        s->got_picture = 1;
+    }
+
+    return 0;
+}
+
 #define OFFSET(x) offsetof(MJpegDecodeContext, x)
 #define VD AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_DECODING_PARAM
 static const AVOption options[] = {
@@ -2396,7 +2682,10 @@ AVCodec ff_mjpeg_decoder = {
     .close          = ff_mjpeg_decode_end,
     .decode         = ff_mjpeg_decode_frame,
     .flush          = decode_flush,
-    .capabilities   = CODEC_CAP_DR1,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(mjpeg_decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(mjpeg_decode_update_thread_context),
+    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_FRAME_THREADS |
+                      CODEC_CAP_SLICE_THREADS,
     .max_lowres     = 3,
     .priv_class     = &mjpegdec_class,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE,
@@ -110,6 +110,11 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    int *restart_pos;           ///< offsets of the data following each RSTn marker in buffer
+    unsigned int restart_pos_size;
+    int nb_restart_pos;
+    struct MJpegDecodeContext **slice_ctx; ///< per-job copies for restart interval slice threading
+    int setup_finished;         ///< frame threading: no more headers may change for this frame
 
     int buggy_avid;
     int cs_itu601;
@@ -614,6 +614,7 @@ int ff_frame_thread_init(AVCodecContext *avctx)
     const AVCodec *codec = avctx->codec;
     AVCodecContext *src = avctx;
     FrameThreadContext *fctx;
+    int64_t slice_threads = 0;
     int i, err = 0;
 
 #if HAVE_W32THREADS
@@ -631,6 +632,20 @@ int ff_frame_thread_init(AVCodecContext *avctx)
             thread_count = avctx->thread_count = 1;
     }
 
+    /* decoders which run slice threads inside each frame thread take their
+     * share of the thread budget through their "slice_threads" option;
+     * at least two frame threads are kept and the product never exceeds
+     * thread_count, so too many slice threads are clamped */
+    if (thread_count > 1 && avctx->thread_type & FF_THREAD_SLICE &&
+        codec->capabilities & CODEC_CAP_SLICE_THREADS && codec->priv_class &&
+        av_opt_get_int(avctx->priv_data, "slice_threads", 0, &slice_threads) >= 0 &&
+        slice_threads > 1) {
+        slice_threads = FFMIN(slice_threads, thread_count / 2);
+        av_opt_set_int(avctx->priv_data, "slice_threads", slice_threads, 0);
+        if (slice_threads > 1)
+            thread_count = avctx->thread_count = thread_count / slice_threads;
+    }
+
     if (thread_count <= 1) {
         avctx->active_thread_type = 0;
         return 0;
@@ -676,6 +691,9 @@ int ff_frame_thread_init(AVCodecContext *avctx)
         }
         *copy->internal = *src->internal;
         copy->internal->thread_ctx = p;
+        copy->internal->slice_thread_ctx = NULL;
+        copy->execute  = avctx->execute;
+        copy->execute2 = avctx->execute2;
         copy->internal->pkt = &p->avpkt;
 
         if (!i) {
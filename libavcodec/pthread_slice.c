@@ -68,13 +68,24 @@ typedef struct SliceThreadContext {
     pthread_mutex_t *progress_mutex;
 } SliceThreadContext;
 
+/**
+ * Frame threads keep their own PerThreadContext in thread_ctx, a slice
+ * thread pool started inside of one lives in slice_thread_ctx instead.
+ */
+static SliceThreadContext *get_slice_ctx(AVCodecContext *avctx)
+{
+    if (avctx->active_thread_type & FF_THREAD_FRAME)
+        return avctx->internal->slice_thread_ctx;
+    return avctx->internal->thread_ctx;
+}
+
 static void* attribute_align_arg worker(void *v)
 {
     AVCodecContext *avctx = v;
-    SliceThreadContext *c = avctx->internal->thread_ctx;
+    SliceThreadContext *c = get_slice_ctx(avctx);
     unsigned last_execute = 0;
     int our_job = c->job_count;
-    int thread_count = avctx->thread_count;
+    int thread_count = c->thread_count;
     int self_id;
 
     pthread_mutex_lock(&c->current_job_lock);
@@ -104,24 +115,26 @@ static void* attribute_align_arg worker(void *v)
     }
 }
 
-void ff_slice_thread_free(AVCodecContext *avctx)
+static void slice_thread_free(SliceThreadContext *c)
 {
-    SliceThreadContext *c = avctx->internal->thread_ctx;
     int i;
 
     pthread_mutex_lock(&c->current_job_lock);
     c->done = 1;
     pthread_cond_broadcast(&c->current_job_cond);
-    for (i = 0; i < c->thread_count; i++)
-        pthread_cond_broadcast(&c->progress_cond[i]);
+    if (c->progress_cond)
+        for (i = 0; i < c->thread_count; i++)
+            pthread_cond_broadcast(&c->progress_cond[i]);
     pthread_mutex_unlock(&c->current_job_lock);
 
-    for (i=0; i<avctx->thread_count; i++)
+    for (i=0; i<c->thread_count; i++)
          pthread_join(c->workers[i], NULL);
 
-    for (i = 0; i < c->thread_count; i++) {
-        pthread_mutex_destroy(&c->progress_mutex[i]);
-        pthread_cond_destroy(&c->progress_cond[i]);
+    if (c->progress_cond) {
+        for (i = 0; i < c->thread_count; i++) {
+            pthread_mutex_destroy(&c->progress_mutex[i]);
+            pthread_cond_destroy(&c->progress_cond[i]);
+        }
     }
 
     pthread_mutex_destroy(&c->current_job_lock);
@@ -133,9 +146,24 @@ void ff_slice_thread_free(AVCodecContext *avctx)
     av_freep(&c->progress_cond);
 
     av_freep(&c->workers);
+}
+
+void ff_slice_thread_free(AVCodecContext *avctx)
+{
+    slice_thread_free(avctx->internal->thread_ctx);
     av_freep(&avctx->internal->thread_ctx);
 }
 
+void ff_slice_thread_free_nested(AVCodecContext *avctx)
+{
+    if (!avctx->internal->slice_thread_ctx)
+        return;
+    slice_thread_free(avctx->internal->slice_thread_ctx);
+    av_freep(&avctx->internal->slice_thread_ctx);
+    avctx->execute  = avcodec_default_execute;
+    avctx->execute2 = avcodec_default_execute2;
+}
+
 static av_always_inline void thread_park_workers(SliceThreadContext *c, int thread_count)
 {
     while (c->current_job != thread_count + c->job_count)
@@ -145,10 +173,10 @@ static av_always_inline void thread_park_workers(SliceThreadContext *c, int thre
 
 static int thread_execute(AVCodecContext *avctx, action_func* func, void *arg, int *ret, int job_count, int job_size)
 {
-    SliceThreadContext *c = avctx->internal->thread_ctx;
+    SliceThreadContext *c = get_slice_ctx(avctx);
     int dummy_ret;
 
-    if (!(avctx->active_thread_type&FF_THREAD_SLICE) || avctx->thread_count <= 1)
+    if (!c || c->thread_count <= 1)
         return avcodec_default_execute(avctx, func, arg, ret, job_count, job_size);
 
     if (job_count <= 0)
@@ -156,7 +184,7 @@ static int thread_execute(AVCodecContext *avctx, action_func* func, void *arg, i
 
     pthread_mutex_lock(&c->current_job_lock);
 
-    c->current_job = avctx->thread_count;
+    c->current_job = c->thread_count;
     c->job_count = job_count;
     c->job_size = job_size;
     c->args = arg;
@@ -171,43 +199,29 @@ static int thread_execute(AVCodecContext *avctx, action_func* func, void *arg, i
     c->current_execute++;
     pthread_cond_broadcast(&c->current_job_cond);
 
-    thread_park_workers(c, avctx->thread_count);
+    thread_park_workers(c, c->thread_count);
 
     return 0;
 }
 
 static int thread_execute2(AVCodecContext *avctx, action_func2* func2, void *arg, int *ret, int job_count)
 {
-    SliceThreadContext *c = avctx->internal->thread_ctx;
+    SliceThreadContext *c = get_slice_ctx(avctx);
+
+    if (!c)
+        return avcodec_default_execute2(avctx, func2, arg, ret, job_count);
     c->func2 = func2;
     return thread_execute(avctx, NULL, arg, ret, job_count, 0);
 }
 
-int ff_slice_thread_init(AVCodecContext *avctx)
+/**
+ * Start thread_count workers running on avctx and store their context
+ * in *ctx, which must be where get_slice_ctx() looks for it.
+ */
+static int slice_thread_create(AVCodecContext *avctx, void **ctx, int thread_count)
 {
     int i;
     SliceThreadContext *c;
-    int thread_count = avctx->thread_count;
-
-#if HAVE_W32THREADS
-    w32thread_init();
-#endif
-
-    if (!thread_count) {
-        int nb_cpus = av_cpu_count();
-        if  (avctx->height)
-            nb_cpus = FFMIN(nb_cpus, (avctx->height+15)/16);
-        // use number of cores + 1 as thread count if there is more than one
-        if (nb_cpus > 1)
-            thread_count = avctx->thread_count = FFMIN(nb_cpus + 1, MAX_AUTO_THREADS);
-        else
-            thread_count = avctx->thread_count = 1;
-    }
-
-    if (thread_count <= 1) {
-        avctx->active_thread_type = 0;
-        return 0;
-    }
 
     c = av_mallocz(sizeof(SliceThreadContext));
     if (!c)
@@ -219,20 +233,22 @@ int ff_slice_thread_init(AVCodecContext *avctx)
         return -1;
     }
 
-    avctx->internal->thread_ctx = c;
+    *ctx = c;
     c->current_job = 0;
     c->job_count = 0;
     c->job_size = 0;
     c->done = 0;
+    c->thread_count = thread_count;
     pthread_cond_init(&c->current_job_cond, NULL);
     pthread_cond_init(&c->last_job_cond, NULL);
     pthread_mutex_init(&c->current_job_lock, NULL);
     pthread_mutex_lock(&c->current_job_lock);
     for (i=0; i<thread_count; i++) {
         if(pthread_create(&c->workers[i], NULL, worker, avctx)) {
-           avctx->thread_count = i;
+           c->thread_count = i;
            pthread_mutex_unlock(&c->current_job_lock);
-           ff_thread_free(avctx);
+           slice_thread_free(c);
+           av_freep(ctx);
            return -1;
         }
     }
@@ -244,9 +260,50 @@ int ff_slice_thread_init(AVCodecContext *avctx)
     return 0;
 }
 
+int ff_slice_thread_init(AVCodecContext *avctx)
+{
+    int thread_count = avctx->thread_count;
+    int ret;
+
+#if HAVE_W32THREADS
+    w32thread_init();
+#endif
+
+    if (!thread_count) {
+        int nb_cpus = av_cpu_count();
+        if  (avctx->height)
+            nb_cpus = FFMIN(nb_cpus, (avctx->height+15)/16);
+        // use number of cores + 1 as thread count if there is more than one
+        if (nb_cpus > 1)
+            thread_count = avctx->thread_count = FFMIN(nb_cpus + 1, MAX_AUTO_THREADS);
+        else
+            thread_count = avctx->thread_count = 1;
+    }
+
+    if (thread_count <= 1) {
+        avctx->active_thread_type = 0;
+        return 0;
+    }
+
+    ret = slice_thread_create(avctx, &avctx->internal->thread_ctx, thread_count);
+    if (ret < 0)
+        avctx->active_thread_type = 0;
+    return ret;
+}
+
+int ff_slice_thread_init_nested(AVCodecContext *avctx, int thread_count)
+{
+    if (!(avctx->active_thread_type & FF_THREAD_FRAME) || thread_count <= 1)
+        return 0;
+
+    if (slice_thread_create(avctx, &avctx->internal->slice_thread_ctx, thread_count) < 0)
+        return AVERROR(ENOMEM);
+    return 0;
+}
+
 void ff_thread_report_progress2(AVCodecContext *avctx, int field, int thread, int n)
 {
-    SliceThreadContext *p = avctx->internal->thread_ctx;
+    SliceThreadContext *p = get_slice_ctx(avctx);
     int *entries = p->entries;
 
     pthread_mutex_lock(&p->progress_mutex[thread]);
@@ -257,7 +314,7 @@ void ff_thread_report_progress2(AVCodecContext *avctx, int field, int thread, in
 
 void ff_thread_await_progress2(AVCodecContext *avctx, int field, int thread, int shift)
 {
-    SliceThreadContext *p  = avctx->internal->thread_ctx;
+    SliceThreadContext *p  = get_slice_ctx(avctx);
     int *entries      = p->entries;
 
     if (!entries || !field) return;
@@ -275,21 +332,32 @@ int ff_alloc_entries(AVCodecContext *avctx, int count)
 {
     int i;
 
-    if (avctx->active_thread_type & FF_THREAD_SLICE)  {
-        SliceThreadContext *p = avctx->internal->thread_ctx;
-        p->thread_count  = avctx->thread_count;
+    SliceThreadContext *p = get_slice_ctx(avctx);
+
+    if (p) {
+        if (p->entries && p->entries_count >= count)
+            return 0;
+
+        av_freep(&p->entries);
+        p->entries_count = 0;
         p->entries       = av_mallocz_array(count, sizeof(int));
+        if (!p->entries)
+            return AVERROR(ENOMEM);
+        p->entries_count = count;
+
+        if (p->progress_cond)
+            return 0;
 
         p->progress_mutex = av_malloc_array(p->thread_count, sizeof(pthread_mutex_t));
         p->progress_cond  = av_malloc_array(p->thread_count, sizeof(pthread_cond_t));
 
-        if (!p->entries || !p->progress_mutex || !p->progress_cond) {
+        if (!p->progress_mutex || !p->progress_cond) {
             av_freep(&p->entries);
             av_freep(&p->progress_mutex);
             av_freep(&p->progress_cond);
+            p->entries_count = 0;
             return AVERROR(ENOMEM);
         }
-        p->entries_count  = count;
 
         for (i = 0; i < p->thread_count; i++) {
             pthread_mutex_init(&p->progress_mutex[i], NULL);
@@ -302,6 +370,8 @@ int ff_alloc_entries(AVCodecContext *avctx, int count)
 
 void ff_reset_entries(AVCodecContext *avctx)
 {
-    SliceThreadContext *p = avctx->internal->thread_ctx;
+    SliceThreadContext *p = get_slice_ctx(avctx);
+    if (!p || !p->entries)
+        return;
     memset(p->entries, 0, p->entries_count * sizeof(int));
 }
@@ -135,6 +135,24 @@ int ff_thread_ref_frame(ThreadFrame *dst, ThreadFrame *src);
 int ff_thread_init(AVCodecContext *s);
 void ff_thread_free(AVCodecContext *s);
 
+/**
+ * Start a pool of slice threads private to a frame thread context, so that
+ * execute(), execute2() and the progress2 functions can be used while
+ * decoding a frame with frame threading active.
+ * Does nothing if frame threading is not active or thread_count is <= 1.
+ *
+ * @param avctx the frame thread context, as passed to init() or
+ *              init_thread_copy()
+ * @param thread_count number of slice threads to start
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int ff_slice_thread_init_nested(AVCodecContext *avctx, int thread_count);
+
+/**
+ * Stop the slice threads started by ff_slice_thread_init_nested(), if any.
+ */
+void ff_slice_thread_free_nested(AVCodecContext *avctx);
+
 int ff_alloc_entries(AVCodecContext *avctx, int count);
 void ff_reset_entries(AVCodecContext *avctx);
 void ff_thread_report_progress2(AVCodecContext *avctx, int field, int thread, int n);
@@ -3736,6 +3736,15 @@ int ff_thread_can_start_frame(AVCodecContext *avctx)
     return 1;
 }
 
+int ff_slice_thread_init_nested(AVCodecContext *avctx, int thread_count)
+{
+    return 0;
+}
+
+void ff_slice_thread_free_nested(AVCodecContext *avctx)
+{
+}
+
 int ff_alloc_entries(AVCodecContext *avctx, int count)
 {
     return 0;
@@ -152,7 +152,7 @@ static int bitplane_decoding(uint8_t* data, int *raw_flag, VC1Context *v)
                     code = get_vlc2(gb, ff_vc1_norm6_vlc.table, VC1_NORM6_VLC_BITS, 2);
                     if (code < 0) {
                         av_log(v->s.avctx, AV_LOG_DEBUG, "invalid NORM-6 VLC\n");
-                        return -1;
+                        goto fail;
                     }
                     planep[x + 0]              = (code >> 0) & 1;
                     planep[x + 1]              = (code >> 1) & 1;
@@ -172,7 +172,7 @@ static int bitplane_decoding(uint8_t* data, int *raw_flag, VC1Context *v)
                     code = get_vlc2(gb, ff_vc1_norm6_vlc.table, VC1_NORM6_VLC_BITS, 2);
                     if (code < 0) {
                         av_log(v->s.avctx, AV_LOG_DEBUG, "invalid NORM-6 VLC\n");
-                        return -1;
+                        goto fail;
                     }
                     planep[x + 0]          = (code >> 0) & 1;
                     planep[x + 1]          = (code >> 1) & 1;
@@ -197,7 +197,7 @@ static int bitplane_decoding(uint8_t* data, int *raw_flag, VC1Context *v)
         decode_colskip(data, width, height, stride, &v->s.gb);
         break;
     default:
-        break;
+        goto fail;
     }
 
     /* Applying diff operator */
@@ -220,6 +220,12 @@ static int bitplane_decoding(uint8_t* data, int *raw_flag, VC1Context *v)
             planep[x] = !planep[x]; //FIXME stride
     }
     return (imode << 1) + invert;
+
+fail:
+    /* the plane is used even if it is damaged, do not leave the rows of
+     * an earlier picture in it */
+    memset(data, 0, stride * height);
+    return -1;
 }
 
 /** @} */ //Bitplane group
@@ -386,6 +386,8 @@ typedef struct VC1Context{
     uint32_t *cbp_base, *cbp;
     uint8_t *is_intra_base, *is_intra;
     int16_t (*luma_mv_base)[2], (*luma_mv)[2];
+    struct VC1Context *slice_ctx[MAX_THREADS]; ///< per-thread contexts for slice threading, [0] is unused
+    uint8_t *coded_block_base;   ///< coded block flags of a slice thread context
     uint8_t bfraction_lut_index; ///< Index for BFRACTION value (see Table 40, reproduced into ff_vc1_bfraction_lut[])
     uint8_t broken_link;         ///< Broken link flag (BROKEN_LINK syntax element)
     uint8_t closed_entry;        ///< Closed entry point flag (CLOSED_ENTRY syntax element)
@@ -30,6 +30,7 @@
 #include "mpegutils.h"
 #include "mpegvideo.h"
 #include "msmpeg4data.h"
+#include "thread.h"
 #include "unary.h"
 #include "vc1.h"
 #include "vc1_pred.h"
@@ -66,6 +67,21 @@ static inline void init_block_index(VC1Context *v)
 
 /** @} */ //Bitplane group
 
+/**
+ * Report the rows of the current picture that later frame threads can use
+ * as reference. The overlap and loop filters run up to two rows behind the
+ * decoding loop, so the row before those is the last one that is final.
+ */
+static inline void vc1_report_row_progress(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+
+    if (HAVE_THREADS && (s->avctx->active_thread_type & FF_THREAD_FRAME) &&
+        !v->field_mode && s->pict_type != AV_PICTURE_TYPE_B &&
+        !s->er.error_occurred && s->mb_y >= 3)
+        ff_thread_report_progress(&s->current_picture_ptr->tf, s->mb_y - 3, 0);
+}
+
 static void vc1_put_signed_blocks_clamped(VC1Context *v)
 {
     MpegEncContext *s = &v->s;
@@ -403,10 +419,12 @@ static inline int ff_vc1_pred_dc(MpegEncContext *s, int overlap, int pq, int n,
 
     /* B A
      * C X
+     * The row above may belong to a slice decoded by another thread,
+     * so it is only read when it is available.
      */
     c = dc_val[ - 1];
-    b = dc_val[ - 1 - wrap];
-    a = dc_val[ - wrap];
+    b = a_avail ? dc_val[ - 1 - wrap] : 0;
+    a = a_avail ? dc_val[ - wrap]     : 0;
 
     if (c_avail && (n != 1 && n != 3)) {
         q2 = s->current_picture.qscale_table[mb_pos - 1];
@@ -957,15 +975,19 @@ static int vc1_decode_intra_block(VC1Context *v, int16_t block[64], int n,
         ac_val -= 16 * s->block_wrap[n];
 
     q1 = s->current_picture.qscale_table[mb_pos];
-    if (dc_pred_dir && c_avail && mb_pos)
-        q2 = s->current_picture.qscale_table[mb_pos - 1];
-    if (!dc_pred_dir && a_avail && mb_pos >= s->mb_stride)
-        q2 = s->current_picture.qscale_table[mb_pos - s->mb_stride];
-    if ( dc_pred_dir && n == 1)
-        q2 = q1;
-    if (!dc_pred_dir && n == 2)
+    if (n == 3)
         q2 = q1;
-    if (n == 3) q2 = q1;
+    else if (dc_pred_dir) {
+        if (n == 1)
+            q2 = q1;
+        else if (c_avail && mb_pos)
+            q2 = s->current_picture.qscale_table[mb_pos - 1];
+    } else {
+        if (n == 2)
+            q2 = q1;
+        else if (a_avail && mb_pos >= s->mb_stride)
+            q2 = s->current_picture.qscale_table[mb_pos - s->mb_stride];
+    }
 
     if (coded) {
         int last = 0, skip, value;
@@ -2082,6 +2104,16 @@ static void vc1_decode_b_mb_intfi(VC1Context *v)
                 dmv_x[1] = dmv_y[1] = pred_flag[0] = 0;
                 if (!s->next_picture_ptr->field_picture) {
                     av_log(s->avctx, AV_LOG_ERROR, "Mixed field/frame direct mode not supported\n");
+                    /* do not leave stale motion behind for the neighbours to
+                     * predict from, it differs between frame threads */
+                    for (i = 0; i < 4; i++) {
+                        int xy = s->block_index[i] + v->blocks_off;
+                        s->current_picture.motion_val[0][xy][0] = 0;
+                        s->current_picture.motion_val[0][xy][1] = 0;
+                        s->current_picture.motion_val[1][xy][0] = 0;
+                        s->current_picture.motion_val[1][xy][1] = 0;
+                        v->mv_f[0][xy] = v->mv_f[1][xy] = 0;
+                    }
                     return;
                 }
             }
@@ -2618,6 +2650,7 @@ static void vc1_decode_i_blocks(VC1Context *v)
             ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
 
         s->first_slice_line = 0;
+        vc1_report_row_progress(v);
     }
     if (v->s.loop_filter)
         ff_mpeg_draw_horiz_band(s, (s->end_mb_y - 1) * 16, 16);
@@ -2746,6 +2779,7 @@ static void vc1_decode_i_blocks_adv(VC1Context *v)
         else if (s->mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y-1) * 16, 16);
         s->first_slice_line = 0;
+        vc1_report_row_progress(v);
     }
 
     /* raw bottom MB row */
@@ -2825,6 +2859,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
         if (s->mb_y != s->start_mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
         s->first_slice_line = 0;
+        vc1_report_row_progress(v);
     }
     if (apply_loop_filter) {
         s->mb_x = 0;
@@ -2873,6 +2908,10 @@ static void vc1_decode_b_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
+        /* direct prediction reads the colocated motion of the next anchor */
+        if (HAVE_THREADS && (s->avctx->active_thread_type & FF_THREAD_FRAME))
+            ff_thread_await_progress(&s->next_picture.tf,
+                                     (s->mb_y << v->field_mode) + v->field_mode, 0);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -2917,11 +2956,14 @@ static void vc1_decode_skip_blocks(VC1Context *v)
         s->mb_x = 0;
         init_block_index(v);
         ff_update_block_index(s);
+        if (HAVE_THREADS && (s->avctx->active_thread_type & FF_THREAD_FRAME))
+            ff_thread_await_progress(&s->last_picture.tf, s->mb_y, 0);
         memcpy(s->dest[0], s->last_picture.f->data[0] + s->mb_y * 16 * s->linesize,   s->linesize   * 16);
         memcpy(s->dest[1], s->last_picture.f->data[1] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         memcpy(s->dest[2], s->last_picture.f->data[2] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
         s->first_slice_line = 0;
+        vc1_report_row_progress(v);
     }
     s->pict_type = AV_PICTURE_TYPE_P;
 }
@@ -30,8 +30,26 @@
 #include "h264chroma.h"
 #include "mathops.h"
 #include "mpegvideo.h"
+#include "thread.h"
 #include "vc1.h"
 
+/**
+ * Wait until a reference picture decoded by another frame thread has the
+ * rows available that a block reads from.
+ * @param bottom lowest luma line read, in field lines for field pictures
+ */
+static av_always_inline void vc1_await_reference(VC1Context *v, ThreadFrame *ref,
+                                                 int bottom)
+{
+    if (HAVE_THREADS && (v->s.avctx->active_thread_type & FF_THREAD_FRAME)) {
+        if (v->field_mode)
+            bottom = 2 * bottom + 1;
+        else if (v->fcm == ILACE_FRAME)
+            bottom += 20; // field MVs read every second line
+        ff_thread_await_progress(ref, FFMAX(bottom, 0) >> 4, 0);
+    }
+}
+
 static av_always_inline void vc1_scale_luma(uint8_t *srcY,
                                             int k, int linesize)
 {
@@ -179,6 +197,7 @@ void ff_vc1_mc_1mv(VC1Context *v, int dir)
     int i;
     uint8_t (*luty)[256], (*lutuv)[256];
     int use_ic;
+    ThreadFrame *ref = NULL;
 
     if ((!v->field_mode ||
          (v->ref_field_type[dir] == 1 && v->cur_field_type == 1)) &&
@@ -227,6 +246,7 @@ void ff_vc1_mc_1mv(VC1Context *v, int dir)
             luty  = v->last_luty;
             lutuv = v->last_lutuv;
             use_ic = v->last_use_ic;
+            ref   = &s->last_picture.tf;
         }
     } else {
         srcY = s->next_picture.f->data[0];
@@ -235,6 +255,7 @@ void ff_vc1_mc_1mv(VC1Context *v, int dir)
         luty  = v->next_luty;
         lutuv = v->next_lutuv;
         use_ic = v->next_use_ic;
+        ref   = &s->next_picture.tf;
     }
 
     if (!srcY || !srcU) {
@@ -259,6 +280,9 @@ void ff_vc1_mc_1mv(VC1Context *v, int dir)
         uvsrc_y = av_clip(uvsrc_y,  -8, s->avctx->coded_height >> 1);
     }
 
+    if (ref)
+        vc1_await_reference(v, ref, FFMAX(src_y, 2 * uvsrc_y) + 18);
+
     srcY += src_y   * s->linesize   + src_x;
     srcU += uvsrc_y * s->uvlinesize + uvsrc_x;
     srcV += uvsrc_y * s->uvlinesize + uvsrc_x;
@@ -358,6 +382,7 @@ void ff_vc1_mc_4mv_luma(VC1Context *v, int n, int dir, int avg)
     int v_edge_pos = s->v_edge_pos >> v->field_mode;
     uint8_t (*luty)[256];
     int use_ic;
+    ThreadFrame *ref = NULL;
 
     if ((!v->field_mode ||
          (v->ref_field_type[dir] == 1 && v->cur_field_type == 1)) &&
@@ -376,11 +401,13 @@ void ff_vc1_mc_4mv_luma(VC1Context *v, int n, int dir, int avg)
             srcY = s->last_picture.f->data[0];
             luty = v->last_luty;
             use_ic = v->last_use_ic;
+            ref  = &s->last_picture.tf;
         }
     } else {
         srcY = s->next_picture.f->data[0];
         luty = v->next_luty;
         use_ic = v->next_use_ic;
+        ref  = &s->next_picture.tf;
     }
 
     if (!srcY) {
@@ -449,6 +476,9 @@ void ff_vc1_mc_4mv_luma(VC1Context *v, int n, int dir, int avg)
         }
     }
 
+    if (ref)
+        vc1_await_reference(v, ref, src_y + 18);
+
     srcY += src_y * s->linesize + src_x;
     if (v->field_mode && v->ref_field_type[dir])
         srcY += s->current_picture_ptr->f->linesize[0];
@@ -515,6 +545,7 @@ void ff_vc1_mc_4mv_chroma(VC1Context *v, int dir)
     int v_edge_pos = s->v_edge_pos >> v->field_mode;
     uint8_t (*lutuv)[256];
     int use_ic;
+    ThreadFrame *ref = NULL;
 
     if (!v->field_mode && !v->s.last_picture.f->data[0])
         return;
@@ -575,12 +606,14 @@ void ff_vc1_mc_4mv_chroma(VC1Context *v, int dir)
             srcV = s->last_picture.f->data[2];
             lutuv = v->last_lutuv;
             use_ic = v->last_use_ic;
+            ref   = &s->last_picture.tf;
         }
     } else {
         srcU = s->next_picture.f->data[1];
         srcV = s->next_picture.f->data[2];
         lutuv = v->next_lutuv;
         use_ic = v->next_use_ic;
+        ref   = &s->next_picture.tf;
     }
 
     if (!srcU) {
@@ -588,6 +621,9 @@ void ff_vc1_mc_4mv_chroma(VC1Context *v, int dir)
         return;
     }
 
+    if (ref)
+        vc1_await_reference(v, ref, 2 * uvsrc_y + 18);
+
     srcU += uvsrc_y * s->uvlinesize + uvsrc_x;
     srcV += uvsrc_y * s->uvlinesize + uvsrc_x;
 
@@ -654,6 +690,7 @@ void ff_vc1_mc_4mv_chroma4(VC1Context *v, int dir, int dir2, int avg)
     int v_edge_pos = s->v_edge_pos >> 1;
     int use_ic;
     uint8_t (*lutuv)[256];
+    ThreadFrame *ref;
 
     if (CONFIG_GRAY && s->avctx->flags & CODEC_FLAG_GRAY)
         return;
@@ -681,14 +718,17 @@ void ff_vc1_mc_4mv_chroma4(VC1Context *v, int dir, int dir2, int avg)
             srcV = s->next_picture.f->data[2];
             lutuv  = v->next_lutuv;
             use_ic = v->next_use_ic;
+            ref    = &s->next_picture.tf;
         } else {
             srcU = s->last_picture.f->data[1];
             srcV = s->last_picture.f->data[2];
             lutuv  = v->last_lutuv;
             use_ic = v->last_use_ic;
+            ref    = &s->last_picture.tf;
         }
         if (!srcU)
             return;
+        vc1_await_reference(v, ref, 2 * uvsrc_y + 18);
         srcU += uvsrc_y * s->uvlinesize + uvsrc_x;
         srcV += uvsrc_y * s->uvlinesize + uvsrc_x;
         uvmx_field[i] = (uvmx_field[i] & 3) << 1;
@@ -790,6 +830,8 @@ void ff_vc1_interp_mc(VC1Context *v)
         uvsrc_y = av_clip(uvsrc_y,  -8, s->avctx->coded_height >> 1);
     }
 
+    vc1_await_reference(v, &s->next_picture.tf, FFMAX(src_y, 2 * uvsrc_y) + 18);
+
     srcY += src_y   * s->linesize   + src_x;
     srcU += uvsrc_y * s->uvlinesize + uvsrc_x;
     srcV += uvsrc_y * s->uvlinesize + uvsrc_x;
@@ -712,6 +712,9 @@ void ff_vc1_pred_b_mv(VC1Context *v, int dmv_x[2], int dmv_y[2],
         s->current_picture.motion_val[0][xy][1] =
         s->current_picture.motion_val[1][xy][0] =
         s->current_picture.motion_val[1][xy][1] = 0;
+        /* a damaged interpolated MB can still be motion compensated,
+         * do not leave the vectors of the previous MB behind */
+        memset(s->mv, 0, sizeof(s->mv));
         return;
     }
         if (direct && s->next_picture_ptr->field_picture)
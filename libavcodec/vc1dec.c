@@ -33,6 +33,7 @@
 #include "mpeg_er.h"
 #include "mpegvideo.h"
 #include "msmpeg4data.h"
+#include "thread.h"
 #include "vc1.h"
 #include "vc1data.h"
 #include "vdpau_compat.h"
@@ -569,6 +570,9 @@ static av_cold int vc1_decode_init(AVCodecContext *avctx)
             return AVERROR_PATCHWELCOME;
         }
     }
+
+    avctx->internal->allocate_progress = 1;
+
     return 0;
 }
 
@@ -602,10 +606,139 @@ av_cold int ff_vc1_decode_end(AVCodecContext *avctx)
     av_freep(&v->ttblk_base);
     av_freep(&v->is_intra_base); // FIXME use v->mb_type[]
     av_freep(&v->luma_mv_base);
+    for (i = 1; i < MAX_THREADS; i++) {
+        VC1Context *vc = v->slice_ctx[i];
+        if (!vc)
+            continue;
+        av_freep(&vc->block);
+        av_freep(&vc->cbp_base);
+        av_freep(&vc->ttblk_base);
+        av_freep(&vc->is_intra_base);
+        av_freep(&vc->luma_mv_base);
+        av_freep(&vc->coded_block_base);
+        av_freep(&v->slice_ctx[i]);
+    }
     ff_intrax8_common_end(&v->x8);
     return 0;
 }
 
+typedef struct VC1SliceJob {
+    GetBitContext gb;
+    int start_mb_y, end_mb_y;
+} VC1SliceJob;
+
+typedef struct VC1SliceThreadArgs {
+    VC1Context *v;
+    VC1SliceJob *jobs;
+    int nb_jobs, nb_threads;
+} VC1SliceThreadArgs;
+
+/**
+ * Prepare the context of slice thread n for decoding the current picture.
+ * It shares the picture and the per-picture tables with the main context,
+ * but has its own scratch buffers and row state, since slices are decoded
+ * independently of each other.
+ */
+static int vc1_update_slice_context(VC1Context *v, int n)
+{
+    MpegEncContext *s = &v->s;
+    VC1Context *vc    = v->slice_ctx[n];
+    int16_t (*block)[6][64];
+    uint32_t *cbp_base;
+    int *ttblk_base;
+    uint8_t *is_intra_base, *coded_block_base;
+    int16_t (*luma_mv_base)[2];
+    int ret;
+
+    if (!vc) {
+        int y_size = s->b8_stride * (2 * s->mb_height + 1);
+
+        if (!(vc = v->slice_ctx[n] = av_mallocz(sizeof(*vc))))
+            return AVERROR(ENOMEM);
+        vc->block            = av_malloc(sizeof(*vc->block) * v->n_allocated_blks);
+        vc->cbp_base         = av_malloc(sizeof(vc->cbp_base[0]) * 2 * s->mb_stride);
+        vc->ttblk_base       = av_malloc(sizeof(vc->ttblk_base[0]) * 2 * s->mb_stride);
+        vc->is_intra_base    = av_mallocz(sizeof(vc->is_intra_base[0]) * 2 * s->mb_stride);
+        vc->luma_mv_base     = av_mallocz(sizeof(vc->luma_mv_base[0]) * 2 * s->mb_stride);
+        vc->coded_block_base = av_mallocz(y_size + (s->mb_height & 1) * 2 * s->b8_stride);
+        if (!vc->block || !vc->cbp_base || !vc->ttblk_base || !vc->is_intra_base ||
+            !vc->luma_mv_base || !vc->coded_block_base)
+            return AVERROR(ENOMEM); // freed through ff_vc1_decode_end()
+    }
+
+    if ((ret = ff_update_duplicate_context(s->thread_context[n], s)) < 0)
+        return ret;
+
+    block            = vc->block;
+    cbp_base         = vc->cbp_base;
+    ttblk_base       = vc->ttblk_base;
+    is_intra_base    = vc->is_intra_base;
+    luma_mv_base     = vc->luma_mv_base;
+    coded_block_base = vc->coded_block_base;
+
+    memcpy(vc, v, sizeof(*vc));
+    memcpy(&vc->s, s->thread_context[n], sizeof(vc->s));
+    memset(vc->slice_ctx, 0, sizeof(vc->slice_ctx));
+
+    vc->block            = block;
+    vc->cbp_base         = cbp_base;
+    vc->cbp              = cbp_base + s->mb_stride;
+    vc->ttblk_base       = ttblk_base;
+    vc->ttblk            = ttblk_base + s->mb_stride;
+    vc->is_intra_base    = is_intra_base;
+    vc->is_intra         = is_intra_base + s->mb_stride;
+    vc->luma_mv_base     = luma_mv_base;
+    vc->luma_mv          = luma_mv_base + s->mb_stride;
+    vc->coded_block_base = coded_block_base;
+    vc->s.coded_block    = coded_block_base + s->b8_stride + 1;
+    vc->s.er.error_count = 0;
+
+    return 0;
+}
+
+static int vc1_decode_slice_thread(AVCodecContext *avctx, void *arg,
+                                   int jobnr, int threadnr)
+{
+    VC1SliceThreadArgs *t = arg;
+    VC1Context *v = jobnr ? t->v->slice_ctx[jobnr] : t->v;
+    int i;
+
+    for (i = jobnr; i < t->nb_jobs; i += t->nb_threads) {
+        v->s.gb         = t->jobs[i].gb;
+        v->s.start_mb_y = t->jobs[i].start_mb_y;
+        v->s.end_mb_y   = t->jobs[i].end_mb_y;
+        ff_vc1_decode_blocks(v);
+    }
+    return 0;
+}
+
+/**
+ * Decode the slices of a progressive picture in parallel, one slice thread
+ * taking every nb_threads-th slice.
+ */
+static int vc1_decode_slices_mt(VC1Context *v, VC1SliceJob *jobs, int nb_jobs)
+{
+    MpegEncContext *s = &v->s;
+    VC1SliceThreadArgs t = { v, jobs, nb_jobs, FFMIN(nb_jobs, s->slice_context_count) };
+    int i, ret;
+
+    for (i = 1; i < t.nb_threads; i++)
+        if ((ret = vc1_update_slice_context(v, i)) < 0)
+            return ret;
+
+    s->avctx->execute2(s->avctx, vc1_decode_slice_thread, &t, NULL, t.nb_threads);
+
+    for (i = 1; i < t.nb_threads; i++) {
+        ERContext *er = &v->slice_ctx[i]->s.er;
+        if (er->error_count == INT_MAX || s->er.error_count == INT_MAX)
+            s->er.error_count = INT_MAX;
+        else
+            s->er.error_count += er->error_count;
+        s->er.error_occurred |= er->error_occurred;
+    }
+    return 0;
+}
+
 
 /** Decode a VC1/WMV3 frame
  * @todo TODO: Handle VC-1 IDUs (Transport level?)
@@ -626,6 +759,8 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
         GetBitContext gb;
         int mby_start;
     } *slices = NULL, *tmp;
+    VC1SliceJob *jobs = NULL;
+    int nb_jobs = 0, slice_headers = 0, frame_started = 0;
 
     v->second_field = 0;
 
@@ -852,6 +987,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     if (ff_mpv_frame_start(s, avctx) < 0) {
         goto err;
     }
+    frame_started = 1;
 
     v->s.current_picture_ptr->field_picture = v->field_mode;
     v->s.current_picture_ptr->f->interlaced_frame = (v->fcm != PROGRESSIVE);
@@ -872,6 +1008,15 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     s->me.qpel_put = s->qdsp.put_qpel_pixels_tab;
     s->me.qpel_avg = s->qdsp.avg_qpel_pixels_tab;
 
+    /* A slice may repeat the picture header, and the second field of a field
+     * picture has its own one, so only let the next frame thread start early
+     * when all of the header state is known now. */
+    if (!v->field_mode)
+        for (i = 0; i < n_slices; i++)
+            slice_headers |= show_bits1(&slices[i].gb);
+    if (!v->field_mode && !slice_headers)
+        ff_thread_finish_setup(avctx);
+
     if ((CONFIG_VC1_VDPAU_DECODER)
         &&s->avctx->codec->capabilities&CODEC_CAP_HWACCEL_VDPAU) {
         if (v->field_mode && buf_start_second_field) {
@@ -935,6 +1080,13 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
 
         av_assert0 (mb_height > 0);
 
+        if (HAVE_THREADS && (avctx->active_thread_type & FF_THREAD_SLICE) &&
+            s->slice_context_count > 1 && n_slices && !v->field_mode && !slice_headers) {
+            jobs = av_malloc_array(n_slices + 1, sizeof(*jobs));
+            if (!jobs)
+                goto err;
+        }
+
         for (i = 0; i <= n_slices; i++) {
             if (i > 0 &&  slices[i - 1].mby_start >= mb_height) {
                 if (v->field_mode <= 0) {
@@ -991,10 +1143,18 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
                 av_log(v->s.avctx, AV_LOG_ERROR, "missing cbpcy_vlc\n");
                 continue;
             }
-            ff_vc1_decode_blocks(v);
+            if (jobs) {
+                jobs[nb_jobs].gb         = s->gb;
+                jobs[nb_jobs].start_mb_y = s->start_mb_y;
+                jobs[nb_jobs].end_mb_y   = s->end_mb_y;
+                nb_jobs++;
+            } else
+                ff_vc1_decode_blocks(v);
             if (i != n_slices)
                 s->gb = slices[i].gb;
         }
+        if (nb_jobs && vc1_decode_slices_mt(v, jobs, nb_jobs) < 0)
+            goto err;
         if (v->field_mode) {
             v->second_field = 0;
             s->current_picture.f->linesize[0] >>= 1;
@@ -1051,16 +1211,102 @@ end:
     for (i = 0; i < n_slices; i++)
         av_free(slices[i].buf);
     av_free(slices);
+    av_free(jobs);
     return buf_size;
 
 err:
+    /* do not leave frame threads waiting for rows that will never come */
+    if (frame_started)
+        ff_thread_report_progress(&s->current_picture_ptr->tf, INT_MAX, 0);
     av_free(buf2);
     for (i = 0; i < n_slices; i++)
         av_free(slices[i].buf);
     av_free(slices);
+    av_free(jobs);
     return -1;
 }
 
+#if HAVE_THREADS
+static int vc1_decode_init_thread_copy(AVCodecContext *avctx)
+{
+    VC1Context *v = avctx->priv_data;
+
+    /* the tables are allocated by vc1_decode_update_thread_context() once
+     * the first context is initialized */
+    v->s.avctx             = avctx;
+    v->sprite_output_frame = NULL;
+    return 0;
+}
+
+#define copy_fields(to, from, start_field, end_field)                   \
+    memcpy(&(to)->start_field, &(from)->start_field,                    \
+           (char *)&(to)->end_field - (char *)&(to)->start_field)
+
+static int vc1_decode_update_thread_context(AVCodecContext *dst,
+                                            const AVCodecContext *src)
+{
+    VC1Context *v = dst->priv_data, *v1 = src->priv_data;
+    MpegEncContext *s = &v->s, *s1 = &v1->s;
+    int size, ret;
+
+    if (dst == src)
+        return 0;
+
+    if (s->context_initialized &&
+        (s->width != s1->width || s->height != s1->height))
+        ff_vc1_decode_end(dst);
+
+    if ((ret = ff_mpeg_update_thread_context(dst, src)) < 0)
+        return ret;
+
+    if (!s->context_initialized)
+        return 0;
+    if (!v->mv_type_mb_plane && (ret = ff_vc1_decode_init_alloc_tables(v)) < 0)
+        return ret;
+    s->h_edge_pos = s1->h_edge_pos;
+    s->v_edge_pos = s1->v_edge_pos;
+
+    /* sequence, entry point and picture header state; the per-picture
+     * bitplanes and row buffers are left alone */
+    copy_fields(v, v1, res_sprite,          ttblk_base);
+    copy_fields(v, v1, lumscale,            mv_type_mb_plane);
+    copy_fields(v, v1, mv_type_is_raw,      curr_luty);
+    v->last_use_ic = v1->last_use_ic;
+    v->next_use_ic = v1->next_use_ic;
+    v->aux_use_ic  = v1->aux_use_ic;
+    copy_fields(v, v1, rnd,                 acpred_plane);
+    v->acpred_is_raw  = v1->acpred_is_raw;
+    v->overflg_is_raw = v1->overflg_is_raw;
+    v->condover       = v1->condover;
+    copy_fields(v, v1, range_mapy_flag,     fieldtx_plane);
+    copy_fields(v, v1, fieldtx_is_raw,      blk_mv_type_base);
+    copy_fields(v, v1, field_mode,          new_sprite);
+    copy_fields(v, v1, p_frame_skipped,     block);
+    copy_fields(v, v1, bfraction_lut_index, end_mb_x);
+    v->resync_marker = v1->resync_marker;
+
+    /* the intensity compensation pointers refer to tables of the context */
+    if (v1->curr_luty) {
+        int aux = v1->curr_luty == v1->aux_luty;
+        v->curr_luty   = aux ? v->aux_luty   : v->next_luty;
+        v->curr_lutuv  = aux ? v->aux_lutuv  : v->next_lutuv;
+        v->curr_use_ic = aux ? &v->aux_use_ic : &v->next_use_ic;
+    }
+
+    /* The field MV flags of the next anchor are only written when a field
+     * picture is finished, which never overlaps with this call. */
+    size = 2 * (s->b8_stride * (FFALIGN(s->mb_height, 2) * 2 + 1) +
+                s->mb_stride * (FFALIGN(s->mb_height, 2) + 1) * 2);
+    memcpy(v->mv_f_next[0] - s->b8_stride - 1,
+           v1->mv_f_next[0] - s->b8_stride - 1, size);
+    if (v1->field_mode)
+        memcpy(v->mv_f[0] - s->b8_stride - 1,
+               v1->mv_f[0] - s->b8_stride - 1, size);
+
+    return 0;
+}
+#endif
+
 
 static const AVProfile profiles[] = {
     { FF_PROFILE_VC1_SIMPLE,   "Simple"   },
@@ -1097,7 +1343,10 @@ AVCodec ff_vc1_decoder = {
     .close          = ff_vc1_decode_end,
     .decode         = vc1_decode_frame,
     .flush          = ff_mpeg_flush,
-    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY,
+    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY | CODEC_CAP_FRAME_THREADS |
+                      CODEC_CAP_SLICE_THREADS,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(vc1_decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_decode_update_thread_context),
     .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
     .profiles       = NULL_IF_CONFIG_SMALL(profiles)
 };
@@ -1113,7 +1362,9 @@ AVCodec ff_wmv3_decoder = {
     .close          = ff_vc1_decode_end,
     .decode         = vc1_decode_frame,
     .flush          = ff_mpeg_flush,
-    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY,
+    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY | CODEC_CAP_FRAME_THREADS,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(vc1_decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_decode_update_thread_context),
     .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
     .profiles       = NULL_IF_CONFIG_SMALL(profiles)
 };
@@ -101,6 +101,7 @@ typedef struct VP9Context {
     VP56RangeCoder c;
     VP56RangeCoder *c_b;
     unsigned c_b_size;
+    struct VP9Context **slice_ctx; // per-thread copies for tile threading
     VP9Block *b_base, *b;
     int pass;
     int row, row7, col, col7;
@@ -313,7 +314,7 @@ static int update_size(AVCodecContext *ctx, int w, int h, enum AVPixelFormat fmt
 {
     VP9Context *s = ctx->priv_data;
     uint8_t *p;
-    int bytesperpixel = s->bytesperpixel;
+    int bytesperpixel = s->bytesperpixel, lflvl_rows, i;
 
     av_assert0(w > 0 && h > 0);
 
@@ -327,13 +328,16 @@ static int update_size(AVCodecContext *ctx, int w, int h, enum AVPixelFormat fmt
     s->sb_rows   = (h + 63) >> 6;
     s->cols      = (w + 7) >> 3;
     s->rows      = (h + 7) >> 3;
+    // tile threads run the loopfilter behind the reconstruction, so they
+    // keep the filter masks of every sb row around instead of a single one
+    lflvl_rows   = ctx->active_thread_type == FF_THREAD_SLICE ? s->sb_rows : 1;
 
 #define assign(var, type, n) var = (type) p; p += s->sb_cols * (n) * sizeof(*var)
     av_freep(&s->intra_pred_data[0]);
     // FIXME we slightly over-allocate here for subsampled chroma, but a little
     // bit of padding shouldn't affect performance...
-    p = av_malloc(s->sb_cols * (128 + 192 * bytesperpixel +
-                                sizeof(*s->lflvl) + 16 * sizeof(*s->above_mv_ctx)));
+    p = av_malloc(s->sb_cols * (128 + 192 * bytesperpixel + lflvl_rows * sizeof(*s->lflvl) +
+                                16 * sizeof(*s->above_mv_ctx)));
     if (!p)
         return AVERROR(ENOMEM);
     assign(s->intra_pred_data[0],  uint8_t *,             64 * bytesperpixel);
@@ -352,12 +356,20 @@ static int update_size(AVCodecContext *ctx, int w, int h, enum AVPixelFormat fmt
     assign(s->above_comp_ctx,      uint8_t *,              8);
     assign(s->above_ref_ctx,       uint8_t *,              8);
     assign(s->above_filter_ctx,    uint8_t *,              8);
-    assign(s->lflvl,               struct VP9Filter *,     1);
+    assign(s->lflvl,               struct VP9Filter *,     lflvl_rows);
 #undef assign
 
     // these will be re-allocated a little later
     av_freep(&s->b_base);
     av_freep(&s->block_base);
+    if (s->slice_ctx) {
+        for (i = 1; i < ctx->thread_count; i++) {
+            if (s->slice_ctx[i]) {
+                av_freep(&s->slice_ctx[i]->b_base);
+                av_freep(&s->slice_ctx[i]->block_base);
+            }
+        }
+    }
 
     if (s->bpp != s->last_bpp) {
         ff_vp9dsp_init(&s->dsp, s->bpp);
@@ -368,44 +380,31 @@ static int update_size(AVCodecContext *ctx, int w, int h, enum AVPixelFormat fmt
     return 0;
 }
 
-static int update_block_buffers(AVCodecContext *ctx)
+static int update_block_buffers(VP9Context *s)
 {
-    VP9Context *s = ctx->priv_data;
     int chroma_blocks, chroma_eobs, bytesperpixel = s->bytesperpixel;
+    int sbs = s->frames[CUR_FRAME].uses_2pass ? s->sb_cols * s->sb_rows : 1;
 
-    if (s->b_base && s->block_base && s->block_alloc_using_2pass == s->frames[CUR_FRAME].uses_2pass)
-        return 0;
-
-    av_free(s->b_base);
-    av_free(s->block_base);
     chroma_blocks = 64 * 64 >> (s->ss_h + s->ss_v);
     chroma_eobs   = 16 * 16 >> (s->ss_h + s->ss_v);
-    if (s->frames[CUR_FRAME].uses_2pass) {
-        int sbs = s->sb_cols * s->sb_rows;
-
-        s->b_base = av_malloc_array(s->cols * s->rows, sizeof(VP9Block));
+    if (!s->b_base || !s->block_base || s->block_alloc_using_2pass != s->frames[CUR_FRAME].uses_2pass) {
+        av_free(s->b_base);
+        av_free(s->block_base);
+        s->b_base = av_malloc_array(s->frames[CUR_FRAME].uses_2pass ? s->cols * s->rows : 1,
+                                    sizeof(VP9Block));
         s->block_base = av_mallocz(((64 * 64 + 2 * chroma_blocks) * bytesperpixel * sizeof(int16_t) +
                                     16 * 16 + 2 * chroma_eobs) * sbs);
         if (!s->b_base || !s->block_base)
             return AVERROR(ENOMEM);
-        s->uvblock_base[0] = s->block_base + sbs * 64 * 64 * bytesperpixel;
-        s->uvblock_base[1] = s->uvblock_base[0] + sbs * chroma_blocks * bytesperpixel;
-        s->eob_base = (uint8_t *) (s->uvblock_base[1] + sbs * chroma_blocks * bytesperpixel);
-        s->uveob_base[0] = s->eob_base + 16 * 16 * sbs;
-        s->uveob_base[1] = s->uveob_base[0] + chroma_eobs * sbs;
-    } else {
-        s->b_base = av_malloc(sizeof(VP9Block));
-        s->block_base = av_mallocz((64 * 64 + 2 * chroma_blocks) * bytesperpixel * sizeof(int16_t) +
-                                   16 * 16 + 2 * chroma_eobs);
-        if (!s->b_base || !s->block_base)
-            return AVERROR(ENOMEM);
-        s->uvblock_base[0] = s->block_base + 64 * 64 * bytesperpixel;
-        s->uvblock_base[1] = s->uvblock_base[0] + chroma_blocks * bytesperpixel;
-        s->eob_base = (uint8_t *) (s->uvblock_base[1] + chroma_blocks * bytesperpixel);
-        s->uveob_base[0] = s->eob_base + 16 * 16;
-        s->uveob_base[1] = s->uveob_base[0] + chroma_eobs;
+        s->block_alloc_using_2pass = s->frames[CUR_FRAME].uses_2pass;
     }
-    s->block_alloc_using_2pass = s->frames[CUR_FRAME].uses_2pass;
+    // the pointers below are re-derived on every call since the tile thread
+    // copies of the context inherit the ones of the main context
+    s->uvblock_base[0] = s->block_base + sbs * 64 * 64 * bytesperpixel;
+    s->uvblock_base[1] = s->uvblock_base[0] + sbs * chroma_blocks * bytesperpixel;
+    s->eob_base = (uint8_t *) (s->uvblock_base[1] + sbs * chroma_blocks * bytesperpixel);
+    s->uveob_base[0] = s->eob_base + 16 * 16 * sbs;
+    s->uveob_base[1] = s->uveob_base[0] + chroma_eobs * sbs;
 
     return 0;
 }
@@ -710,9 +709,22 @@ static int decode_frame_header(AVCodecContext *ctx,
     s->filter.level = get_bits(&s->gb, 6);
     sharp = get_bits(&s->gb, 3);
     // if sharpness changed, reinit lim/mblim LUTs. if it didn't change, keep
-    // the old cache values since they are still valid
-    if (s->filter.sharpness != sharp)
-        memset(s->filter.lim_lut, 0, sizeof(s->filter.lim_lut));
+    // the old values since they are still valid. They are filled in here
+    // rather than on first use so that tile threads only ever read them.
+    if (s->filter.sharpness != sharp) {
+        for (i = 1; i <= 63; i++) {
+            int limit = i;
+
+            if (sharp > 0) {
+                limit >>= (sharp + 3) >> 2;
+                limit = FFMIN(limit, 9 - sharp);
+            }
+            limit = FFMAX(limit, 1);
+
+            s->filter.lim_lut[i] = limit;
+            s->filter.mblim_lut[i] = 2 * (i + 2) + limit;
+        }
+    }
     s->filter.sharpness = sharp;
     if ((s->lf_delta.enabled = get_bits1(&s->gb))) {
         if (get_bits1(&s->gb)) {
@@ -842,14 +854,13 @@ static int decode_frame_header(AVCodecContext *ctx,
     }
     s->tiling.log2_tile_rows = decode012(&s->gb);
     s->tiling.tile_rows = 1 << s->tiling.log2_tile_rows;
-    if (s->tiling.tile_cols != (1 << s->tiling.log2_tile_cols)) {
-        s->tiling.tile_cols = 1 << s->tiling.log2_tile_cols;
-        s->c_b = av_fast_realloc(s->c_b, &s->c_b_size,
-                                 sizeof(VP56RangeCoder) * s->tiling.tile_cols);
-        if (!s->c_b) {
-            av_log(ctx, AV_LOG_ERROR, "Ran out of memory during range coder init\n");
-            return AVERROR(ENOMEM);
-        }
+    s->tiling.tile_cols = 1 << s->tiling.log2_tile_cols;
+    // tile threads set up the range coders of all tiles at once
+    s->c_b = av_fast_realloc(s->c_b, &s->c_b_size,
+                             sizeof(VP56RangeCoder) * s->tiling.tile_cols * s->tiling.tile_rows);
+    if (!s->c_b) {
+        av_log(ctx, AV_LOG_ERROR, "Ran out of memory during range coder init\n");
+        return AVERROR(ENOMEM);
     }
 
     if (s->keyframe || s->errorres || s->intraonly) {
@@ -1450,7 +1461,7 @@ static av_always_inline void setctx_2d(uint8_t *ptr, int w, int h,
     }
 }
 
-static void decode_mode(AVCodecContext *ctx)
+static void decode_mode(VP9Context *s)
 {
     static const uint8_t left_ctx[N_BS_SIZES] = {
         0x0, 0x8, 0x0, 0x8, 0xc, 0x8, 0xc, 0xe, 0xc, 0xe, 0xf, 0xe, 0xf
@@ -1462,7 +1473,6 @@ static void decode_mode(AVCodecContext *ctx)
         TX_32X32, TX_32X32, TX_32X32, TX_32X32, TX_16X16, TX_16X16,
         TX_16X16, TX_8X8, TX_8X8, TX_8X8, TX_4X4, TX_4X4, TX_4X4
     };
-    VP9Context *s = ctx->priv_data;
     VP9Block *b = s->b;
     int row = s->row, col = s->col, row7 = s->row7;
     enum TxfmMode max_tx = max_tx_for_bl_bp[b->bs];
@@ -2318,9 +2328,8 @@ static int decode_coeffs_b32_16bpp(VP9Context *s, int16_t *coef, int n_coeffs,
                                    nnz, scan, nb, band_counts, qmul);
 }
 
-static av_always_inline int decode_coeffs(AVCodecContext *ctx, int is8bitsperpixel)
+static av_always_inline int decode_coeffs(VP9Context *s, int is8bitsperpixel)
 {
-    VP9Context *s = ctx->priv_data;
     VP9Block *b = s->b;
     int row = s->row, col = s->col;
     uint8_t (*p)[6][11] = s->prob.coef[b->tx][0 /* y */][!b->intra];
@@ -2485,14 +2494,14 @@ static av_always_inline int decode_coeffs(AVCodecContext *ctx, int is8bitsperpix
     return total_coeff;
 }
 
-static int decode_coeffs_8bpp(AVCodecContext *ctx)
+static int decode_coeffs_8bpp(VP9Context *s)
 {
-    return decode_coeffs(ctx, 1);
+    return decode_coeffs(s, 1);
 }
 
-static int decode_coeffs_16bpp(AVCodecContext *ctx)
+static int decode_coeffs_16bpp(VP9Context *s)
 {
-    return decode_coeffs(ctx, 0);
+    return decode_coeffs(s, 0);
 }
 
 static av_always_inline int check_intra_mode(VP9Context *s, int mode, uint8_t **a,
@@ -2676,10 +2685,9 @@ static av_always_inline int check_intra_mode(VP9Context *s, int mode, uint8_t **
     return mode;
 }
 
-static av_always_inline void intra_recon(AVCodecContext *ctx, ptrdiff_t y_off,
+static av_always_inline void intra_recon(VP9Context *s, ptrdiff_t y_off,
                                          ptrdiff_t uv_off, int bytesperpixel)
 {
-    VP9Context *s = ctx->priv_data;
     VP9Block *b = s->b;
     int row = s->row, col = s->col;
     int w4 = bwh_tab[1][b->bs][0] << 1, step1d = 1 << b->tx, n;
@@ -2746,14 +2754,14 @@ static av_always_inline void intra_recon(AVCodecContext *ctx, ptrdiff_t y_off,
     }
 }
 
-static void intra_recon_8bpp(AVCodecContext *ctx, ptrdiff_t y_off, ptrdiff_t uv_off)
+static void intra_recon_8bpp(VP9Context *s, ptrdiff_t y_off, ptrdiff_t uv_off)
 {
-    intra_recon(ctx, y_off, uv_off, 1);
+    intra_recon(s, y_off, uv_off, 1);
 }
 
-static void intra_recon_16bpp(AVCodecContext *ctx, ptrdiff_t y_off, ptrdiff_t uv_off)
+static void intra_recon_16bpp(VP9Context *s, ptrdiff_t y_off, ptrdiff_t uv_off)
 {
-    intra_recon(ctx, y_off, uv_off, 2);
+    intra_recon(s, y_off, uv_off, 2);
 }
 
 static av_always_inline void mc_luma_scaled(VP9Context *s, vp9_scaled_mc_func smc,
@@ -2996,23 +3004,22 @@ static av_always_inline void mc_chroma_unscaled(VP9Context *s, vp9_mc_func (*mc)
 #undef BYTES_PER_PIXEL
 #undef SCALED
 
-static av_always_inline void inter_recon(AVCodecContext *ctx, int bytesperpixel)
+static av_always_inline void inter_recon(VP9Context *s, int bytesperpixel)
 {
-    VP9Context *s = ctx->priv_data;
     VP9Block *b = s->b;
     int row = s->row, col = s->col;
 
     if (s->mvscale[b->ref[0]][0] || (b->comp && s->mvscale[b->ref[1]][0])) {
         if (bytesperpixel == 1) {
-            inter_pred_scaled_8bpp(ctx);
+            inter_pred_scaled_8bpp(s);
         } else {
-            inter_pred_scaled_16bpp(ctx);
+            inter_pred_scaled_16bpp(s);
         }
     } else {
         if (bytesperpixel == 1) {
-            inter_pred_8bpp(ctx);
+            inter_pred_8bpp(s);
         } else {
-            inter_pred_16bpp(ctx);
+            inter_pred_16bpp(s);
         }
     }
     if (!b->skip) {
@@ -3062,14 +3069,14 @@ static av_always_inline void inter_recon(AVCodecContext *ctx, int bytesperpixel)
     }
 }
 
-static void inter_recon_8bpp(AVCodecContext *ctx)
+static void inter_recon_8bpp(VP9Context *s)
 {
-    inter_recon(ctx, 1);
+    inter_recon(s, 1);
 }
 
-static void inter_recon_16bpp(AVCodecContext *ctx)
+static void inter_recon_16bpp(VP9Context *s)
 {
-    inter_recon(ctx, 2);
+    inter_recon(s, 2);
 }
 
 static av_always_inline void mask_edges(uint8_t (*mask)[8][4], int ss_h, int ss_v,
@@ -3194,11 +3201,10 @@ static av_always_inline void mask_edges(uint8_t (*mask)[8][4], int ss_h, int ss_
     }
 }
 
-static void decode_b(AVCodecContext *ctx, int row, int col,
+static void decode_b(VP9Context *s, int row, int col,
                      struct VP9Filter *lflvl, ptrdiff_t yoff, ptrdiff_t uvoff,
                      enum BlockLevel bl, enum BlockPartition bp)
 {
-    VP9Context *s = ctx->priv_data;
     VP9Block *b = s->b;
     enum BlockSize bs = bl * 3 + bp;
     int bytesperpixel = s->bytesperpixel;
@@ -3218,7 +3224,7 @@ static void decode_b(AVCodecContext *ctx, int row, int col,
         b->bs = bs;
         b->bl = bl;
         b->bp = bp;
-        decode_mode(ctx);
+        decode_mode(s);
         b->uvtx = b->tx - ((s->ss_h && w4 * 2 == (1 << b->tx)) ||
                            (s->ss_v && h4 * 2 == (1 << b->tx)));
 
@@ -3226,9 +3232,9 @@ static void decode_b(AVCodecContext *ctx, int row, int col,
             int has_coeffs;
 
             if (bytesperpixel == 1) {
-                has_coeffs = decode_coeffs_8bpp(ctx);
+                has_coeffs = decode_coeffs_8bpp(s);
             } else {
-                has_coeffs = decode_coeffs_16bpp(ctx);
+                has_coeffs = decode_coeffs_16bpp(s);
             }
             if (!has_coeffs && b->bs <= BS_8x8 && !b->intra) {
                 b->skip = 1;
@@ -3309,15 +3315,15 @@ static void decode_b(AVCodecContext *ctx, int row, int col,
     }
     if (b->intra) {
         if (s->bpp > 8) {
-            intra_recon_16bpp(ctx, yoff, uvoff);
+            intra_recon_16bpp(s, yoff, uvoff);
         } else {
-            intra_recon_8bpp(ctx, yoff, uvoff);
+            intra_recon_8bpp(s, yoff, uvoff);
         }
     } else {
         if (s->bpp > 8) {
-            inter_recon_16bpp(ctx);
+            inter_recon_16bpp(s);
         } else {
-            inter_recon_8bpp(ctx);
+            inter_recon_8bpp(s);
         }
     }
     if (emu[0]) {
@@ -3366,20 +3372,6 @@ static void decode_b(AVCodecContext *ctx, int row, int col,
                        s->cols & 1 && col + w4 >= s->cols ? s->cols & 7 : 0,
                        s->rows & 1 && row + h4 >= s->rows ? s->rows & 7 : 0,
                        b->uvtx, skip_inter);
-
-        if (!s->filter.lim_lut[lvl]) {
-            int sharp = s->filter.sharpness;
-            int limit = lvl;
-
-            if (sharp > 0) {
-                limit >>= (sharp + 3) >> 2;
-                limit = FFMIN(limit, 9 - sharp);
-            }
-            limit = FFMAX(limit, 1);
-
-            s->filter.lim_lut[lvl] = limit;
-            s->filter.mblim_lut[lvl] = 2 * (lvl + 2) + limit;
-        }
     }
 
     if (s->pass == 2) {
@@ -3393,10 +3385,9 @@ static void decode_b(AVCodecContext *ctx, int row, int col,
     }
 }
 
-static void decode_sb(AVCodecContext *ctx, int row, int col, struct VP9Filter *lflvl,
+static void decode_sb(VP9Context *s, int row, int col, struct VP9Filter *lflvl,
                       ptrdiff_t yoff, ptrdiff_t uvoff, enum BlockLevel bl)
 {
-    VP9Context *s = ctx->priv_data;
     int c = ((s->above_partition_ctx[col] >> (3 - bl)) & 1) |
             (((s->left_partition_ctx[row & 0x7] >> (3 - bl)) & 1) << 1);
     const uint8_t *p = s->keyframe || s->intraonly ? vp9_default_kf_partition_probs[bl][c] :
@@ -3409,35 +3400,35 @@ static void decode_sb(AVCodecContext *ctx, int row, int col, struct VP9Filter *l
 
     if (bl == BL_8X8) {
         bp = vp8_rac_get_tree(&s->c, vp9_partition_tree, p);
-        decode_b(ctx, row, col, lflvl, yoff, uvoff, bl, bp);
+        decode_b(s, row, col, lflvl, yoff, uvoff, bl, bp);
     } else if (col + hbs < s->cols) { // FIXME why not <=?
         if (row + hbs < s->rows) { // FIXME why not <=?
             bp = vp8_rac_get_tree(&s->c, vp9_partition_tree, p);
             switch (bp) {
             case PARTITION_NONE:
-                decode_b(ctx, row, col, lflvl, yoff, uvoff, bl, bp);
+                decode_b(s, row, col, lflvl, yoff, uvoff, bl, bp);
                 break;
             case PARTITION_H:
-                decode_b(ctx, row, col, lflvl, yoff, uvoff, bl, bp);
+                decode_b(s, row, col, lflvl, yoff, uvoff, bl, bp);
                 yoff  += hbs * 8 * y_stride;
                 uvoff += hbs * 8 * uv_stride >> s->ss_v;
-                decode_b(ctx, row + hbs, col, lflvl, yoff, uvoff, bl, bp);
+                decode_b(s, row + hbs, col, lflvl, yoff, uvoff, bl, bp);
                 break;
             case PARTITION_V:
-                decode_b(ctx, row, col, lflvl, yoff, uvoff, bl, bp);
+                decode_b(s, row, col, lflvl, yoff, uvoff, bl, bp);
                 yoff  += hbs * 8 * bytesperpixel;
                 uvoff += hbs * 8 * bytesperpixel >> s->ss_h;
-                decode_b(ctx, row, col + hbs, lflvl, yoff, uvoff, bl, bp);
+                decode_b(s, row, col + hbs, lflvl, yoff, uvoff, bl, bp);
                 break;
             case PARTITION_SPLIT:
-                decode_sb(ctx, row, col, lflvl, yoff, uvoff, bl + 1);
-                decode_sb(ctx, row, col + hbs, lflvl,
+                decode_sb(s, row, col, lflvl, yoff, uvoff, bl + 1);
+                decode_sb(s, row, col + hbs, lflvl,
                           yoff + 8 * hbs * bytesperpixel,
                           uvoff + (8 * hbs * bytesperpixel >> s->ss_h), bl + 1);
                 yoff  += hbs * 8 * y_stride;
                 uvoff += hbs * 8 * uv_stride >> s->ss_v;
-                decode_sb(ctx, row + hbs, col, lflvl, yoff, uvoff, bl + 1);
-                decode_sb(ctx, row + hbs, col + hbs, lflvl,
+                decode_sb(s, row + hbs, col, lflvl, yoff, uvoff, bl + 1);
+                decode_sb(s, row + hbs, col + hbs, lflvl,
                           yoff + 8 * hbs * bytesperpixel,
                           uvoff + (8 * hbs * bytesperpixel >> s->ss_h), bl + 1);
                 break;
@@ -3446,36 +3437,35 @@ static void decode_sb(AVCodecContext *ctx, int row, int col, struct VP9Filter *l
             }
         } else if (vp56_rac_get_prob_branchy(&s->c, p[1])) {
             bp = PARTITION_SPLIT;
-            decode_sb(ctx, row, col, lflvl, yoff, uvoff, bl + 1);
-            decode_sb(ctx, row, col + hbs, lflvl,
+            decode_sb(s, row, col, lflvl, yoff, uvoff, bl + 1);
+            decode_sb(s, row, col + hbs, lflvl,
                       yoff + 8 * hbs * bytesperpixel,
                       uvoff + (8 * hbs * bytesperpixel >> s->ss_h), bl + 1);
         } else {
             bp = PARTITION_H;
-            decode_b(ctx, row, col, lflvl, yoff, uvoff, bl, bp);
+            decode_b(s, row, col, lflvl, yoff, uvoff, bl, bp);
         }
     } else if (row + hbs < s->rows) { // FIXME why not <=?
         if (vp56_rac_get_prob_branchy(&s->c, p[2])) {
             bp = PARTITION_SPLIT;
-            decode_sb(ctx, row, col, lflvl, yoff, uvoff, bl + 1);
+            decode_sb(s, row, col, lflvl, yoff, uvoff, bl + 1);
             yoff  += hbs * 8 * y_stride;
             uvoff += hbs * 8 * uv_stride >> s->ss_v;
-            decode_sb(ctx, row + hbs, col, lflvl, yoff, uvoff, bl + 1);
+            decode_sb(s, row + hbs, col, lflvl, yoff, uvoff, bl + 1);
         } else {
             bp = PARTITION_V;
-            decode_b(ctx, row, col, lflvl, yoff, uvoff, bl, bp);
+            decode_b(s, row, col, lflvl, yoff, uvoff, bl, bp);
         }
     } else {
         bp = PARTITION_SPLIT;
-        decode_sb(ctx, row, col, lflvl, yoff, uvoff, bl + 1);
+        decode_sb(s, row, col, lflvl, yoff, uvoff, bl + 1);
     }
     s->counts.partition[bl][c][bp]++;
 }
 
-static void decode_sb_mem(AVCodecContext *ctx, int row, int col, struct VP9Filter *lflvl,
+static void decode_sb_mem(VP9Context *s, int row, int col, struct VP9Filter *lflvl,
                           ptrdiff_t yoff, ptrdiff_t uvoff, enum BlockLevel bl)
 {
-    VP9Context *s = ctx->priv_data;
     VP9Block *b = s->b;
     ptrdiff_t hbs = 4 >> bl;
     AVFrame *f = s->frames[CUR_FRAME].tf.f;
@@ -3484,39 +3474,39 @@ static void decode_sb_mem(AVCodecContext *ctx, int row, int col, struct VP9Filte
 
     if (bl == BL_8X8) {
         av_assert2(b->bl == BL_8X8);
-        decode_b(ctx, row, col, lflvl, yoff, uvoff, b->bl, b->bp);
+        decode_b(s, row, col, lflvl, yoff, uvoff, b->bl, b->bp);
     } else if (s->b->bl == bl) {
-        decode_b(ctx, row, col, lflvl, yoff, uvoff, b->bl, b->bp);
+        decode_b(s, row, col, lflvl, yoff, uvoff, b->bl, b->bp);
         if (b->bp == PARTITION_H && row + hbs < s->rows) {
             yoff  += hbs * 8 * y_stride;
             uvoff += hbs * 8 * uv_stride >> s->ss_v;
-            decode_b(ctx, row + hbs, col, lflvl, yoff, uvoff, b->bl, b->bp);
+            decode_b(s, row + hbs, col, lflvl, yoff, uvoff, b->bl, b->bp);
         } else if (b->bp == PARTITION_V && col + hbs < s->cols) {
             yoff  += hbs * 8 * bytesperpixel;
             uvoff += hbs * 8 * bytesperpixel >> s->ss_h;
-            decode_b(ctx, row, col + hbs, lflvl, yoff, uvoff, b->bl, b->bp);
+            decode_b(s, row, col + hbs, lflvl, yoff, uvoff, b->bl, b->bp);
         }
     } else {
-        decode_sb_mem(ctx, row, col, lflvl, yoff, uvoff, bl + 1);
+        decode_sb_mem(s, row, col, lflvl, yoff, uvoff, bl + 1);
         if (col + hbs < s->cols) { // FIXME why not <=?
             if (row + hbs < s->rows) {
-                decode_sb_mem(ctx, row, col + hbs, lflvl, yoff + 8 * hbs * bytesperpixel,
+                decode_sb_mem(s, row, col + hbs, lflvl, yoff + 8 * hbs * bytesperpixel,
                               uvoff + (8 * hbs * bytesperpixel >> s->ss_h), bl + 1);
                 yoff  += hbs * 8 * y_stride;
                 uvoff += hbs * 8 * uv_stride >> s->ss_v;
-                decode_sb_mem(ctx, row + hbs, col, lflvl, yoff, uvoff, bl + 1);
-                decode_sb_mem(ctx, row + hbs, col + hbs, lflvl,
+                decode_sb_mem(s, row + hbs, col, lflvl, yoff, uvoff, bl + 1);
+                decode_sb_mem(s, row + hbs, col + hbs, lflvl,
                               yoff + 8 * hbs * bytesperpixel,
                               uvoff + (8 * hbs * bytesperpixel >> s->ss_h), bl + 1);
             } else {
                 yoff  += hbs * 8 * bytesperpixel;
                 uvoff += hbs * 8 * bytesperpixel >> s->ss_h;
-                decode_sb_mem(ctx, row, col + hbs, lflvl, yoff, uvoff, bl + 1);
+                decode_sb_mem(s, row, col + hbs, lflvl, yoff, uvoff, bl + 1);
             }
         } else if (row + hbs < s->rows) {
             yoff  += hbs * 8 * y_stride;
             uvoff += hbs * 8 * uv_stride >> s->ss_v;
-            decode_sb_mem(ctx, row + hbs, col, lflvl, yoff, uvoff, bl + 1);
+            decode_sb_mem(s, row + hbs, col, lflvl, yoff, uvoff, bl + 1);
         }
     }
 }
@@ -3973,6 +3963,16 @@ static av_cold int vp9_decode_free(AVCodecContext *ctx)
         av_frame_free(&s->next_refs[i].f);
     }
     free_buffers(s);
+    if (s->slice_ctx) {
+        for (i = 1; i < ctx->thread_count; i++) {
+            if (s->slice_ctx[i]) {
+                av_freep(&s->slice_ctx[i]->b_base);
+                av_freep(&s->slice_ctx[i]->block_base);
+                av_freep(&s->slice_ctx[i]);
+            }
+        }
+        av_freep(&s->slice_ctx);
+    }
     av_freep(&s->c_b);
     s->c_b_size = 0;
 
@@ -3980,115 +3980,13 @@ static av_cold int vp9_decode_free(AVCodecContext *ctx)
 }
 
 
-static int vp9_decode_frame(AVCodecContext *ctx, void *frame,
-                            int *got_frame, AVPacket *pkt)
+static int decode_tiles(AVCodecContext *ctx, const uint8_t *data, int size)
 {
-    const uint8_t *data = pkt->data;
-    int size = pkt->size;
     VP9Context *s = ctx->priv_data;
-    int res, tile_row, tile_col, i, ref, row, col;
-    int retain_segmap_ref = s->segmentation.enabled && !s->segmentation.update_map;
-    ptrdiff_t yoff, uvoff, ls_y, ls_uv;
-    AVFrame *f;
-    int bytesperpixel;
-
-    if ((res = decode_frame_header(ctx, data, size, &ref)) < 0) {
-        return res;
-    } else if (res == 0) {
-        if (!s->refs[ref].f->data[0]) {
-            av_log(ctx, AV_LOG_ERROR, "Requested reference %d not available\n", ref);
-            return AVERROR_INVALIDDATA;
-        }
-        if ((res = av_frame_ref(frame, s->refs[ref].f)) < 0)
-            return res;
-        ((AVFrame *)frame)->pkt_pts = pkt->pts;
-        ((AVFrame *)frame)->pkt_dts = pkt->dts;
-        for (i = 0; i < 8; i++) {
-            if (s->next_refs[i].f->data[0])
-                ff_thread_release_buffer(ctx, &s->next_refs[i]);
-            if (s->refs[i].f->data[0] &&
-                (res = ff_thread_ref_frame(&s->next_refs[i], &s->refs[i])) < 0)
-                return res;
-        }
-        *got_frame = 1;
-        return pkt->size;
-    }
-    data += res;
-    size -= res;
-
-    if (!retain_segmap_ref) {
-        if (s->frames[REF_FRAME_SEGMAP].tf.f->data[0])
-            vp9_unref_frame(ctx, &s->frames[REF_FRAME_SEGMAP]);
-        if (!s->keyframe && !s->intraonly && !s->errorres && s->frames[CUR_FRAME].tf.f->data[0] &&
-            (res = vp9_ref_frame(ctx, &s->frames[REF_FRAME_SEGMAP], &s->frames[CUR_FRAME])) < 0)
-            return res;
-    }
-    if (s->frames[REF_FRAME_MVPAIR].tf.f->data[0])
-        vp9_unref_frame(ctx, &s->frames[REF_FRAME_MVPAIR]);
-    if (!s->intraonly && !s->keyframe && !s->errorres && s->frames[CUR_FRAME].tf.f->data[0] &&
-        (res = vp9_ref_frame(ctx, &s->frames[REF_FRAME_MVPAIR], &s->frames[CUR_FRAME])) < 0)
-        return res;
-    if (s->frames[CUR_FRAME].tf.f->data[0])
-        vp9_unref_frame(ctx, &s->frames[CUR_FRAME]);
-    if ((res = vp9_alloc_frame(ctx, &s->frames[CUR_FRAME])) < 0)
-        return res;
-    f = s->frames[CUR_FRAME].tf.f;
-    f->key_frame = s->keyframe;
-    f->pict_type = (s->keyframe || s->intraonly) ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_P;
-    ls_y = f->linesize[0];
-    ls_uv =f->linesize[1];
-
-    // ref frame setup
-    for (i = 0; i < 8; i++) {
-        if (s->next_refs[i].f->data[0])
-            ff_thread_release_buffer(ctx, &s->next_refs[i]);
-        if (s->refreshrefmask & (1 << i)) {
-            res = ff_thread_ref_frame(&s->next_refs[i], &s->frames[CUR_FRAME].tf);
-        } else if (s->refs[i].f->data[0]) {
-            res = ff_thread_ref_frame(&s->next_refs[i], &s->refs[i]);
-        }
-        if (res < 0)
-            return res;
-    }
-
-    // main tile decode loop
-    bytesperpixel = s->bytesperpixel;
-    memset(s->above_partition_ctx, 0, s->cols);
-    memset(s->above_skip_ctx, 0, s->cols);
-    if (s->keyframe || s->intraonly) {
-        memset(s->above_mode_ctx, DC_PRED, s->cols * 2);
-    } else {
-        memset(s->above_mode_ctx, NEARESTMV, s->cols);
-    }
-    memset(s->above_y_nnz_ctx, 0, s->sb_cols * 16);
-    memset(s->above_uv_nnz_ctx[0], 0, s->sb_cols * 16 >> s->ss_h);
-    memset(s->above_uv_nnz_ctx[1], 0, s->sb_cols * 16 >> s->ss_h);
-    memset(s->above_segpred_ctx, 0, s->cols);
-    s->pass = s->frames[CUR_FRAME].uses_2pass =
-        ctx->active_thread_type == FF_THREAD_FRAME && s->refreshctx && !s->parallelmode;
-    if ((res = update_block_buffers(ctx)) < 0) {
-        av_log(ctx, AV_LOG_ERROR,
-               "Failed to allocate block buffers\n");
-        return res;
-    }
-    if (s->refreshctx && s->parallelmode) {
-        int j, k, l, m;
-
-        for (i = 0; i < 4; i++) {
-            for (j = 0; j < 2; j++)
-                for (k = 0; k < 2; k++)
-                    for (l = 0; l < 6; l++)
-                        for (m = 0; m < 6; m++)
-                            memcpy(s->prob_ctx[s->framectxid].coef[i][j][k][l][m],
-                                   s->prob.coef[i][j][k][l][m], 3);
-            if (s->txfmmode == i)
-                break;
-        }
-        s->prob_ctx[s->framectxid].p = s->prob.p;
-        ff_thread_finish_setup(ctx);
-    } else if (!s->refreshctx) {
-        ff_thread_finish_setup(ctx);
-    }
+    int tile_row, tile_col, row, col;
+    AVFrame *f = s->frames[CUR_FRAME].tf.f;
+    ptrdiff_t yoff, uvoff, ls_y = f->linesize[0], ls_uv = f->linesize[1];
+    int bytesperpixel = s->bytesperpixel;
 
     do {
         yoff = uvoff = 0;
@@ -4164,10 +4062,10 @@ static int vp9_decode_frame(AVCodecContext *ctx, void *frame,
                         }
 
                         if (s->pass == 2) {
-                            decode_sb_mem(ctx, row, col, lflvl_ptr,
+                            decode_sb_mem(s, row, col, lflvl_ptr,
                                           yoff2, uvoff2, BL_64X64);
                         } else {
-                            decode_sb(ctx, row, col, lflvl_ptr,
+                            decode_sb(s, row, col, lflvl_ptr,
                                       yoff2, uvoff2, BL_64X64);
                         }
                     }
@@ -4218,6 +4116,314 @@ static int vp9_decode_frame(AVCodecContext *ctx, void *frame,
             ff_thread_finish_setup(ctx);
         }
     } while (s->pass++ == 1);
+
+    return 0;
+}
+
+static int decode_tile_col(AVCodecContext *ctx, VP9Context *s, int tile_col)
+{
+    AVFrame *f = s->frames[CUR_FRAME].tf.f;
+    ptrdiff_t yoff, uvoff, ls_y = f->linesize[0], ls_uv = f->linesize[1];
+    int bytesperpixel = s->bytesperpixel, tile_row, row, col, start, end;
+
+    set_tile_offset(&s->tiling.tile_col_start, &s->tiling.tile_col_end,
+                    tile_col, s->tiling.log2_tile_cols, s->sb_cols);
+    start = s->tiling.tile_col_start;
+    end   = FFMIN(s->tiling.tile_col_end, s->cols);
+
+    s->b = s->b_base;
+    s->block = s->block_base;
+    s->uvblock[0] = s->uvblock_base[0];
+    s->uvblock[1] = s->uvblock_base[1];
+    s->eob = s->eob_base;
+    s->uveob[0] = s->uveob_base[0];
+    s->uveob[1] = s->uveob_base[1];
+
+    for (tile_row = 0; tile_row < s->tiling.tile_rows; tile_row++) {
+        set_tile_offset(&s->tiling.tile_row_start, &s->tiling.tile_row_end,
+                        tile_row, s->tiling.log2_tile_rows, s->sb_rows);
+        memcpy(&s->c, &s->c_b[tile_row * s->tiling.tile_cols + tile_col], sizeof(s->c));
+
+        for (row = s->tiling.tile_row_start; row < s->tiling.tile_row_end; row += 8) {
+            struct VP9Filter *lflvl_ptr = s->lflvl + (row >> 3) * s->sb_cols + (start >> 3);
+
+            yoff  = (row >> 3) * ls_y * 64 + start * 8 * bytesperpixel;
+            uvoff = (row >> 3) * (ls_uv * 64 >> s->ss_v) + (start * 8 * bytesperpixel >> s->ss_h);
+
+            memset(s->left_partition_ctx, 0, 8);
+            memset(s->left_skip_ctx, 0, 8);
+            if (s->keyframe || s->intraonly) {
+                memset(s->left_mode_ctx, DC_PRED, 16);
+            } else {
+                memset(s->left_mode_ctx, NEARESTMV, 8);
+            }
+            memset(s->left_y_nnz_ctx, 0, 16);
+            memset(s->left_uv_nnz_ctx, 0, 32);
+            memset(s->left_segpred_ctx, 0, 8);
+
+            for (col = start; col < s->tiling.tile_col_end;
+                 col += 8, yoff += 64 * bytesperpixel,
+                 uvoff += 64 * bytesperpixel >> s->ss_h, lflvl_ptr++) {
+                memset(lflvl_ptr->mask, 0, sizeof(lflvl_ptr->mask));
+                decode_sb(s, row, col, lflvl_ptr, yoff, uvoff, BL_64X64);
+            }
+
+            // backup pre-loopfilter reconstruction data of this tile column
+            // for intra prediction of the next row of sb64s; intra prediction
+            // never looks across a tile column edge, so the columns of other
+            // tiles can be written concurrently
+            if (row + 8 < s->rows) {
+                yoff  = (row >> 3) * ls_y * 64 + 63 * ls_y;
+                uvoff = (row >> 3) * (ls_uv * 64 >> s->ss_v) + ((64 >> s->ss_v) - 1) * ls_uv;
+                memcpy(s->intra_pred_data[0] + start * 8 * bytesperpixel,
+                       f->data[0] + yoff + start * 8 * bytesperpixel,
+                       (end - start) * 8 * bytesperpixel);
+                memcpy(s->intra_pred_data[1] + (start * 8 * bytesperpixel >> s->ss_h),
+                       f->data[1] + uvoff + (start * 8 * bytesperpixel >> s->ss_h),
+                       (end - start) * 8 * bytesperpixel >> s->ss_h);
+                memcpy(s->intra_pred_data[2] + (start * 8 * bytesperpixel >> s->ss_h),
+                       f->data[2] + uvoff + (start * 8 * bytesperpixel >> s->ss_h),
+                       (end - start) * 8 * bytesperpixel >> s->ss_h);
+            }
+
+            ff_thread_report_progress2(ctx, 2 * (row >> 3), 0, 1);
+        }
+    }
+
+    return 0;
+}
+
+static int loopfilter_rows(AVCodecContext *ctx)
+{
+    VP9Context *s = ctx->priv_data;
+    AVFrame *f = s->frames[CUR_FRAME].tf.f;
+    ptrdiff_t yoff, uvoff, ls_y = f->linesize[0], ls_uv = f->linesize[1];
+    int bytesperpixel = s->bytesperpixel, row, col;
+
+    if (!s->filter.level)
+        return 0;
+
+    for (row = 0; row < s->rows; row += 8) {
+        struct VP9Filter *lflvl_ptr = s->lflvl + (row >> 3) * s->sb_cols;
+
+        // wait for all tile columns to finish this sb row
+        ff_thread_await_progress2(ctx, 2 * (row >> 3) + 1, 1, s->tiling.tile_cols);
+
+        yoff  = (row >> 3) * ls_y * 64;
+        uvoff = (row >> 3) * (ls_uv * 64 >> s->ss_v);
+        for (col = 0; col < s->cols;
+             col += 8, yoff += 64 * bytesperpixel,
+             uvoff += 64 * bytesperpixel >> s->ss_h, lflvl_ptr++) {
+            loopfilter_sb(ctx, lflvl_ptr, row, col, yoff, uvoff);
+        }
+    }
+
+    return 0;
+}
+
+static int decode_tiles_mt_job(AVCodecContext *ctx, void *arg, int job, int self_id)
+{
+    VP9Context *s = ctx->priv_data;
+
+    // job 0 is the loopfilter, which trails the tile columns by one sb row.
+    // The slice threads start on jobs 0 to thread_count - 1 at once, so it
+    // gets a thread of its own and never holds up a tile column.
+    if (!job)
+        return loopfilter_rows(ctx);
+    return decode_tile_col(ctx, s->slice_ctx[self_id], job - 1);
+}
+
+static int decode_tiles_mt(AVCodecContext *ctx, const uint8_t *data, int size)
+{
+    VP9Context *s = ctx->priv_data;
+    int tile_row, tile_col, i, j, res;
+
+    for (tile_row = 0; tile_row < s->tiling.tile_rows; tile_row++) {
+        for (tile_col = 0; tile_col < s->tiling.tile_cols; tile_col++) {
+            VP56RangeCoder *c = &s->c_b[tile_row * s->tiling.tile_cols + tile_col];
+            unsigned tile_size;
+
+            if (tile_col == s->tiling.tile_cols - 1 &&
+                tile_row == s->tiling.tile_rows - 1) {
+                tile_size = size;
+            } else {
+                tile_size = AV_RB32(data);
+                data += 4;
+                size -= 4;
+            }
+            if (tile_size > size) {
+                ff_thread_report_progress(&s->frames[CUR_FRAME].tf, INT_MAX, 0);
+                return AVERROR_INVALIDDATA;
+            }
+            ff_vp56_init_range_decoder(c, data, tile_size);
+            if (vp56_rac_get_prob_branchy(c, 128)) { // marker bit
+                ff_thread_report_progress(&s->frames[CUR_FRAME].tf, INT_MAX, 0);
+                return AVERROR_INVALIDDATA;
+            }
+            data += tile_size;
+            size -= tile_size;
+        }
+    }
+
+    // entries[2 * sbrow] counts the tile columns done with that sb row,
+    // entries[2 * sbrow + 1] stays 0 for the loopfilter to wait against
+    if ((res = ff_alloc_entries(ctx, 2 * s->sb_rows)) < 0)
+        return res;
+    ff_reset_entries(ctx);
+
+    if (!s->slice_ctx) {
+        s->slice_ctx = av_mallocz_array(ctx->thread_count, sizeof(*s->slice_ctx));
+        if (!s->slice_ctx)
+            return AVERROR(ENOMEM);
+        s->slice_ctx[0] = s;
+    }
+    for (i = 1; i < ctx->thread_count; i++) {
+        VP9Context *st = s->slice_ctx[i];
+        VP9Block *b_base;
+        int16_t *block_base;
+        int block_alloc_using_2pass;
+
+        if (!st && !(st = s->slice_ctx[i] = av_mallocz(sizeof(VP9Context))))
+            return AVERROR(ENOMEM);
+        b_base                  = st->b_base;
+        block_base              = st->block_base;
+        block_alloc_using_2pass = st->block_alloc_using_2pass;
+        memcpy(st, s, sizeof(VP9Context));
+        st->b_base                  = b_base;
+        st->block_base              = block_base;
+        st->block_alloc_using_2pass = block_alloc_using_2pass;
+        if ((res = update_block_buffers(st)) < 0)
+            return res;
+        memset(&st->counts, 0, sizeof(st->counts));
+    }
+
+    ctx->execute2(ctx, decode_tiles_mt_job, NULL, NULL, s->tiling.tile_cols + 1);
+
+    // merge the symbol counts of all threads for backward adaptation
+    for (i = 1; i < ctx->thread_count; i++) {
+        unsigned *dst = (unsigned *) &s->counts;
+        const unsigned *src = (const unsigned *) &s->slice_ctx[i]->counts;
+
+        for (j = 0; j < sizeof(s->counts) / sizeof(unsigned); j++)
+            dst[j] += src[j];
+    }
+    if (s->refreshctx && !s->parallelmode)
+        adapt_probs(s);
+
+    return 0;
+}
+
+static int vp9_decode_frame(AVCodecContext *ctx, void *frame,
+                            int *got_frame, AVPacket *pkt)
+{
+    const uint8_t *data = pkt->data;
+    int size = pkt->size;
+    VP9Context *s = ctx->priv_data;
+    int res, i, ref;
+    int retain_segmap_ref = s->segmentation.enabled && !s->segmentation.update_map;
+    AVFrame *f;
+
+    if ((res = decode_frame_header(ctx, data, size, &ref)) < 0) {
+        return res;
+    } else if (res == 0) {
+        if (!s->refs[ref].f->data[0]) {
+            av_log(ctx, AV_LOG_ERROR, "Requested reference %d not available\n", ref);
+            return AVERROR_INVALIDDATA;
+        }
+        if ((res = av_frame_ref(frame, s->refs[ref].f)) < 0)
+            return res;
+        ((AVFrame *)frame)->pkt_pts = pkt->pts;
+        ((AVFrame *)frame)->pkt_dts = pkt->dts;
+        for (i = 0; i < 8; i++) {
+            if (s->next_refs[i].f->data[0])
+                ff_thread_release_buffer(ctx, &s->next_refs[i]);
+            if (s->refs[i].f->data[0] &&
+                (res = ff_thread_ref_frame(&s->next_refs[i], &s->refs[i])) < 0)
+                return res;
+        }
+        *got_frame = 1;
+        return pkt->size;
+    }
+    data += res;
+    size -= res;
+
+    if (!retain_segmap_ref) {
+        if (s->frames[REF_FRAME_SEGMAP].tf.f->data[0])
+            vp9_unref_frame(ctx, &s->frames[REF_FRAME_SEGMAP]);
+        if (!s->keyframe && !s->intraonly && !s->errorres && s->frames[CUR_FRAME].tf.f->data[0] &&
+            (res = vp9_ref_frame(ctx, &s->frames[REF_FRAME_SEGMAP], &s->frames[CUR_FRAME])) < 0)
+            return res;
+    }
+    if (s->frames[REF_FRAME_MVPAIR].tf.f->data[0])
+        vp9_unref_frame(ctx, &s->frames[REF_FRAME_MVPAIR]);
+    if (!s->intraonly && !s->keyframe && !s->errorres && s->frames[CUR_FRAME].tf.f->data[0] &&
+        (res = vp9_ref_frame(ctx, &s->frames[REF_FRAME_MVPAIR], &s->frames[CUR_FRAME])) < 0)
+        return res;
+    if (s->frames[CUR_FRAME].tf.f->data[0])
+        vp9_unref_frame(ctx, &s->frames[CUR_FRAME]);
+    if ((res = vp9_alloc_frame(ctx, &s->frames[CUR_FRAME])) < 0)
+        return res;
+    f = s->frames[CUR_FRAME].tf.f;
+    f->key_frame = s->keyframe;
+    f->pict_type = (s->keyframe || s->intraonly) ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_P;
+
+    // ref frame setup
+    for (i = 0; i < 8; i++) {
+        if (s->next_refs[i].f->data[0])
+            ff_thread_release_buffer(ctx, &s->next_refs[i]);
+        if (s->refreshrefmask & (1 << i)) {
+            res = ff_thread_ref_frame(&s->next_refs[i], &s->frames[CUR_FRAME].tf);
+        } else if (s->refs[i].f->data[0]) {
+            res = ff_thread_ref_frame(&s->next_refs[i], &s->refs[i]);
+        }
+        if (res < 0)
+            return res;
+    }
+
+    // main tile decode loop
+    memset(s->above_partition_ctx, 0, s->cols);
+    memset(s->above_skip_ctx, 0, s->cols);
+    if (s->keyframe || s->intraonly) {
+        memset(s->above_mode_ctx, DC_PRED, s->cols * 2);
+    } else {
+        memset(s->above_mode_ctx, NEARESTMV, s->cols);
+    }
+    memset(s->above_y_nnz_ctx, 0, s->sb_cols * 16);
+    memset(s->above_uv_nnz_ctx[0], 0, s->sb_cols * 16 >> s->ss_h);
+    memset(s->above_uv_nnz_ctx[1], 0, s->sb_cols * 16 >> s->ss_h);
+    memset(s->above_segpred_ctx, 0, s->cols);
+    s->pass = s->frames[CUR_FRAME].uses_2pass =
+        ctx->active_thread_type == FF_THREAD_FRAME && s->refreshctx && !s->parallelmode;
+    if ((res = update_block_buffers(s)) < 0) {
+        av_log(ctx, AV_LOG_ERROR,
+               "Failed to allocate block buffers\n");
+        return res;
+    }
+    if (s->refreshctx && s->parallelmode) {
+        int j, k, l, m;
+
+        for (i = 0; i < 4; i++) {
+            for (j = 0; j < 2; j++)
+                for (k = 0; k < 2; k++)
+                    for (l = 0; l < 6; l++)
+                        for (m = 0; m < 6; m++)
+                            memcpy(s->prob_ctx[s->framectxid].coef[i][j][k][l][m],
+                                   s->prob.coef[i][j][k][l][m], 3);
+            if (s->txfmmode == i)
+                break;
+        }
+        s->prob_ctx[s->framectxid].p = s->prob.p;
+        ff_thread_finish_setup(ctx);
+    } else if (!s->refreshctx) {
+        ff_thread_finish_setup(ctx);
+    }
+
+    if (ctx->active_thread_type == FF_THREAD_SLICE && s->tiling.tile_cols > 1)
+        res = decode_tiles_mt(ctx, data, size);
+    else
+        res = decode_tiles(ctx, data, size);
+    if (res < 0)
+        return res;
     ff_thread_report_progress(&s->frames[CUR_FRAME].tf, INT_MAX, 0);
 
     // ref frame setup
@@ -4353,7 +4559,7 @@ AVCodec ff_vp9_decoder = {
     .init                  = vp9_decode_init,
     .close                 = vp9_decode_free,
     .decode                = vp9_decode_frame,
-    .capabilities          = CODEC_CAP_DR1 | CODEC_CAP_FRAME_THREADS,
+    .capabilities          = CODEC_CAP_DR1 | CODEC_CAP_FRAME_THREADS | CODEC_CAP_SLICE_THREADS,
     .flush                 = vp9_decode_flush,
     .init_thread_copy      = ONLY_IF_THREADS_ENABLED(vp9_decode_init_thread_copy),
     .update_thread_context = ONLY_IF_THREADS_ENABLED(vp9_decode_update_thread_context),
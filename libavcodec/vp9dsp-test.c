@@ -0,0 +1,379 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Bit-exactness test of the optimized 8-bit VP9 DSP functions against the C
+ * reference implementation. Run it natively or through the target_exec
+ * wrapper (e.g. qemu-user) when cross compiling.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "vp9.h"
+#include "vp9dsp.h"
+
+#define PIXEL_STRIDE    128
+#define PIXEL_BUF_SIZE  (80 * PIXEL_STRIDE)
+
+static const char *const filter_names[4] = { "smooth", "regular", "sharp", "bilinear" };
+
+static void fill_pixels(AVLFG *lfg, uint8_t *buf, int size)
+{
+    int i;
+
+    /* mix in runs of a single value so the flat paths are taken too */
+    for (i = 0; i < size; i++) {
+        unsigned r = av_lfg_get(lfg);
+        buf[i] = (r & 7) || !i ? r >> 8 : buf[i - 1];
+    }
+}
+
+static int compare_block(const uint8_t *a, const uint8_t *b, ptrdiff_t stride,
+                         int width, int height, const char *name, int idx)
+{
+    int x, y;
+
+    for (y = 0; y < height; y++) {
+        if (memcmp(a + y * stride, b + y * stride, width)) {
+            for (x = 0; x < width; x++) {
+                if (a[y * stride + x] != b[y * stride + x]) {
+                    fprintf(stderr, "%s[%d] %dx%d: mismatch at (%d,%d): "
+                            "expected %d, got %d\n", name, idx, width, height,
+                            x, y, a[y * stride + x], b[y * stride + x]);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static int check_mc(VP9DSPContext *ref, VP9DSPContext *opt,
+                    AVLFG *lfg, uint8_t *bufs[4])
+{
+    uint8_t *dst0 = bufs[1], *dst1 = bufs[2];
+    int size, filter, avg, dx, dy, i;
+
+    for (size = 0; size < 5; size++) {
+        int width = 64 >> size;
+
+        for (filter = 0; filter < 4; filter++) {
+            for (avg = 0; avg < 2; avg++) {
+                for (dx = 0; dx < 2; dx++) {
+                    for (dy = 0; dy < 2; dy++) {
+                        vp9_mc_func ref_fn = ref->mc[size][filter][avg][dx][dy];
+                        vp9_mc_func opt_fn = opt->mc[size][filter][avg][dx][dy];
+
+                        if (ref_fn == opt_fn)
+                            continue;
+                        /* every subpel position, paired with a random one
+                         * in the other direction for hv */
+                        for (i = 0; i < 15; i++) {
+                            /* the subsampled chroma of 4:4:0 and 4:2:2 gives
+                             * blocks of half and twice the width as height */
+                            int height = av_clip((width * 2) >> (av_lfg_get(lfg) % 3), 2, 64);
+                            int mx     = dx ? 1 + i : 0;
+                            int my     = dy ? 1 + (dx ? av_lfg_get(lfg) % 15 : i) : 0;
+                            /* 3 pixels of context above/left of the block */
+                            const uint8_t *src = bufs[0] + 3 * PIXEL_STRIDE + 8 +
+                                                 (av_lfg_get(lfg) & 7);
+
+                            fill_pixels(lfg, bufs[0], PIXEL_BUF_SIZE);
+                            fill_pixels(lfg, dst0, PIXEL_BUF_SIZE);
+                            memcpy(dst1, dst0, PIXEL_BUF_SIZE);
+                            ref_fn(dst0, PIXEL_STRIDE, src, PIXEL_STRIDE, height, mx, my);
+                            opt_fn(dst1, PIXEL_STRIDE, src, PIXEL_STRIDE, height, mx, my);
+                            if (compare_block(dst0, dst1, PIXEL_STRIDE, width, height,
+                                              avg ? "avg" : "put", size)) {
+                                fprintf(stderr, "  %s mx %d my %d\n",
+                                        filter_names[filter], mx, my);
+                                return 1;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static int check_intra_pred(VP9DSPContext *ref, VP9DSPContext *opt,
+                            AVLFG *lfg, uint8_t *bufs[4])
+{
+    /* top holds top[-1] to top[2 * size - 1], both are aligned to the
+     * transform size like in the decoder */
+    const uint8_t *top  = bufs[0] + 64;
+    const uint8_t *left = bufs[0] + 256;
+    uint8_t *dst0 = bufs[1], *dst1 = bufs[2];
+    int tx, mode, i;
+
+    for (tx = 0; tx < N_TXFM_SIZES; tx++) {
+        int size = 4 << tx;
+
+        for (mode = 0; mode < N_INTRA_PRED_MODES; mode++) {
+            if (ref->intra_pred[tx][mode] == opt->intra_pred[tx][mode])
+                continue;
+            for (i = 0; i < 8; i++) {
+                fill_pixels(lfg, bufs[0], PIXEL_BUF_SIZE);
+                memset(dst0, 0, PIXEL_BUF_SIZE);
+                memset(dst1, 0, PIXEL_BUF_SIZE);
+                ref->intra_pred[tx][mode](dst0, PIXEL_STRIDE, left, top);
+                opt->intra_pred[tx][mode](dst1, PIXEL_STRIDE, left, top);
+                if (compare_block(dst0, dst1, PIXEL_STRIDE, size, size,
+                                  "intra_pred", mode))
+                    return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static double tx_basis(int adst, int size, int k, int n)
+{
+    if (!adst)
+        return cos(M_PI * (2 * n + 1) * k / (2.0 * size)) *
+               sqrt(2.0 / size) * (k ? 1.0 : M_SQRT1_2);
+    if (size == 4)
+        return sin(M_PI * (n + 1) * (2 * k + 1) / 9.0) * 2.0 / 3.0;
+    return sin(M_PI * (2 * n + 1) * (2 * k + 1) / (4.0 * size)) * sqrt(2.0 / size);
+}
+
+/* Coefficients of a random residual, so that the optimized versions see
+ * the range of a real stream: arbitrary int16 values would overflow the
+ * 16-bit intermediates some of them use. Only the top left sub x sub
+ * coefficients are kept, as the decoder does for a small eob. */
+static void fill_coeffs(AVLFG *lfg, int16_t *block, int tx, int txtp, int sub)
+{
+    int size = 4 << (tx & 3);
+    /* the row index of the block is the horizontal frequency */
+    int adst_h = tx < TX_32X32 && (txtp == DCT_ADST || txtp == ADST_ADST);
+    int adst_v = tx < TX_32X32 && (txtp == ADST_DCT || txtp == ADST_ADST);
+    double scale = tx == TX_32X32 ? 4.0 : 8.0;
+    int amp = 1 + av_lfg_get(lfg) % 255;
+    int16_t res[32][32];
+    int x, y, r, c;
+
+    memset(block, 0, size * size * sizeof(*block));
+    if (tx == N_TXFM_SIZES) {
+        /* the lossless WHT, scaled by the 4 of UNIT_QUANT_FACTOR */
+        for (r = 0; r < sub; r++)
+            for (c = 0; c < sub; c++)
+                block[r * size + c] = (int)(av_lfg_get(lfg) % (8 * amp + 1)) - 4 * amp;
+        return;
+    }
+
+    for (y = 0; y < size; y++)
+        for (x = 0; x < size; x++)
+            res[y][x] = (int)(av_lfg_get(lfg) % (2 * amp + 1)) - amp;
+
+    for (r = 0; r < sub; r++) {
+        for (c = 0; c < sub; c++) {
+            double v = 0.0;
+
+            for (y = 0; y < size; y++)
+                for (x = 0; x < size; x++)
+                    v += res[y][x] * tx_basis(adst_h, size, r, x) *
+                                     tx_basis(adst_v, size, c, y);
+            block[r * size + c] = lrint(v * scale);
+        }
+    }
+}
+
+static int check_itxfm(VP9DSPContext *ref, VP9DSPContext *opt,
+                       AVLFG *lfg, uint8_t *bufs[4])
+{
+    /* largest square of nonzero coefficients and the eob it comes with,
+     * matching the shortcuts the optimized idct_idct versions take */
+    static const int sub_eob[N_TXFM_SIZES + 1][4][2] = {
+        { { 1, 1 }, { 2,  4 }, {  4,  16 }, {  4,   16 } },
+        { { 1, 1 }, { 2,  3 }, {  4,  12 }, {  8,   64 } },
+        { { 1, 1 }, { 4, 10 }, {  8,  38 }, { 16,  256 } },
+        { { 1, 1 }, { 8, 34 }, { 16, 135 }, { 32, 1024 } },
+        { { 1, 1 }, { 2,  4 }, {  4,  16 }, {  4,   16 } },
+    };
+    int16_t *coeffs0 = (int16_t *)bufs[3];
+    int16_t *coeffs1 = coeffs0 + 32 * 32;
+    uint8_t *dst0 = bufs[1], *dst1 = bufs[2];
+    int tx, txtp, i;
+
+    for (tx = 0; tx <= N_TXFM_SIZES; tx++) {
+        int size = 4 << (tx & 3);
+
+        for (txtp = 0; txtp < N_TXFM_TYPES; txtp++) {
+            if (ref->itxfm_add[tx][txtp] == opt->itxfm_add[tx][txtp])
+                continue;
+            for (i = 0; i < 32; i++) {
+                int sub = sub_eob[tx][i & 3][0];
+                /* eob only selects a shortcut for idct_idct */
+                int eob = txtp == DCT_DCT ? sub_eob[tx][i & 3][1] : size * size;
+
+                fill_coeffs(lfg, coeffs0, tx, txtp, sub);
+                memcpy(coeffs1, coeffs0, size * size * sizeof(*coeffs0));
+                fill_pixels(lfg, dst0, PIXEL_BUF_SIZE);
+                memcpy(dst1, dst0, PIXEL_BUF_SIZE);
+                ref->itxfm_add[tx][txtp](dst0, PIXEL_STRIDE, coeffs0, eob);
+                opt->itxfm_add[tx][txtp](dst1, PIXEL_STRIDE, coeffs1, eob);
+                if (compare_block(dst0, dst1, PIXEL_STRIDE, size, size,
+                                  "itxfm_add", tx * N_TXFM_TYPES + txtp)) {
+                    fprintf(stderr, "  eob %d\n", eob);
+                    return 1;
+                }
+                /* the decoder relies on the block being cleared */
+                if (compare_block((uint8_t *)coeffs0, (uint8_t *)coeffs1, 0,
+                                  size * size * sizeof(*coeffs0), 1,
+                                  "itxfm_add block", tx * N_TXFM_TYPES + txtp))
+                    return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* 16x16 block around an edge in the middle, smooth enough for the flat and
+ * hev decisions to go every way */
+static void fill_loop_filter(AVLFG *lfg, uint8_t *buf, int dir)
+{
+    int base  = 32 + av_lfg_get(lfg) % 192;
+    int slope = av_lfg_get(lfg) & 1 ? (int)(av_lfg_get(lfg) % 5) - 2 : 0;
+    int step  = av_lfg_get(lfg) & 1 ? (int)(av_lfg_get(lfg) % 41) - 20 : 0;
+    int noise = av_lfg_get(lfg) % 4;
+    int x, y;
+
+    for (y = 0; y < 16; y++) {
+        for (x = 0; x < 16; x++) {
+            int a = dir ? y : x;
+            int v = base + slope * a + (a >= 8 ? step : 0);
+            if (noise)
+                v += (int)(av_lfg_get(lfg) % (2 * noise + 1)) - noise;
+            buf[y * PIXEL_STRIDE + x] = av_clip_uint8(v);
+        }
+    }
+}
+
+/* the limits the decoder derives from a filter level and sharpness */
+static void random_limits(AVLFG *lfg, int *E, int *I, int *H)
+{
+    int level = 1 + av_lfg_get(lfg) % 63;
+    int sharp = av_lfg_get(lfg) % 8;
+    int limit = level;
+
+    if (sharp > 0) {
+        limit >>= (sharp + 3) >> 2;
+        limit = FFMIN(limit, 9 - sharp);
+    }
+    limit = FFMAX(limit, 1);
+
+    *E = 2 * (level + 2) + limit;
+    *I = limit;
+    *H = level >> 4;
+}
+
+static int check_loop_filter(VP9DSPContext *ref, VP9DSPContext *opt,
+                             AVLFG *lfg, uint8_t *bufs[4])
+{
+    int wd, dir, i;
+
+    /* wd 0 to 2 are loop_filter_8, 3 is loop_filter_16, 4 to 7 the mix2
+     * combinations */
+    for (wd = 0; wd < 8; wd++) {
+        for (dir = 0; dir < 2; dir++) {
+            int offset = dir ? 8 * PIXEL_STRIDE : 8;
+            int length = wd < 3 ? 8 : 16;
+            void (*ref_fn)(uint8_t *dst, ptrdiff_t stride, int E, int I, int H);
+            void (*opt_fn)(uint8_t *dst, ptrdiff_t stride, int E, int I, int H);
+
+            if (wd < 3) {
+                ref_fn = ref->loop_filter_8[wd][dir];
+                opt_fn = opt->loop_filter_8[wd][dir];
+            } else if (wd == 3) {
+                ref_fn = ref->loop_filter_16[dir];
+                opt_fn = opt->loop_filter_16[dir];
+            } else {
+                ref_fn = ref->loop_filter_mix2[(wd - 4) >> 1][wd & 1][dir];
+                opt_fn = opt->loop_filter_mix2[(wd - 4) >> 1][wd & 1][dir];
+            }
+            if (ref_fn == opt_fn)
+                continue;
+
+            for (i = 0; i < 256; i++) {
+                int E, I, H;
+
+                random_limits(lfg, &E, &I, &H);
+                if (wd >= 4) {
+                    int E2, I2, H2;
+                    random_limits(lfg, &E2, &I2, &H2);
+                    E |= E2 << 8;
+                    I |= I2 << 8;
+                    H |= H2 << 8;
+                }
+                fill_loop_filter(lfg, bufs[1], dir);
+                memcpy(bufs[2], bufs[1], 16 * PIXEL_STRIDE);
+                ref_fn(bufs[1] + offset, PIXEL_STRIDE, E, I, H);
+                opt_fn(bufs[2] + offset, PIXEL_STRIDE, E, I, H);
+                if (compare_block(bufs[1], bufs[2], PIXEL_STRIDE, 16, 16,
+                                  "loop_filter", wd * 2 + dir)) {
+                    fprintf(stderr, "  length %d E %x I %x H %x\n", length, E, I, H);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    VP9DSPContext ref, opt;
+    AVLFG lfg;
+    uint8_t *bufs[4];
+    int i, ret = 0;
+
+    for (i = 0; i < 4; i++)
+        bufs[i] = av_malloc(PIXEL_BUF_SIZE);
+    if (!bufs[0] || !bufs[1] || !bufs[2] || !bufs[3]) {
+        ret = 2;
+        goto end;
+    }
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    av_force_cpu_flags(0);
+    ff_vp9dsp_init(&ref, 8);
+    av_force_cpu_flags(-1);
+    ff_vp9dsp_init(&opt, 8);
+
+    ret |= check_mc(&ref, &opt, &lfg, bufs);
+    ret |= check_intra_pred(&ref, &opt, &lfg, bufs);
+    ret |= check_itxfm(&ref, &opt, &lfg, bufs);
+    ret |= check_loop_filter(&ref, &opt, &lfg, bufs);
+
+end:
+    for (i = 0; i < 4; i++)
+        av_free(bufs[i]);
+    return ret;
+}
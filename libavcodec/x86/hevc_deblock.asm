@@ -31,6 +31,7 @@ cextern pw_1023
 pw_pixel_max_12: times 8 dw ((1 << 12)-1)
 pw_m2:           times 8 dw -2
 pd_1 :           times 4 dd  1
+bs_limit:        dw 3, 3, 3, 3, 0, 0, 0, 0
 
 cextern pw_4
 cextern pw_8
@@ -721,6 +722,48 @@ LOOP_FILTER_CHROMA
 INIT_XMM avx
 LOOP_FILTER_CHROMA
 
+;-----------------------------------------------------------------------------
+; void ff_hevc_deblocking_bs(uint8_t *bs, ptrdiff_t stride, const DeblockMotion *p,
+;                            const DeblockMotion *q, int n);
+;-----------------------------------------------------------------------------
+; A segment matches if all words of |p - q| are below bs_limit, i.e. the
+; vectors are less than 4 apart and the refs are equal, either as they are
+; or with the two vectors and refs of q swapped.
+INIT_XMM sse2
+cglobal hevc_deblocking_bs, 5, 6, 6, bs, stride, p, q, n, dst
+    mov            dstq, bsq        ; bs holds the result byte below
+    pxor             m4, m4
+    mova             m5, [bs_limit]
+.loop:
+    mova             m0, [pq]
+    mova             m1, [qq]
+    pshufd           m2, m1, q2301
+    mova             m3, m0
+    psubsw           m0, m1
+    psubsw           m3, m2
+    pxor             m1, m1
+    pxor             m2, m2
+    psubsw           m1, m0
+    psubsw           m2, m3
+    pmaxsw           m0, m1         ; |p - q|, saturated
+    pmaxsw           m3, m2
+    pcmpgtw          m0, m5
+    pcmpgtw          m3, m5
+    packsswb         m0, m3         ; mismatches as is in the low, swapped in the high half
+    psadbw           m0, m4
+    pshufd           m1, m0, q0032
+    pminsw           m0, m1         ; nonzero if neither order matches
+    pcmpgtw          m0, m4
+    movd            bsd, m0
+    and             bsd, 1
+    mov          [dstq], bsb
+    add              pq, 16
+    add              qq, 16
+    add            dstq, strideq
+    dec              nd
+    jg .loop
+    RET
+
 %if ARCH_X86_64
 %macro LOOP_FILTER_LUMA 0
 ;-----------------------------------------------------------------------------
@@ -58,6 +58,9 @@ LFL_FUNCS(uint8_t,   8, avx)
 LFL_FUNCS(uint8_t,  10, avx)
 LFL_FUNCS(uint8_t,  12, avx)
 
+void ff_hevc_deblocking_bs_sse2(uint8_t *bs, ptrdiff_t stride, const DeblockMotion *p,
+                                const DeblockMotion *q, int n);
+
 #define IDCT_FUNCS(W, opt) \
 void ff_hevc_idct##W##_dc_8_##opt(int16_t *coeffs); \
 void ff_hevc_idct##W##_dc_10_##opt(int16_t *coeffs); \
@@ -701,6 +704,9 @@ void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
 {
     int cpu_flags = av_get_cpu_flags();
 
+    if (EXTERNAL_SSE2(cpu_flags))
+        c->deblocking_bs = ff_hevc_deblocking_bs_sse2;
+
     if (bit_depth == 8) {
         if (EXTERNAL_MMXEXT(cpu_flags)) {
             c->idct_dc[0] = ff_hevc_idct4x4_dc_8_mmxext;
@@ -355,6 +355,11 @@ static int config_props(AVFilterLink *outlink)
             *s = sws_alloc_context();
             if (!*s)
                 return AVERROR(ENOMEM);
+            /* nb_threads is 0 ("auto") when the graph has no thread pool of
+             * its own, do not let swscale start one behind the user's back */
+            av_opt_set_int(*s, "threads",
+                           ctx->graph->thread_type && ctx->graph->nb_threads ?
+                           ctx->graph->nb_threads : 1, 0);
 
             if (scale->opts) {
                 AVDictionaryEntry *e = NULL;
@@ -0,0 +1,94 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/aarch64/cpu.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#define SCALE_FUNC(bits, filtersize) \
+void ff_hscale_8_to_##bits##_##filtersize##_neon(SwsContext *c, int16_t *dst, int dstW, \
+                                                 const uint8_t *src, const int16_t *filter, \
+                                                 const int32_t *filterPos, int filterSize)
+#define SCALE_FUNCS(filtersize) \
+SCALE_FUNC(15, filtersize); \
+SCALE_FUNC(19, filtersize)
+
+SCALE_FUNCS(4);
+SCALE_FUNCS(8);
+SCALE_FUNCS(X);
+
+void ff_yuv2planeX_8_neon(const int16_t *filter, int filterSize,
+                          const int16_t **src, uint8_t *dest, int dstW,
+                          const uint8_t *dither, int offset);
+void ff_yuv2nv12cX_neon(const int16_t *filter, int filterSize,
+                        const int16_t **u, const int16_t **v,
+                        uint8_t *dest, int dstW, const uint8_t *dither);
+void ff_yuv2nv21cX_neon(const int16_t *filter, int filterSize,
+                        const int16_t **u, const int16_t **v,
+                        uint8_t *dest, int dstW, const uint8_t *dither);
+
+static void yuv2nv12cX_neon(SwsContext *c, const int16_t *chrFilter, int chrFilterSize,
+                            const int16_t **chrUSrc, const int16_t **chrVSrc,
+                            uint8_t *dest, int chrDstW)
+{
+    ff_yuv2nv12cX_neon(chrFilter, chrFilterSize, chrUSrc, chrVSrc,
+                       dest, chrDstW, c->chrDither8);
+}
+
+static void yuv2nv21cX_neon(SwsContext *c, const int16_t *chrFilter, int chrFilterSize,
+                            const int16_t **chrUSrc, const int16_t **chrVSrc,
+                            uint8_t *dest, int chrDstW)
+{
+    ff_yuv2nv21cX_neon(chrFilter, chrFilterSize, chrUSrc, chrVSrc,
+                       dest, chrDstW, c->chrDither8);
+}
+
+/* initFilter() pads the horizontal filters to a multiple of 4 taps
+ * when NEON is available */
+#define ASSIGN_SCALE_FUNC(hscalefn, filtersize) do {                        \
+    if (c->srcBpc == 8)                                                     \
+        hscalefn = c->dstBpc <= 14 ? ff_hscale_8_to_15_ ## filtersize ## _neon : \
+                                     ff_hscale_8_to_19_ ## filtersize ## _neon; \
+} while (0)
+
+#define ASSIGN_NEON_SCALE_FUNC(hscalefn, filtersize)            \
+    switch (filtersize) {                                       \
+    case 4:  ASSIGN_SCALE_FUNC(hscalefn, 4); break;             \
+    case 8:  ASSIGN_SCALE_FUNC(hscalefn, 8); break;             \
+    default: ASSIGN_SCALE_FUNC(hscalefn, X); break;             \
+    }
+
+av_cold void ff_sws_init_swscale_aarch64(SwsContext *c)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (have_neon(cpu_flags)) {
+        if (!(c->hLumFilterSize & 3))
+            ASSIGN_NEON_SCALE_FUNC(c->hyScale, c->hLumFilterSize);
+        if (!(c->hChrFilterSize & 3))
+            ASSIGN_NEON_SCALE_FUNC(c->hcScale, c->hChrFilterSize);
+        if (c->dstBpc == 8)
+            c->yuv2planeX = ff_yuv2planeX_8_neon;
+        if (c->dstFormat == AV_PIX_FMT_NV12)
+            c->yuv2nv12cX = yuv2nv12cX_neon;
+        else if (c->dstFormat == AV_PIX_FMT_NV21)
+            c->yuv2nv12cX = yuv2nv21cX_neon;
+    }
+}
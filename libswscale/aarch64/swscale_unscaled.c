@@ -0,0 +1,42 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/aarch64/cpu.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+static void get_unscaled_swscale_neon(SwsContext *c)
+{
+    /* under the same conditions as the C yuv2rgb converters of YUV420P */
+    if ((c->srcFormat == AV_PIX_FMT_NV12 || c->srcFormat == AV_PIX_FMT_NV21) &&
+        !(c->flags & (SWS_ACCURATE_RND | SWS_BITEXACT)) &&
+        (c->dither == SWS_DITHER_BAYER || c->dither == SWS_DITHER_AUTO) &&
+        !(c->dstH & 1)) {
+        SwsFunc yuv2rgb = ff_yuv2rgb_init_aarch64(c);
+        if (yuv2rgb)
+            c->swscale = yuv2rgb;
+    }
+}
+
+void ff_get_unscaled_swscale_aarch64(SwsContext *c)
+{
+    int cpu_flags = av_get_cpu_flags();
+    if (have_neon(cpu_flags))
+        get_unscaled_swscale_neon(c);
+}
@@ -0,0 +1,193 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/aarch64/cpu.h"
+#include "libavutil/mem.h"
+#include "libswscale/rgb2rgb.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#define YUV2RGB_FUNC(src, fmt)                                                  \
+void ff_ ## src ## _to_ ## fmt ## _neon(uint8_t *dst, int dst_stride,           \
+                                        const uint8_t *y, int y_stride,         \
+                                        const uint8_t *u, const uint8_t *v,     \
+                                        int width, const int32_t coeffs[8],     \
+                                        const uint8_t dither[48])
+#define YUV2RGB_FUNCS(src)                                                      \
+YUV2RGB_FUNC(src, rgb24);                                                       \
+YUV2RGB_FUNC(src, bgr24);                                                       \
+YUV2RGB_FUNC(src, argb);                                                        \
+YUV2RGB_FUNC(src, rgba);                                                        \
+YUV2RGB_FUNC(src, abgr);                                                        \
+YUV2RGB_FUNC(src, bgra);                                                        \
+YUV2RGB_FUNC(src, rgb565);                                                      \
+YUV2RGB_FUNC(src, bgr565)
+
+YUV2RGB_FUNCS(yuv420p);
+YUV2RGB_FUNCS(nv12);
+YUV2RGB_FUNCS(nv21);
+
+/* The C converters for the interleaved chroma of NV12 and NV21. */
+static int yuv2rgb_nv12_c(SwsContext *c, const uint8_t *src[], int srcStride[],
+                          int srcSliceY, int srcSliceH,
+                          uint8_t *dst[], int dstStride[])
+{
+    int chrW = (c->srcW + 1) / 2, chrH = (srcSliceH + 1) / 2;
+    uint8_t *buf = av_malloc(2 * chrW * chrH);
+    uint8_t *u = buf, *v = buf + chrW * chrH;
+    const uint8_t *planes[3] = { src[0], u, v };
+    int strides[3] = { srcStride[0], chrW, chrW };
+    int ret;
+
+    if (!buf)
+        return 0;
+    if (c->srcFormat == AV_PIX_FMT_NV12)
+        deinterleaveBytes(src[1], u, v, chrW, chrH, srcStride[1], chrW, chrW);
+    else
+        deinterleaveBytes(src[1], v, u, chrW, chrH, srcStride[1], chrW, chrW);
+    ret = ff_yuv2rgb_get_c_func_ptr(c)(c, planes, strides, srcSliceY, srcSliceH,
+                                       dst, dstStride);
+    av_free(buf);
+    return ret;
+}
+
+/* Like the C yuv2rgb functions, which convert pairs of lines in blocks of
+ * 8 pixels and then the remaining pairs of pixels of the 24 and 32 bpp
+ * formats. */
+static av_always_inline int yuv2rgb_neon(SwsContext *c, const uint8_t *src[],
+                                         int srcStride[], int srcSliceY,
+                                         int srcSliceH, uint8_t *dst[],
+                                         int dstStride[], int nv12, int bpp,
+                                         void (*convert)(uint8_t *dst, int dst_stride,
+                                                         const uint8_t *y, int y_stride,
+                                                         const uint8_t *u, const uint8_t *v,
+                                                         int width, const int32_t coeffs[8],
+                                                         const uint8_t dither[48]))
+{
+    const int32_t *coeffs = c->yuv2rgb_table_coeffs;
+    const int width = c->dstW & ~7;
+    const int tail  = bpp != 16 ? c->dstW & 6 : 0;
+    uint8_t dither[48];
+    int y;
+
+    /* sws_setColorspaceDetails() may have made the tables non-linear since */
+    if (!coeffs[YUV2RGB_CY_IDX]) {
+        if (nv12)
+            return yuv2rgb_nv12_c(c, src, srcStride, srcSliceY, srcSliceH,
+                                  dst, dstStride);
+        return ff_yuv2rgb_get_c_func_ptr(c)(c, src, srcStride, srcSliceY,
+                                            srcSliceH, dst, dstStride);
+    }
+
+    /* the C code dithers as if every slice started at an even line */
+    memcpy(dither,      ff_dither_2x2_8[0], 8);
+    memcpy(dither +  8, ff_dither_2x2_4[0], 8);
+    memcpy(dither + 16, ff_dither_2x2_8[1], 8);
+    memcpy(dither + 24, ff_dither_2x2_8[1], 8);
+    memcpy(dither + 32, ff_dither_2x2_4[1], 8);
+    memcpy(dither + 40, ff_dither_2x2_8[2], 8);
+
+    for (y = 0; y < srcSliceH; y += 2) {
+        uint8_t *d        = dst[0] + (y + srcSliceY) * dstStride[0];
+        const uint8_t *py = src[0] +  y       * srcStride[0];
+        const uint8_t *pu = src[1] + (y >> 1) * srcStride[1];
+        const uint8_t *pv = nv12 ? NULL : src[2] + (y >> 1) * srcStride[2];
+
+        if (width)
+            convert(d, dstStride[0], py, srcStride[0], pu, pv,
+                    width, coeffs, dither);
+        if (tail) {
+            uint8_t ybuf[16] = { 0 }, ubuf[8] = { 0 }, vbuf[4] = { 0 };
+            uint8_t dbuf[2 * 8 * 4];
+
+            memcpy(ybuf,     py + width, tail);
+            memcpy(ybuf + 8, py + width + srcStride[0], tail);
+            if (nv12) {
+                memcpy(ubuf, pu + width, tail);
+            } else {
+                memcpy(ubuf, pu + width / 2, tail / 2);
+                memcpy(vbuf, pv + width / 2, tail / 2);
+            }
+            convert(dbuf, 32, ybuf, 8, ubuf, vbuf, 8, coeffs, dither);
+            memcpy(d + width * bpp / 8, dbuf, tail * bpp / 8);
+            memcpy(d + width * bpp / 8 + dstStride[0], dbuf + 32, tail * bpp / 8);
+        }
+    }
+
+    return srcSliceH;
+}
+
+#define YUV2RGB_WRAPPER(name, fmt, nv12, bpp)                                   \
+static int name ## _to_ ## fmt ## _neon_wrapper(SwsContext *c,                  \
+                                                const uint8_t *src[],           \
+                                                int srcStride[], int srcSliceY, \
+                                                int srcSliceH, uint8_t *dst[],  \
+                                                int dstStride[])                \
+{                                                                               \
+    return yuv2rgb_neon(c, src, srcStride, srcSliceY, srcSliceH,                \
+                        dst, dstStride, nv12, bpp,                              \
+                        ff_ ## name ## _to_ ## fmt ## _neon);                   \
+}
+
+#define YUV2RGB_WRAPPERS(name, nv12)                                            \
+YUV2RGB_WRAPPER(name, rgb24,  nv12, 24)                                         \
+YUV2RGB_WRAPPER(name, bgr24,  nv12, 24)                                         \
+YUV2RGB_WRAPPER(name, argb,   nv12, 32)                                         \
+YUV2RGB_WRAPPER(name, rgba,   nv12, 32)                                         \
+YUV2RGB_WRAPPER(name, abgr,   nv12, 32)                                         \
+YUV2RGB_WRAPPER(name, bgra,   nv12, 32)                                         \
+YUV2RGB_WRAPPER(name, rgb565, nv12, 16)                                         \
+YUV2RGB_WRAPPER(name, bgr565, nv12, 16)
+
+YUV2RGB_WRAPPERS(yuv420p, 0)
+YUV2RGB_WRAPPERS(nv12,    1)
+YUV2RGB_WRAPPERS(nv21,    1)
+
+#define SELECT_WRAPPER(name)                                                    \
+    switch (c->dstFormat) {                                                     \
+    case AV_PIX_FMT_RGB24:  return name ## _to_rgb24_neon_wrapper;              \
+    case AV_PIX_FMT_BGR24:  return name ## _to_bgr24_neon_wrapper;              \
+    case AV_PIX_FMT_ARGB:   return name ## _to_argb_neon_wrapper;               \
+    case AV_PIX_FMT_RGBA:   return name ## _to_rgba_neon_wrapper;               \
+    case AV_PIX_FMT_ABGR:   return name ## _to_abgr_neon_wrapper;               \
+    case AV_PIX_FMT_BGRA:   return name ## _to_bgra_neon_wrapper;               \
+    case AV_PIX_FMT_RGB565: return name ## _to_rgb565_neon_wrapper;             \
+    case AV_PIX_FMT_BGR565: return name ## _to_bgr565_neon_wrapper;             \
+    default:                return NULL;                                        \
+    }
+
+/* Also used by the unscaled converters for NV12 and NV21, which have no C
+ * yuv2rgb counterpart. */
+av_cold SwsFunc ff_yuv2rgb_init_aarch64(SwsContext *c)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (!have_neon(cpu_flags) || !c->yuv2rgb_table_coeffs[YUV2RGB_CY_IDX])
+        return NULL;
+
+    switch (c->srcFormat) {
+    case AV_PIX_FMT_YUV420P: SELECT_WRAPPER(yuv420p)
+    case AV_PIX_FMT_NV12:    SELECT_WRAPPER(nv12)
+    case AV_PIX_FMT_NV21:    SELECT_WRAPPER(nv21)
+    default:                 return NULL;
+    }
+}
@@ -18,7 +18,10 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <string.h>
+
 #include "config.h"
+#include "libswscale/rgb2rgb.h"
 #include "libswscale/swscale.h"
 #include "libswscale/swscale_internal.h"
 #include "libavutil/arm/cpu.h"
@@ -44,7 +47,7 @@ static int rgbx_to_nv12_neon_32_wrapper(SwsContext *context, const uint8_t *src[
             dstStride[0], dstStride[1], srcStride[0],
             context->input_rgb2yuv_table);
 
-    return 0;
+    return srcSliceH;
 }
 
 static int rgbx_to_nv12_neon_16_wrapper(SwsContext *context, const uint8_t *src[],
@@ -58,17 +61,140 @@ static int rgbx_to_nv12_neon_16_wrapper(SwsContext *context, const uint8_t *src[
             dstStride[0], dstStride[1], srcStride[0],
             context->input_rgb2yuv_table);
 
-    return 0;
+    return srcSliceH;
+}
+
+void ff_interleave_bytes_neon(const uint8_t *src1, const uint8_t *src2,
+                              uint8_t *dst, int width, int height,
+                              int src1Stride, int src2Stride, int dstStride);
+void ff_deinterleave_bytes_neon(const uint8_t *src, uint8_t *dst1, uint8_t *dst2,
+                                int width, int height, int srcStride,
+                                int dst1Stride, int dst2Stride);
+void ff_yuyvtoyuv420_neon(uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
+                          const uint8_t *src, int width, int height,
+                          int lumStride, int chromStride, int srcStride);
+void ff_uyvytoyuv420_neon(uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
+                          const uint8_t *src, int width, int height,
+                          int lumStride, int chromStride, int srcStride);
+
+static void copy_plane(const uint8_t *src, int srcStride, int srcSliceY,
+                       int srcSliceH, int width, uint8_t *dst, int dstStride)
+{
+    int i;
+
+    dst += dstStride * srcSliceY;
+    for (i = 0; i < srcSliceH; i++) {
+        memcpy(dst, src, width);
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+static int planar_to_nv12_neon_wrapper(SwsContext *c, const uint8_t *src[],
+                                       int srcStride[], int srcSliceY,
+                                       int srcSliceH, uint8_t *dstParam[],
+                                       int dstStride[])
+{
+    uint8_t *dst = dstParam[1] + dstStride[1] * srcSliceY / 2;
+    int u = c->dstFormat == AV_PIX_FMT_NV12 ? 1 : 2;
+    int v = 3 - u;
+    int width = c->srcW / 2, width16 = width & ~15;
+
+    copy_plane(src[0], srcStride[0], srcSliceY, srcSliceH, c->srcW,
+               dstParam[0], dstStride[0]);
+
+    if (width16)
+        ff_interleave_bytes_neon(src[u], src[v], dst, width16, srcSliceH / 2,
+                                 srcStride[u], srcStride[v], dstStride[1]);
+    if (width > width16)
+        interleaveBytes(src[u] + width16, src[v] + width16, dst + 2 * width16,
+                        width - width16, srcSliceH / 2,
+                        srcStride[u], srcStride[v], dstStride[1]);
+
+    return srcSliceH;
 }
 
+static int nv12_to_planar_neon_wrapper(SwsContext *c, const uint8_t *src[],
+                                       int srcStride[], int srcSliceY,
+                                       int srcSliceH, uint8_t *dstParam[],
+                                       int dstStride[])
+{
+    int u = c->srcFormat == AV_PIX_FMT_NV12 ? 1 : 2;
+    int v = 3 - u;
+    uint8_t *dstu = dstParam[u] + dstStride[u] * srcSliceY / 2;
+    uint8_t *dstv = dstParam[v] + dstStride[v] * srcSliceY / 2;
+    int width = c->srcW / 2, width16 = width & ~15;
+
+    copy_plane(src[0], srcStride[0], srcSliceY, srcSliceH, c->srcW,
+               dstParam[0], dstStride[0]);
+
+    if (width16)
+        ff_deinterleave_bytes_neon(src[1], dstu, dstv, width16, srcSliceH / 2,
+                                   srcStride[1], dstStride[u], dstStride[v]);
+    if (width > width16)
+        deinterleaveBytes(src[1] + 2 * width16, dstu + width16, dstv + width16,
+                          width - width16, srcSliceH / 2,
+                          srcStride[1], dstStride[u], dstStride[v]);
+
+    return srcSliceH;
+}
+
+#define PACKED422_TO_YUV420_WRAPPER(fmt)                                        \
+static int fmt ## _to_yuv420_neon_wrapper(SwsContext *c, const uint8_t *src[],  \
+                                          int srcStride[], int srcSliceY,       \
+                                          int srcSliceH, uint8_t *dstParam[],   \
+                                          int dstStride[])                      \
+{                                                                               \
+    uint8_t *ydst = dstParam[0] + dstStride[0] * srcSliceY;                     \
+    uint8_t *udst = dstParam[1] + dstStride[1] * srcSliceY / 2;                 \
+    uint8_t *vdst = dstParam[2] + dstStride[2] * srcSliceY / 2;                 \
+    int width16 = c->srcW & ~15;                                                \
+                                                                                \
+    if (width16)                                                                \
+        ff_ ## fmt ## toyuv420_neon(ydst, udst, vdst, src[0], width16,          \
+                                    srcSliceH, dstStride[0], dstStride[1],      \
+                                    srcStride[0]);                              \
+    if (c->srcW > width16)                                                      \
+        fmt ## toyuv420(ydst + width16, udst + width16 / 2, vdst + width16 / 2, \
+                        src[0] + 2 * width16, c->srcW - width16, srcSliceH,     \
+                        dstStride[0], dstStride[1], srcStride[0]);              \
+                                                                                \
+    return srcSliceH;                                                           \
+}
+
+PACKED422_TO_YUV420_WRAPPER(yuyv)
+PACKED422_TO_YUV420_WRAPPER(uyvy)
+
 static void get_unscaled_swscale_neon(SwsContext *c) {
     int accurate_rnd = c->flags & SWS_ACCURATE_RND;
     if (c->srcFormat == AV_PIX_FMT_RGBA
             && c->dstFormat == AV_PIX_FMT_NV12
-            && (c->srcW >= 16)) {
+            && (c->srcW >= 16)
+            && !(c->flags & SWS_BITEXACT)) {
         c->swscale = accurate_rnd ? rgbx_to_nv12_neon_32_wrapper
                         : rgbx_to_nv12_neon_16_wrapper;
     }
+
+    if (c->srcFormat == AV_PIX_FMT_YUV420P &&
+        (c->dstFormat == AV_PIX_FMT_NV12 || c->dstFormat == AV_PIX_FMT_NV21))
+        c->swscale = planar_to_nv12_neon_wrapper;
+    if ((c->srcFormat == AV_PIX_FMT_NV12 || c->srcFormat == AV_PIX_FMT_NV21) &&
+        c->dstFormat == AV_PIX_FMT_YUV420P)
+        c->swscale = nv12_to_planar_neon_wrapper;
+    if (c->srcFormat == AV_PIX_FMT_YUYV422 && c->dstFormat == AV_PIX_FMT_YUV420P)
+        c->swscale = yuyv_to_yuv420_neon_wrapper;
+    if (c->srcFormat == AV_PIX_FMT_UYVY422 && c->dstFormat == AV_PIX_FMT_YUV420P)
+        c->swscale = uyvy_to_yuv420_neon_wrapper;
+
+    /* under the same conditions as the C yuv2rgb converters of YUV420P */
+    if ((c->srcFormat == AV_PIX_FMT_NV12 || c->srcFormat == AV_PIX_FMT_NV21) &&
+        !(c->flags & (SWS_ACCURATE_RND | SWS_BITEXACT)) &&
+        (c->dither == SWS_DITHER_BAYER || c->dither == SWS_DITHER_AUTO) &&
+        !(c->dstH & 1)) {
+        SwsFunc yuv2rgb = ff_yuv2rgb_init_arm(c);
+        if (yuv2rgb)
+            c->swscale = yuv2rgb;
+    }
 }
 
 void ff_get_unscaled_swscale_arm(SwsContext *c)
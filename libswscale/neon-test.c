@@ -0,0 +1,296 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Bit-exactness test of the NEON scalers and unscaled converters against
+ * the C code. Every conversion is run by a context set up with all CPU
+ * flags and by one set up with none, on random input with widths that are
+ * not multiples of 16, the unscaled ones being passed in slices. Run it
+ * natively or through the target_exec wrapper (e.g. qemu-user) when cross
+ * compiling.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/cpu.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "swscale.h"
+
+static const struct {
+    enum AVPixelFormat src, dst;
+    int scaled;
+} conversions[] = {
+    /* unscaled converters */
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12    },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV21    },
+    { AV_PIX_FMT_NV12,    AV_PIX_FMT_YUV420P },
+    { AV_PIX_FMT_NV21,    AV_PIX_FMT_YUV420P },
+    { AV_PIX_FMT_YUYV422, AV_PIX_FMT_YUV420P },
+    { AV_PIX_FMT_UYVY422, AV_PIX_FMT_YUV420P },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGB24   },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_BGR24   },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_ARGB    },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGBA    },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_ABGR    },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_BGRA    },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGB565  },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_BGR565  },
+    { AV_PIX_FMT_NV12,    AV_PIX_FMT_RGB24   },
+    { AV_PIX_FMT_NV12,    AV_PIX_FMT_RGBA    },
+    { AV_PIX_FMT_NV12,    AV_PIX_FMT_BGR565  },
+    { AV_PIX_FMT_NV21,    AV_PIX_FMT_BGR24   },
+    { AV_PIX_FMT_NV21,    AV_PIX_FMT_ABGR    },
+    { AV_PIX_FMT_NV21,    AV_PIX_FMT_RGB565  },
+    /* horizontal and vertical scalers */
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P,     1 },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12,        1 },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV21,        1 },
+    { AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV444P,     1 },
+    { AV_PIX_FMT_GRAY8,   AV_PIX_FMT_GRAY8,       1 },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P16LE, 1 },
+};
+
+static const int scaler_flags[] = {
+    SWS_FAST_BILINEAR, SWS_BILINEAR, SWS_BICUBIC, SWS_AREA, SWS_GAUSS,
+    SWS_LANCZOS, SWS_SPLINE,
+};
+
+static const struct {
+    int brightness, contrast, saturation, range;
+} colorspaces[] = {
+    {          0, 1 << 16, 1 << 16, 0 },
+    {   -1 << 14, 3 << 15, 5 << 14, 0 },
+    {    1 << 13, 1 << 15, 3 << 15, 1 },
+};
+
+static struct SwsContext *get_context(int src_w, int src_h,
+                                      enum AVPixelFormat src_fmt,
+                                      int dst_w, int dst_h,
+                                      enum AVPixelFormat dst_fmt,
+                                      int flags, int cpu_flags, int cs)
+{
+    struct SwsContext *c;
+    const int *table = sws_getCoefficients(SWS_CS_DEFAULT);
+
+    av_force_cpu_flags(cpu_flags);
+    c = sws_getContext(src_w, src_h, src_fmt, dst_w, dst_h, dst_fmt,
+                       flags, NULL, NULL, NULL);
+    if (c && cs)
+        sws_setColorspaceDetails(c, table, colorspaces[cs].range, table, 0,
+                                 colorspaces[cs].brightness,
+                                 colorspaces[cs].contrast,
+                                 colorspaces[cs].saturation);
+    av_force_cpu_flags(-1);
+    return c;
+}
+
+/* pass the picture in slices of random even heights, the last one taking
+ * what is left, possibly an odd number of lines; the vertical scaler ring
+ * buffer does not cope with arbitrary slicing of small pictures, so scaled
+ * conversions get the whole picture at once */
+static void scale_slices(AVLFG *lfg, struct SwsContext *c, int scaled,
+                         uint8_t *src[4], int src_stride[4],
+                         enum AVPixelFormat src_fmt, int src_h,
+                         uint8_t *dst[4], int dst_stride[4])
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(src_fmt);
+    int y = 0;
+
+    while (y < src_h) {
+        const uint8_t *slice[4] = { NULL };
+        int h = scaled ? src_h : 2 + 2 * (av_lfg_get(lfg) % 8);
+        int i;
+
+        if (h > src_h - y)
+            h = src_h - y;
+        for (i = 0; i < 4 && src[i]; i++) {
+            int shift = i == 1 || i == 2 ? desc->log2_chroma_h : 0;
+            slice[i] = src[i] + (y >> shift) * src_stride[i];
+        }
+        sws_scale(c, slice, src_stride, y, h, dst, dst_stride);
+        y += h;
+    }
+}
+
+static int compare(uint8_t *ref[4], uint8_t *out[4], int stride[4],
+                   enum AVPixelFormat fmt, int w, int h, const char *what)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(fmt);
+    int i, x, y;
+
+    for (i = 0; i < 4 && ref[i]; i++) {
+        int shift = i == 1 || i == 2 ? desc->log2_chroma_h : 0;
+        int plane_h = -((-h) >> shift);
+        int len = av_image_get_linesize(fmt, w, i);
+
+        for (y = 0; y < plane_h; y++) {
+            const uint8_t *a = ref[i] + y * stride[i];
+            const uint8_t *b = out[i] + y * stride[i];
+            if (!memcmp(a, b, len))
+                continue;
+            for (x = 0; a[x] == b[x]; x++)
+                ;
+            fprintf(stderr, "%s: plane %d mismatch at byte %d of line %d: "
+                    "expected %d, got %d\n", what, i, x, y, a[x], b[x]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* the NEON NV12 and NV21 to RGB converters have no C counterpart; they
+ * match the C YUV420P converter on the deinterleaved chroma */
+static int deinterleave(uint8_t *planar[4], int planar_stride[4],
+                        uint8_t *src[4], int src_stride[4],
+                        enum AVPixelFormat fmt, int w, int h)
+{
+    int chr_w = (w + 1) >> 1, chr_h = (h + 1) >> 1;
+    int u = fmt == AV_PIX_FMT_NV12 ? 1 : 2, v = 3 - u;
+    int x, y;
+
+    if (av_image_alloc(planar, planar_stride, w, h, AV_PIX_FMT_YUV420P, 16) < 0)
+        return AVERROR(ENOMEM);
+    av_image_copy_plane(planar[0], planar_stride[0], src[0], src_stride[0], w, h);
+    for (y = 0; y < chr_h; y++) {
+        for (x = 0; x < chr_w; x++) {
+            planar[u][y * planar_stride[u] + x] = src[1][y * src_stride[1] + 2 * x];
+            planar[v][y * planar_stride[v] + x] = src[1][y * src_stride[1] + 2 * x + 1];
+        }
+    }
+    return 0;
+}
+
+static int run_test(AVLFG *lfg, int conv, int src_w, int src_h,
+                    int dst_w, int dst_h, int flags, int cs)
+{
+    enum AVPixelFormat src_fmt = conversions[conv].src;
+    enum AVPixelFormat dst_fmt = conversions[conv].dst;
+    enum AVPixelFormat ref_fmt = src_fmt;
+    struct SwsContext *c_ref = NULL, *c_opt = NULL;
+    uint8_t *src[4] = { NULL }, *planar[4] = { NULL };
+    uint8_t *ref[4] = { NULL }, *out[4] = { NULL };
+    uint8_t **ref_src = src;
+    int src_stride[4], planar_stride[4], dst_stride[4];
+    int size, i, ret = 1;
+    unsigned seed = av_lfg_get(lfg);
+    AVLFG slice_lfg;
+    char what[128];
+
+    snprintf(what, sizeof(what), "%s %dx%d -> %s %dx%d, flags 0x%x, colorspace %d",
+             av_get_pix_fmt_name(src_fmt), src_w, src_h,
+             av_get_pix_fmt_name(dst_fmt), dst_w, dst_h, flags, cs);
+
+    size = av_image_alloc(src, src_stride, src_w, src_h, src_fmt, 16);
+    if (size < 0)
+        goto end;
+    for (i = 0; i < size; i++)
+        src[0][i] = av_lfg_get(lfg);
+
+    if ((src_fmt == AV_PIX_FMT_NV12 || src_fmt == AV_PIX_FMT_NV21) &&
+        !conversions[conv].scaled && dst_fmt != AV_PIX_FMT_YUV420P) {
+        if (deinterleave(planar, planar_stride, src, src_stride, src_fmt,
+                         src_w, src_h) < 0)
+            goto end;
+        ref_fmt = AV_PIX_FMT_YUV420P;
+        ref_src = planar;
+    }
+
+    c_ref = get_context(src_w, src_h, ref_fmt, dst_w, dst_h, dst_fmt, flags, 0, cs);
+    c_opt = get_context(src_w, src_h, src_fmt, dst_w, dst_h, dst_fmt, flags, -1, cs);
+    if (!c_ref || !c_opt)
+        goto end;
+
+    /* the optimized functions may write a few bytes past the end of a line,
+     * so the lines are padded */
+    size = av_image_alloc(ref, dst_stride, dst_w, dst_h, dst_fmt, 32);
+    if (size < 0 || av_image_alloc(out, dst_stride, dst_w, dst_h, dst_fmt, 32) < 0)
+        goto end;
+    memset(ref[0], 0, size);
+    memset(out[0], 0, size);
+
+    av_lfg_init(&slice_lfg, seed);
+    scale_slices(&slice_lfg, c_ref, conversions[conv].scaled, ref_src,
+                 ref_src == planar ? planar_stride : src_stride,
+                 ref_fmt, src_h, ref, dst_stride);
+    av_lfg_init(&slice_lfg, seed);
+    scale_slices(&slice_lfg, c_opt, conversions[conv].scaled,
+                 src, src_stride, src_fmt, src_h, out, dst_stride);
+
+    ret = compare(ref, out, dst_stride, dst_fmt, dst_w, dst_h, what);
+
+end:
+    if (ret && !c_opt)
+        fprintf(stderr, "%s: setup failed\n", what);
+    sws_freeContext(c_ref);
+    sws_freeContext(c_opt);
+    av_freep(&src[0]);
+    av_freep(&planar[0]);
+    av_freep(&ref[0]);
+    av_freep(&out[0]);
+    return ret;
+}
+
+int main(void)
+{
+    static const int widths[]  = { 18, 34, 45, 46, 70, 258, 1278 };
+    static const int heights[] = { 2, 6, 18, 35 };
+    AVLFG lfg;
+    int conv, i, j, k, ret = 0;
+
+    av_log_set_level(AV_LOG_ERROR);
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (conv = 0; conv < FF_ARRAY_ELEMS(conversions); conv++) {
+        enum AVPixelFormat dst_fmt = conversions[conv].dst;
+        int rgb = av_pix_fmt_desc_get(dst_fmt)->flags & AV_PIX_FMT_FLAG_RGB;
+
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            for (j = 0; j < FF_ARRAY_ELEMS(heights); j++) {
+                int w = widths[i], h = heights[j];
+
+                if (!conversions[conv].scaled) {
+                    /* the yuv2rgb converters output pairs of lines */
+                    if (rgb && (h & 1))
+                        continue;
+                    for (k = 0; k < (rgb ? FF_ARRAY_ELEMS(colorspaces) : 1); k++)
+                        ret |= run_test(&lfg, conv, w, h, w, h, SWS_BILINEAR, k);
+                    continue;
+                }
+
+                for (k = 0; k < FF_ARRAY_ELEMS(scaler_flags); k++) {
+                    /* downscale, upscale and a width kept but height changed */
+                    ret |= run_test(&lfg, conv, w, h, w * 2 / 3 + 1, h + 3,
+                                    scaler_flags[k], 0);
+                    ret |= run_test(&lfg, conv, w, h, w * 3 / 2 + 3, FFMAX(h / 2, 1),
+                                    scaler_flags[k], 0);
+                    ret |= run_test(&lfg, conv, w, h, w, h * 2 + 1,
+                                    scaler_flags[k], 0);
+                }
+            }
+        }
+    }
+
+    return ret;
+}
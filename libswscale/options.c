@@ -78,6 +78,8 @@ static const AVOption swscale_options[] = {
     { "gamma",           "gamma correct scaling", OFFSET(gamma_flag),        AV_OPT_TYPE_INT,    { .i64  = 0                  }, 0,       INT_MAX,        VE, "gamma" },
     { "true",            "enable",                        0,                 AV_OPT_TYPE_CONST,  { .i64  = 1                  }, INT_MIN, INT_MAX,        VE, "gamma" },
     { "false",           "disable",                       0,                 AV_OPT_TYPE_CONST,  { .i64  = 0                  }, INT_MIN, INT_MAX,        VE, "gamma" },
+    { "threads",         "number of threads",             OFFSET(nb_threads), AV_OPT_TYPE_INT,   { .i64  = 1                  }, 0,       INT_MAX,        VE, "threads" },
+    { "auto",            "autodetect a suitable number of threads", 0,  AV_OPT_TYPE_CONST,  { .i64  = 0                  }, INT_MIN, INT_MAX,        VE, "threads" },
 
     { NULL }
 };
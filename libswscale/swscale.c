@@ -429,7 +429,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     if (srcSliceY == 0) {
         lumBufIndex  = -1;
         chrBufIndex  = -1;
-        dstY         = 0;
+        dstY         = c->dstBandStart;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
@@ -439,7 +439,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     }
     lastDstY = dstY;
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < c->dstBandEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         uint8_t *dest[4]  = {
             dst[0] + dstStride[0] * dstY,
@@ -447,6 +447,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
             dst[2] + dstStride[2] * chrDstY,
             (CONFIG_SWSCALE_ALPHA && alpPixBuf) ? dst[3] + dstStride[3] * dstY : NULL,
         };
+        uint8_t *band_dest[4] = { NULL };
         int use_mmx_vfilter= c->use_mmx_vfilter;
 
         // First line needed as input
@@ -557,6 +558,21 @@ static int swscale(SwsContext *c, const uint8_t *src[],
             ff_sws_init_output_funcs(c, &yuv2plane1, &yuv2planeX, &yuv2nv12cX,
                                      &yuv2packed1, &yuv2packed2, &yuv2packedX, &yuv2anyX);
             use_mmx_vfilter= 0;
+        } else if (c->band_tail_buf &&
+                   dstY >= c->dstBandEnd - FFMAX(2, 1 << c->chrDstVSubSample)) {
+            /* the tail of the last lines of a band is the start of the next
+             * band, which another thread may already have written; output
+             * them through padded lines with the same functions as the rest
+             * of the picture so that the result does not depend on the
+             * number of threads */
+            int i;
+            for (i = 0; i < 4; i++) {
+                if (!dest[i] || !c->band_tail_len[i])
+                    continue;
+                band_dest[i] = dest[i];
+                dest[i]      = c->band_tail_buf + i * c->band_tail_stride;
+                memcpy(dest[i], band_dest[i], c->band_tail_len[i]);
+            }
         }
 
         {
@@ -666,6 +682,12 @@ static int swscale(SwsContext *c, const uint8_t *src[],
             if (perform_gamma)
                 gamma_convert(dest, dstW, c->gamma);
         }
+        if (band_dest[0]) {
+            int i;
+            for (i = 0; i < 4; i++)
+                if (band_dest[i])
+                    memcpy(band_dest[i], dest[i], c->band_tail_len[i]);
+        }
     }
     if (isPlanar(dstFormat) && isALPHA(dstFormat) && !alpPixBuf) {
         int length = dstW;
@@ -762,6 +784,10 @@ SwsFunc ff_getSwsFunc(SwsContext *c)
         ff_sws_init_swscale_ppc(c);
     if (ARCH_X86)
         ff_sws_init_swscale_x86(c);
+    if (ARCH_ARM)
+        ff_sws_init_swscale_arm(c);
+    if (ARCH_AARCH64)
+        ff_sws_init_swscale_aarch64(c);
 
     return swscale;
 }
@@ -905,6 +931,49 @@ static void rgb48Toxyz12(struct SwsContext *c, uint16_t *dst,
     }
 }
 
+typedef struct BandArgs {
+    const uint8_t *src[4];
+    int srcStride[4];
+    uint8_t *dst[4];
+    int dstStride[4];
+} BandArgs;
+
+static int scale_band(SwsContext *c, void *arg, int jobnr, int nb_jobs)
+{
+    SwsContext *band = c->band_context[jobnr];
+    BandArgs args    = *(BandArgs *)arg;
+
+    if (usePal(c->srcFormat))
+        memcpy(band->pal_yuv, c->pal_yuv, sizeof(c->pal_yuv));
+
+    return band->swscale(band, args.src, args.srcStride, 0, c->srcH,
+                         args.dst, args.dstStride);
+}
+
+/**
+ * Scale a whole frame by running the destination bands of the context in
+ * parallel, each band context reading the source lines it needs.
+ */
+static int swscale_bands(SwsContext *c, const uint8_t *src[], int srcStride[],
+                         uint8_t *dst[], int dstStride[])
+{
+    int rets[MAX_BANDS];
+    BandArgs args;
+    int i, ret = 0;
+
+    memcpy(args.src,       src,       sizeof(args.src));
+    memcpy(args.srcStride, srcStride, sizeof(args.srcStride));
+    memcpy(args.dst,       dst,       sizeof(args.dst));
+    memcpy(args.dstStride, dstStride, sizeof(args.dstStride));
+
+    ff_sws_thread_execute(c, scale_band, &args, rets, c->nb_bands);
+
+    for (i = 0; i < c->nb_bands; i++)
+        ret += rets[i];
+    c->dstY = c->dstH;
+    return ret;
+}
+
 /**
  * swscale wrapper, so we don't need to export the SwsContext.
  * Assumes planar YUV to be in YUV order instead of YVU.
@@ -1110,8 +1179,11 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
         if (srcSliceY + srcSliceH == c->srcH)
             c->sliceDir = 0;
 
-        ret = c->swscale(c, src2, srcStride2, srcSliceY, srcSliceH, dst2,
-                          dstStride2);
+        if (c->nb_bands && srcSliceY == 0 && srcSliceH == c->srcH)
+            ret = swscale_bands(c, src2, srcStride2, dst2, dstStride2);
+        else
+            ret = c->swscale(c, src2, srcStride2, srcSliceY, srcSliceH, dst2,
+                              dstStride2);
     } else {
         // slices go from bottom to top => we flip the image internally
         int srcStride2[4] = { -srcStride[0], -srcStride[1], -srcStride[2],
@@ -43,6 +43,8 @@
 
 #define MAX_FILTER_SIZE SWS_MAX_FILTER_SIZE
 
+#define MAX_BANDS 64 ///< maximum number of destination bands scaled in parallel
+
 #define DITHER1XBPP
 
 #if HAVE_BIGENDIAN
@@ -313,6 +315,20 @@ typedef struct SwsContext {
     int cascaded1_tmpStride[4];
     uint8_t *cascaded1_tmp[4];
 
+    /* The band_* fields allow splitting the destination of a scaler task
+     * into horizontal bands which are scaled in parallel, each by its own
+     * context with its own ring buffers and filter state.
+     */
+    int nb_threads;               ///< Number of threads requested by the user, 0 for automatic.
+    struct SwsContext **band_context;
+    int nb_bands;
+    struct SwsThreadContext *thread;
+    int dstBandStart;             ///< First destination line output by this context.
+    int dstBandEnd;               ///< Destination line after the last one output by this context.
+    uint8_t *band_tail_buf;       ///< Padded copies of the last lines of a band that is not the last one.
+    int band_tail_stride;
+    int band_tail_len[4];         ///< Length in bytes of a destination line of each plane.
+
     double gamma_value;
     int gamma_flag;
     int is_internal_gamma;
@@ -372,6 +388,11 @@ typedef struct SwsContext {
     int hChrFilterSize;           ///< Horizontal filter size for chroma     pixels.
     int vLumFilterSize;           ///< Vertical   filter size for luma/alpha pixels.
     int vChrFilterSize;           ///< Vertical   filter size for chroma     pixels.
+    /**
+     * The entries of the filter cache in utils.c the above point to, in the
+     * order hLum, hChr, vLum, vChr; NULL for filters owned by the context.
+     */
+    struct SwsFilterCacheEntry *cachedFilter[4];
     //@}
 
     int lumMmxextFilterCodeSize;  ///< Runtime-generated MMXEXT horizontal fast bilinear scaler code size for luma/alpha planes.
@@ -390,6 +411,20 @@ typedef struct SwsContext {
     uint8_t *table_rV[256 + 2*YUVRGB_TABLE_HEADROOM];
     uint8_t *table_gU[256 + 2*YUVRGB_TABLE_HEADROOM];
     uint8_t *table_bU[256 + 2*YUVRGB_TABLE_HEADROOM];
+    /* The 16 to 32 bpp yuv2rgb tables above as linear functions, for SIMD
+     * code computing their entries instead of looking them up. A component
+     * is av_clip_uint8((ofs + cy * (Y + sum(C * coeff >> 16))) >> 16), with
+     * R from V, G from U and V and B from U. All zero if the tables cannot
+     * be computed this way in 32 bits; see ff_yuv2rgb_c_init_tables(). */
+    int32_t yuv2rgb_table_coeffs[8];
+#define YUV2RGB_CY_IDX   0
+#define YUV2RGB_CRV_IDX  1
+#define YUV2RGB_CBU_IDX  2
+#define YUV2RGB_CGU_IDX  3
+#define YUV2RGB_CGV_IDX  4
+#define YUV2RGB_ROFS_IDX 5
+#define YUV2RGB_GOFS_IDX 6
+#define YUV2RGB_BOFS_IDX 7
     DECLARE_ALIGNED(16, int32_t, input_rgb2yuv_table)[16+40*4]; // This table can contain both C and SIMD formatted values, the C vales are always at the XY_IDX points
 #define RY_IDX 0
 #define GY_IDX 1
@@ -615,6 +650,7 @@ typedef struct SwsContext {
 //FIXME check init (where 0)
 
 SwsFunc ff_yuv2rgb_get_func_ptr(SwsContext *c);
+SwsFunc ff_yuv2rgb_get_c_func_ptr(SwsContext *c);
 int ff_yuv2rgb_c_init_tables(SwsContext *c, const int inv_table[4],
                              int fullRange, int brightness,
                              int contrast, int saturation);
@@ -628,6 +664,8 @@ av_cold void ff_sws_init_range_convert(SwsContext *c);
 
 SwsFunc ff_yuv2rgb_init_x86(SwsContext *c);
 SwsFunc ff_yuv2rgb_init_ppc(SwsContext *c);
+SwsFunc ff_yuv2rgb_init_arm(SwsContext *c);
+SwsFunc ff_yuv2rgb_init_aarch64(SwsContext *c);
 
 static av_always_inline int is16BPS(enum AVPixelFormat pix_fmt)
 {
@@ -854,6 +892,7 @@ extern const AVClass sws_context_class;
 void ff_get_unscaled_swscale(SwsContext *c);
 void ff_get_unscaled_swscale_ppc(SwsContext *c);
 void ff_get_unscaled_swscale_arm(SwsContext *c);
+void ff_get_unscaled_swscale_aarch64(SwsContext *c);
 
 /**
  * Return function pointer to fastest main scaler path function depending
@@ -872,6 +911,14 @@ void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2anyX_fn *yuv2anyX);
 void ff_sws_init_swscale_ppc(SwsContext *c);
 void ff_sws_init_swscale_x86(SwsContext *c);
+void ff_sws_init_swscale_arm(SwsContext *c);
+void ff_sws_init_swscale_aarch64(SwsContext *c);
+
+int ff_sws_thread_init(SwsContext *c, int nb_threads);
+void ff_sws_thread_free(SwsContext *c);
+int ff_sws_thread_execute(SwsContext *c,
+                          int (*func)(SwsContext *c, void *arg, int jobnr, int nb_jobs),
+                          void *arg, int *ret, int nb_jobs);
 
 void ff_hyscale_fast_c(SwsContext *c, int16_t *dst, int dstWidth,
                        const uint8_t *src, int srcW, int xInc);
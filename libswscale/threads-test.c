@@ -0,0 +1,168 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Bit-exactness test of the band threaded scaler against the single
+ * threaded one. The destination lines are packed (linesize == width) and
+ * the widths are not multiples of 8, so a vertical scaler writing past the
+ * end of a band's last line lands in the next band. Besides going through
+ * the thread pool, the bands are also run from the last to the first, the
+ * order in which such a write does the most damage.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+
+#include "swscale.h"
+#include "swscale_internal.h"
+
+static const struct {
+    int src_w, src_h;
+    enum AVPixelFormat src_fmt;
+    int dst_w, dst_h;
+    enum AVPixelFormat dst_fmt;
+    int flags;
+} tests[] = {
+    { 1920, 1080, AV_PIX_FMT_YUV420P, 1277, 719, AV_PIX_FMT_YUV420P, SWS_BICUBIC  },
+    { 1920, 1080, AV_PIX_FMT_YUV420P, 1277, 719, AV_PIX_FMT_NV12,    SWS_BILINEAR },
+    {  720,  576, AV_PIX_FMT_YUV420P, 1021, 767, AV_PIX_FMT_YUV410P, SWS_LANCZOS  },
+    {  720,  576, AV_PIX_FMT_YUV422P,  643, 381, AV_PIX_FMT_YUV422P, SWS_BICUBIC  },
+    {  720,  576, AV_PIX_FMT_YUV420P,  643, 381, AV_PIX_FMT_BGRA,    SWS_BICUBIC  },
+    {  640,  480, AV_PIX_FMT_YUV420P,  317, 239, AV_PIX_FMT_GRAY8,   SWS_AREA     },
+};
+
+static struct SwsContext *get_context(int i, int threads)
+{
+    struct SwsContext *c = sws_alloc_context();
+
+    if (!c)
+        return NULL;
+    av_opt_set_int(c, "srcw",       tests[i].src_w,   0);
+    av_opt_set_int(c, "srch",       tests[i].src_h,   0);
+    av_opt_set_int(c, "src_format", tests[i].src_fmt, 0);
+    av_opt_set_int(c, "dstw",       tests[i].dst_w,   0);
+    av_opt_set_int(c, "dsth",       tests[i].dst_h,   0);
+    av_opt_set_int(c, "dst_format", tests[i].dst_fmt, 0);
+    av_opt_set_int(c, "sws_flags",  tests[i].flags,   0);
+    av_opt_set_int(c, "threads",    threads,          0);
+    if (sws_init_context(c, NULL, NULL) < 0) {
+        sws_freeContext(c);
+        return NULL;
+    }
+    return c;
+}
+
+static int compare(const uint8_t *ref, const uint8_t *out, int size,
+                   int i, int threads, const char *how)
+{
+    int j;
+
+    for (j = 0; j < size; j++) {
+        if (ref[j] != out[j]) {
+            fprintf(stderr, "%dx%d %s -> %dx%d %s, %d threads, %s: "
+                    "mismatch at byte %d: expected %d, got %d\n",
+                    tests[i].src_w, tests[i].src_h,
+                    av_get_pix_fmt_name(tests[i].src_fmt),
+                    tests[i].dst_w, tests[i].dst_h,
+                    av_get_pix_fmt_name(tests[i].dst_fmt),
+                    threads, how, j, ref[j], out[j]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int run_test(AVLFG *lfg, int i, int threads)
+{
+    struct SwsContext *c1 = NULL, *cn = NULL;
+    uint8_t *src[4], *ref[4] = { NULL }, *out[4] = { NULL };
+    int src_stride[4], dst_stride[4];
+    int src_size, size, j, run, ret = 1;
+
+    src_size = av_image_alloc(src, src_stride, tests[i].src_w, tests[i].src_h,
+                              tests[i].src_fmt, 16);
+    if (src_size < 0)
+        return 1;
+    size = av_image_alloc(ref, dst_stride, tests[i].dst_w, tests[i].dst_h,
+                          tests[i].dst_fmt, 1);
+    if (size < 0 ||
+        av_image_alloc(out, dst_stride, tests[i].dst_w, tests[i].dst_h,
+                       tests[i].dst_fmt, 1) < 0)
+        goto end;
+
+    for (j = 0; j < src_size; j++)
+        src[0][j] = av_lfg_get(lfg);
+
+    c1 = get_context(i, 1);
+    cn = get_context(i, threads);
+    if (!c1 || !cn)
+        goto end;
+
+    memset(ref[0], 0, size);
+    sws_scale(c1, (const uint8_t * const *)src, src_stride, 0, tests[i].src_h,
+              ref, dst_stride);
+
+    /* the order in which the bands finish varies, so try a few times */
+    for (run = 0; run < 4; run++) {
+        memset(out[0], 0, size);
+        sws_scale(cn, (const uint8_t * const *)src, src_stride, 0, tests[i].src_h,
+                  out, dst_stride);
+        if (compare(ref[0], out[0], size, i, threads, "thread pool"))
+            goto end;
+    }
+
+    memset(out[0], 0, size);
+    for (j = cn->nb_bands - 1; j >= 0; j--) {
+        SwsContext *band = cn->band_context[j];
+        band->swscale(band, (const uint8_t **)src, src_stride, 0, tests[i].src_h,
+                      out, dst_stride);
+    }
+    if (cn->nb_bands && compare(ref[0], out[0], size, i, threads, "bands reversed"))
+        goto end;
+    ret = 0;
+
+end:
+    sws_freeContext(c1);
+    sws_freeContext(cn);
+    av_freep(&src[0]);
+    av_freep(&ref[0]);
+    av_freep(&out[0]);
+    return ret;
+}
+
+int main(void)
+{
+    static const int threads[] = { 2, 3, 8, 32 };
+    AVLFG lfg;
+    int i, j, ret = 0;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(tests); i++)
+        for (j = 0; j < FF_ARRAY_ELEMS(threads); j++)
+            ret |= run_test(&lfg, i, threads[j]);
+
+    return ret;
+}
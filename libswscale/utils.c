@@ -36,7 +36,11 @@
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #endif
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
 
+#include "libavutil/arm/cpu.h"
 #include "libavutil/attributes.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avutil.h"
@@ -692,6 +696,164 @@ fail:
     return ret;
 }
 
+/**
+ * A filter computed by initFilter() together with all its parameters, shared
+ * by the contexts that need it.
+ */
+typedef struct SwsFilterCacheEntry {
+    int xInc, srcW, dstW, filterAlign, one, flags, cpu_flags, srcPos, dstPos;
+    double param[2];
+
+    int16_t *filter;
+    int32_t *filterPos;
+    int filterSize;
+
+    int refcount;
+    struct SwsFilterCacheEntry *next;
+} SwsFilterCacheEntry;
+
+#if HAVE_PTHREADS
+static pthread_mutex_t filter_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static SwsFilterCacheEntry *filter_cache;
+
+/* must be called with filter_cache_lock held */
+static SwsFilterCacheEntry *find_cached_filter(const SwsFilterCacheEntry *key)
+{
+    SwsFilterCacheEntry *e;
+
+    for (e = filter_cache; e; e = e->next) {
+        if (e->xInc        == key->xInc        && e->srcW      == key->srcW      &&
+            e->dstW        == key->dstW        && e->one       == key->one       &&
+            e->filterAlign == key->filterAlign && e->flags     == key->flags     &&
+            e->cpu_flags   == key->cpu_flags   && e->srcPos    == key->srcPos    &&
+            e->dstPos      == key->dstPos      &&
+            !memcmp(e->param, key->param, sizeof(e->param)))
+            return e;
+    }
+    return NULL;
+}
+#endif
+
+/**
+ * Like initFilter(), but look the filter up in a process-wide cache first,
+ * so that contexts of the same geometry and scaler share their filters
+ * instead of computing them again. *entry is set to the cache entry the
+ * filter is referenced from, or NULL if the caller owns the filter.
+ */
+static av_cold int init_filter_cached(SwsFilterCacheEntry **entry,
+                                      int16_t **outFilter, int32_t **filterPos,
+                                      int *outFilterSize, int xInc, int srcW,
+                                      int dstW, int filterAlign, int one,
+                                      int flags, int cpu_flags,
+                                      SwsVector *srcFilter, SwsVector *dstFilter,
+                                      double param[2], int srcPos, int dstPos)
+{
+#if HAVE_PTHREADS
+    SwsFilterCacheEntry key = { 0 }, *e;
+    int ret;
+
+    *entry = NULL;
+
+    /* user supplied filter vectors are not part of the key */
+    if (srcFilter || dstFilter)
+        return initFilter(outFilter, filterPos, outFilterSize, xInc, srcW,
+                          dstW, filterAlign, one, flags, cpu_flags,
+                          srcFilter, dstFilter, param, srcPos, dstPos);
+
+    key.xInc        = xInc;
+    key.srcW        = srcW;
+    key.dstW        = dstW;
+    key.filterAlign = filterAlign;
+    key.one         = one;
+    key.flags       = flags;
+    key.cpu_flags   = cpu_flags;
+    key.srcPos      = srcPos;
+    key.dstPos      = dstPos;
+    key.param[0]    = param[0];
+    key.param[1]    = param[1];
+
+    pthread_mutex_lock(&filter_cache_lock);
+    if ((e = find_cached_filter(&key)))
+        e->refcount++;
+    pthread_mutex_unlock(&filter_cache_lock);
+
+    if (!e) {
+        if ((ret = initFilter(outFilter, filterPos, outFilterSize, xInc, srcW,
+                              dstW, filterAlign, one, flags, cpu_flags,
+                              NULL, NULL, param, srcPos, dstPos)) < 0)
+            return ret;
+
+        pthread_mutex_lock(&filter_cache_lock);
+        /* another context may have computed the same filter meanwhile */
+        if ((e = find_cached_filter(&key))) {
+            e->refcount++;
+        } else if ((e = av_malloc(sizeof(*e)))) {
+            *e            = key;
+            e->filter     = *outFilter;
+            e->filterPos  = *filterPos;
+            e->filterSize = *outFilterSize;
+            e->refcount   = 1;
+            e->next       = filter_cache;
+            filter_cache  = e;
+        }
+        pthread_mutex_unlock(&filter_cache_lock);
+
+        /* not being able to cache the filter is not an error */
+        if (!e || e->filter == *outFilter) {
+            *entry = e;
+            return 0;
+        }
+        av_freep(outFilter);
+        av_freep(filterPos);
+    }
+
+    *entry         = e;
+    *outFilter     = e->filter;
+    *filterPos     = e->filterPos;
+    *outFilterSize = e->filterSize;
+    return 0;
+#else
+    *entry = NULL;
+    return initFilter(outFilter, filterPos, outFilterSize, xInc, srcW, dstW,
+                      filterAlign, one, flags, cpu_flags, srcFilter, dstFilter,
+                      param, srcPos, dstPos);
+#endif
+}
+
+/**
+ * Drop the reference of a context to a cached filter, freeing the filter
+ * when no other context uses it anymore.
+ */
+static av_cold void release_cached_filter(SwsFilterCacheEntry **entry,
+                                          int16_t **filter, int32_t **filterPos)
+{
+#if HAVE_PTHREADS
+    SwsFilterCacheEntry *e = *entry, **p;
+
+    if (!e)
+        return;
+
+    pthread_mutex_lock(&filter_cache_lock);
+    if (!--e->refcount) {
+        for (p = &filter_cache; *p != e; p = &(*p)->next)
+            ;
+        *p = e->next;
+    } else {
+        e = NULL;
+    }
+    pthread_mutex_unlock(&filter_cache_lock);
+
+    if (e) {
+        av_free(e->filter);
+        av_free(e->filterPos);
+        av_free(e);
+    }
+    *entry     = NULL;
+    *filter    = NULL;
+    *filterPos = NULL;
+#endif
+}
+
 static void fill_rgb2yuv_table(SwsContext *c, const int table[4], int dstRange)
 {
     int64_t W, V, Z, Cy, Cu, Cv;
@@ -829,6 +991,13 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     const AVPixFmtDescriptor *desc_dst;
     const AVPixFmtDescriptor *desc_src;
     int need_reinit = 0;
+    int i;
+
+    for (i = 0; i < c->nb_bands; i++)
+        sws_setColorspaceDetails(c->band_context[i], inv_table, srcRange,
+                                 table, dstRange,
+                                 brightness, contrast, saturation);
+
     memmove(c->srcColorspaceTable, inv_table, sizeof(int) * 4);
     memmove(c->dstColorspaceTable, table, sizeof(int) * 4);
 
@@ -978,6 +1147,99 @@ static uint16_t * alloc_gamma_tbl(double e)
     return tbl;
 }
 
+#if !HAVE_THREADS
+int ff_sws_thread_init(SwsContext *c, int nb_threads)
+{
+    return AVERROR(ENOSYS);
+}
+
+void ff_sws_thread_free(SwsContext *c)
+{
+}
+
+int ff_sws_thread_execute(SwsContext *c,
+                          int (*func)(SwsContext *c, void *arg, int jobnr, int nb_jobs),
+                          void *arg, int *ret, int nb_jobs)
+{
+    return AVERROR(ENOSYS);
+}
+#endif
+
+/**
+ * Split the destination into horizontal bands, each scaled by a context of
+ * its own so that they can run in parallel, when more than one thread was
+ * requested.
+ */
+static av_cold int init_band_contexts(SwsContext *c, SwsFilter *srcFilter,
+                                      SwsFilter *dstFilter)
+{
+    int align      = 1 << c->chrDstVSubSample;
+    int nb_threads = c->nb_threads;
+    int i, ret;
+
+    c->dstBandStart = 0;
+    c->dstBandEnd   = c->dstH;
+
+    if (!HAVE_THREADS)
+        return 0;
+
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+
+    /* error diffusion carries its state from one line to the next */
+    if (c->dither == SWS_DITHER_ED)
+        return 0;
+
+    /* the source lines shared by two bands are scaled horizontally by both,
+     * so do not make the bands too small */
+    nb_threads = FFMIN3(nb_threads, MAX_BANDS, c->dstH / FFMAX(16, align));
+    if (nb_threads <= 1)
+        return 0;
+
+    c->band_context = av_mallocz_array(nb_threads, sizeof(*c->band_context));
+    if (!c->band_context)
+        return AVERROR(ENOMEM);
+    c->nb_bands = nb_threads;
+
+    for (i = 0; i < nb_threads; i++) {
+        SwsContext *band = sws_alloc_context();
+        if (!band)
+            return AVERROR(ENOMEM);
+        c->band_context[i] = band;
+
+        if ((ret = av_opt_copy(band, c)) < 0)
+            return ret;
+        band->nb_threads = 1;
+        if ((ret = sws_init_context(band, srcFilter, dstFilter)) < 0)
+            return ret;
+        sws_setColorspaceDetails(band, c->srcColorspaceTable, c->srcRange,
+                                 c->dstColorspaceTable, c->dstRange,
+                                 c->brightness, c->contrast, c->saturation);
+
+        band->dstBandStart = FFALIGN(c->dstH * (int64_t) i      / nb_threads, align);
+        band->dstBandEnd   = FFALIGN(c->dstH * (int64_t)(i + 1) / nb_threads, align);
+        band->dstBandEnd   = FFMIN(band->dstBandEnd, c->dstH);
+
+        /* the SIMD output functions write up to a few pixels past the end
+         * of a line, which must not land in the next band */
+        if (band->dstBandEnd < c->dstH) {
+            int j, max_len = 0;
+
+            if ((ret = av_image_fill_linesizes(band->band_tail_len,
+                                               c->dstFormat, c->dstW)) < 0)
+                return ret;
+            for (j = 0; j < 4; j++)
+                max_len = FFMAX(max_len, band->band_tail_len[j]);
+            band->band_tail_stride = FFALIGN(max_len + 64, 64);
+            band->band_tail_buf    = av_malloc(4 * band->band_tail_stride);
+            if (!band->band_tail_buf)
+                return AVERROR(ENOMEM);
+        }
+    }
+
+    return ff_sws_thread_init(c, nb_threads);
+}
+
 av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                              SwsFilter *dstFilter)
 {
@@ -1396,9 +1658,11 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
 #endif /* HAVE_MMXEXT_INLINE */
         {
             const int filterAlign = X86_MMX(cpu_flags)     ? 4 :
-                                    PPC_ALTIVEC(cpu_flags) ? 8 : 1;
+                                    PPC_ALTIVEC(cpu_flags) ? 8 :
+                                    have_neon(cpu_flags)   ? 4 : 1;
 
-            if ((ret = initFilter(&c->hLumFilter, &c->hLumFilterPos,
+            if ((ret = init_filter_cached(&c->cachedFilter[0],
+                           &c->hLumFilter, &c->hLumFilterPos,
                            &c->hLumFilterSize, c->lumXInc,
                            srcW, dstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
@@ -1407,7 +1671,8 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                            get_local_pos(c, 0, 0, 0),
                            get_local_pos(c, 0, 0, 0))) < 0)
                 goto fail;
-            if ((ret = initFilter(&c->hChrFilter, &c->hChrFilterPos,
+            if ((ret = init_filter_cached(&c->cachedFilter[1],
+                           &c->hChrFilter, &c->hChrFilterPos,
                            &c->hChrFilterSize, c->chrXInc,
                            c->chrSrcW, c->chrDstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
@@ -1424,7 +1689,8 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
         const int filterAlign = X86_MMX(cpu_flags)     ? 2 :
                                 PPC_ALTIVEC(cpu_flags) ? 8 : 1;
 
-        if ((ret = initFilter(&c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
+        if ((ret = init_filter_cached(&c->cachedFilter[2],
+                       &c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
                        c->lumYInc, srcH, dstH, filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
                        cpu_flags, srcFilter->lumV, dstFilter->lumV,
@@ -1432,7 +1698,8 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                        get_local_pos(c, 0, 0, 1),
                        get_local_pos(c, 0, 0, 1))) < 0)
             goto fail;
-        if ((ret = initFilter(&c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
+        if ((ret = init_filter_cached(&c->cachedFilter[3],
+                       &c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
                        c->chrYInc, c->chrSrcH, c->chrDstH,
                        filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
@@ -1591,7 +1858,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     }
 
     c->swscale = ff_getSwsFunc(c);
-    return 0;
+    return init_band_contexts(c, srcFilter, dstFilter);
 fail: // FIXME replace things by appropriate error codes
     if (ret == RETCODE_USE_CASCADE)  {
         int tmpW = sqrt(srcW * (int64_t)dstW);
@@ -2009,6 +2276,10 @@ void sws_freeContext(SwsContext *c)
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
 
+    release_cached_filter(&c->cachedFilter[0], &c->hLumFilter, &c->hLumFilterPos);
+    release_cached_filter(&c->cachedFilter[1], &c->hChrFilter, &c->hChrFilterPos);
+    release_cached_filter(&c->cachedFilter[2], &c->vLumFilter, &c->vLumFilterPos);
+    release_cached_filter(&c->cachedFilter[3], &c->vChrFilter, &c->vChrFilterPos);
     av_freep(&c->vLumFilter);
     av_freep(&c->vChrFilter);
     av_freep(&c->hLumFilter);
@@ -2052,6 +2323,12 @@ void sws_freeContext(SwsContext *c)
     av_freep(&c->cascaded_tmp[0]);
     av_freep(&c->cascaded1_tmp[0]);
 
+    ff_sws_thread_free(c);
+    for (i = 0; i < c->nb_bands; i++)
+        sws_freeContext(c->band_context[i]);
+    av_freep(&c->band_context);
+    av_freep(&c->band_tail_buf);
+
     av_freep(&c->gamma);
     av_freep(&c->inv_gamma);
 
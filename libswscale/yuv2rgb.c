@@ -661,6 +661,10 @@ SwsFunc ff_yuv2rgb_get_func_ptr(SwsContext *c)
         t = ff_yuv2rgb_init_ppc(c);
     if (ARCH_X86)
         t = ff_yuv2rgb_init_x86(c);
+    if (ARCH_ARM)
+        t = ff_yuv2rgb_init_arm(c);
+    if (ARCH_AARCH64)
+        t = ff_yuv2rgb_init_aarch64(c);
 
     if (t)
         return t;
@@ -669,6 +673,11 @@ SwsFunc ff_yuv2rgb_get_func_ptr(SwsContext *c)
            "No accelerated colorspace conversion found from %s to %s.\n",
            av_get_pix_fmt_name(c->srcFormat), av_get_pix_fmt_name(c->dstFormat));
 
+    return ff_yuv2rgb_get_c_func_ptr(c);
+}
+
+SwsFunc ff_yuv2rgb_get_c_func_ptr(SwsContext *c)
+{
     switch (c->dstFormat) {
     case AV_PIX_FMT_BGR48BE:
     case AV_PIX_FMT_BGR48LE:
@@ -736,6 +745,47 @@ static void fill_gv_table(int table[256 + 2*YUVRGB_TABLE_HEADROOM], const int el
     }
 }
 
+/* Lowest and highest table entry used for a component, with the dither */
+static void table_range(int64_t range[2], int yoffs, int64_t c0, int64_t c1)
+{
+    range[0] = yoffs - (c0 >> 9) - (c1 >> 9) +
+               FFMIN(0, 255 * c0 >> 16) + FFMIN(0, 255 * c1 >> 16);
+    range[1] = yoffs - (c0 >> 9) - (c1 >> 9) + 255 + 7 +
+               FFMAX(0, 255 * c0 >> 16) + FFMAX(0, 255 * c1 >> 16);
+}
+
+static void fill_table_coeffs(int32_t coeffs[8], int64_t cy, int64_t oy,
+                              int yoffs, int64_t crv, int64_t cbu,
+                              int64_t cgu, int64_t cgv)
+{
+    const int64_t yb = -(384 << 16) - oy + 0x8000;
+    const int64_t v[8] = {
+        cy, crv, cbu, cgu, cgv,
+        yb + cy * (yoffs - (crv >> 9)),
+        yb + cy * (yoffs - (cgu >> 9) - (cgv >> 9)),
+        yb + cy * (yoffs - (cbu >> 9)),
+    };
+    int64_t range[3][2];
+    int i;
+
+    /* entries outside the 1024 of a table read its neighbours instead of
+     * following the linear function */
+    table_range(range[0], yoffs, crv, 0);
+    table_range(range[1], yoffs, cgu, cgv);
+    table_range(range[2], yoffs, cbu, 0);
+    for (i = 0; i < 3; i++)
+        if (range[i][0] < 0 || range[i][1] >= 1024)
+            break;
+    if (i < 3 || cy < 0 || FFABS(yb) + cy * 1024 > INT_MAX ||
+        FFMAX(FFMAX(FFABS(crv), FFABS(cbu)),
+              FFMAX(FFABS(cgu), FFABS(cgv))) * 255 > INT_MAX) {
+        memset(coeffs, 0, 8 * sizeof(*coeffs));
+        return;
+    }
+    for (i = 0; i < 8; i++)
+        coeffs[i] = v[i];
+}
+
 static uint16_t roundToInt16(int64_t f)
 {
     int r = (f + (1 << 15)) >> 16;
@@ -825,6 +875,9 @@ av_cold int ff_yuv2rgb_c_init_tables(SwsContext *c, const int inv_table[4],
     cgu = ((cgu << 16) + 0x8000) / FFMAX(cy, 1);
     cgv = ((cgv << 16) + 0x8000) / FFMAX(cy, 1);
 
+    fill_table_coeffs(c->yuv2rgb_table_coeffs, cy, oy, yoffs,
+                      crv, cbu, cgu, cgv);
+
     av_freep(&c->yuvTable);
 
 #define ALLOC_YUV_TABLE(x)          \
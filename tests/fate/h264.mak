@@ -188,8 +188,16 @@ FATE_H264_REINIT_TESTS := large_420_8-to-small_420_8                    \
                           small_420_9-to-small_420_8                    \
                           small_422_9-to-small_420_9                    \
 
+# CABAC pictures decoded one slice at a time with slice threads, so that
+# the macroblocks are reconstructed on the reconstruction thread
+FATE_H264_RECON_TESTS := caba1_sva_b                                    \
+                         caba3_sva_b                                    \
+                         caba3_toshiba_e                                \
+                         cabac_mot_frm0_full                            \
+
 FATE_H264  := $(FATE_H264:%=fate-h264-conformance-%)                    \
               $(FATE_H264_REINIT_TESTS:%=fate-h264-reinit-%)            \
+              $(FATE_H264_RECON_TESTS:%=fate-h264-recon-thread-%)       \
               fate-h264-extreme-plane-pred                              \
               fate-h264-lossless                                        \
 
@@ -394,4 +402,12 @@ fate-h264-interlace-crop:                         CMD = framecrc -i $(TARGET_SAM
 fate-h264-lossless:                               CMD = framecrc -i $(TARGET_SAMPLES)/h264/lossless.h264
 fate-h264-direct-bff:                             CMD = framecrc -i $(TARGET_SAMPLES)/h264/direct-bff.mkv
 
+fate-h264-recon-thread-caba1_sva_b:               CMD = framecrc -vsync drop -i $(TARGET_SAMPLES)/h264-conformance/CABA1_SVA_B.264
+fate-h264-recon-thread-caba3_sva_b:               CMD = framecrc -vsync drop -i $(TARGET_SAMPLES)/h264-conformance/CABA3_SVA_B.264
+fate-h264-recon-thread-caba3_toshiba_e:           CMD = framecrc -vsync drop -i $(TARGET_SAMPLES)/h264-conformance/CABA3_TOSHIBA_E.264
+fate-h264-recon-thread-cabac_mot_frm0_full:       CMD = framecrc -vsync drop -i $(TARGET_SAMPLES)/h264-conformance/camp_mot_frm0_full.26l
+fate-h264-recon-thread-%: REF = $(SRC_PATH)/tests/ref/fate/h264-conformance-$(@:fate-h264-recon-thread-%=%)
+fate-h264-recon-thread-%: THREADS = 2
+fate-h264-recon-thread-%: THREAD_TYPE = slice
+
 fate-h264-reinit-%:                               CMD = framecrc -i $(TARGET_SAMPLES)/h264/$(@:fate-h264-%=%).h264 -vf format=yuv444p10le,scale=w=352:h=288
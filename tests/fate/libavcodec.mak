@@ -8,6 +8,12 @@ fate-golomb: libavcodec/golomb-test$(EXESUF)
 fate-golomb: CMD = run libavcodec/golomb-test
 fate-golomb: REF = /dev/null
 
+FATE_LIBAVCODEC-$(CONFIG_HEVC_DECODER) += fate-hevcdsp
+fate-hevcdsp: libavcodec/hevcdsp-test$(EXESUF)
+fate-hevcdsp: CMD = run libavcodec/hevcdsp-test
+fate-hevcdsp: CMP = null
+fate-hevcdsp: REF = /dev/null
+
 FATE_LIBAVCODEC-$(CONFIG_IDCTDSP) += fate-idct8x8
 fate-idct8x8: libavcodec/dct-test$(EXESUF)
 fate-idct8x8: CMD = run libavcodec/dct-test -i
@@ -40,5 +46,11 @@ fate-api-flac: CMD = run libavcodec/api-flac-test
 fate-api-flac: CMP = null
 fate-api-flac: REF = /dev/null
 
+FATE_LIBAVCODEC-$(CONFIG_VP9_DECODER) += fate-vp9dsp
+fate-vp9dsp: libavcodec/vp9dsp-test$(EXESUF)
+fate-vp9dsp: CMD = run libavcodec/vp9dsp-test
+fate-vp9dsp: CMP = null
+fate-vp9dsp: REF = /dev/null
+
 FATE-$(CONFIG_AVCODEC) += $(FATE_LIBAVCODEC-yes)
 fate-libavcodec: $(FATE_LIBAVCODEC-yes)
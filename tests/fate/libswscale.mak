@@ -0,0 +1,14 @@
+FATE_LIBSWSCALE-$(HAVE_NEON) += fate-sws-neon
+fate-sws-neon: libswscale/neon-test$(EXESUF)
+fate-sws-neon: CMD = run libswscale/neon-test
+fate-sws-neon: CMP = null
+fate-sws-neon: REF = /dev/null
+
+FATE_LIBSWSCALE-$(HAVE_THREADS) += fate-sws-threads
+fate-sws-threads: libswscale/threads-test$(EXESUF)
+fate-sws-threads: CMD = run libswscale/threads-test
+fate-sws-threads: CMP = null
+fate-sws-threads: REF = /dev/null
+
+FATE-$(CONFIG_SWSCALE) += $(FATE_LIBSWSCALE-yes)
+fate-libswscale: $(FATE_LIBSWSCALE-yes)